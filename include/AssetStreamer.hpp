@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <algorithm>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "JobSystem.hpp"
+#include "Package.hpp"
+#include "AsyncReader.hpp"
+
+namespace re {
+
+	typedef uint32_t assetHandle_t;
+
+	enum assetState_e {
+		ASSET_STATE_UNLOADED,
+		ASSET_STATE_QUEUED,
+		ASSET_STATE_READING,
+		ASSET_STATE_DECODING,
+		ASSET_STATE_READY,
+		ASSET_STATE_UPLOADING,
+		ASSET_STATE_RESIDENT,
+		ASSET_STATE_FAILED
+	};
+
+	// explicit requests outrank anything computed from the view
+	constexpr float STREAMING_PRIORITY_REQUIRED = 1e30f;
+
+	inline float getStreamingPriority(float distance, bool visible) { return (visible ? 2.0f : 1.0f) / (1.0f + std::max(distance, 0.0f)); }
+
+	// runs on the job system, decodes blob in place or writes a different payload to output
+	typedef std::function<void(uint8_t* blob, size_t size, std::vector<uint8_t>& output)> assetDecoder_t;
+
+	// streams package entries into device local buffers:
+	//   highest priority reads first -> decode job -> copy on the transfer queue -> recordAcquireBarriers -> resident
+	// assets not touched for a frame are evicted least recently used first once the budget is reached
+	class AssetStreamer {
+	private:
+		struct asset_s {
+			packageEntry_s const* entry;
+			assetState_e state = ASSET_STATE_UNLOADED;
+			float priority = 0.0f;
+			uint64_t lastUsedFrame = 0;
+			VkDeviceSize stagingOffset = 0;
+			VkDeviceSize committedSize = 0;
+			std::vector<uint8_t> decoded;
+			re::buffer_ptr buffer;
+		};
+
+		struct batch_s {
+			VkCommandBuffer cmd;
+			re::fence_ptr fence;
+			std::vector<assetHandle_t> assets;
+			std::vector<std::pair<VkDeviceSize, VkDeviceSize>> staging;
+			bool busy;
+		};
+
+	public:
+		AssetStreamer(re::Device& device, re::JobSystem& jobs, re::Package& package, VkDeviceSize budget, VkDeviceSize stagingSize = 64ull << 20);
+		~AssetStreamer(void);
+
+		AssetStreamer(AssetStreamer const&) = delete;
+		AssetStreamer& operator=(AssetStreamer const&) = delete;
+
+		// raises the priority of an asset already known, queues it again if it was evicted
+		assetHandle_t request(std::string_view name, float priority = STREAMING_PRIORITY_REQUIRED);
+		void setPriority(assetHandle_t handle, float priority);
+		void touch(assetHandle_t handle);
+		void setDecoder(assetType_e type, assetDecoder_t decoder);
+
+		// once per frame, on the thread that submits to the device queues
+		void update(void);
+		// before newly uploaded assets are used, hands them over from the transfer queue
+		void recordAcquireBarriers(VkCommandBuffer cmd);
+
+		inline assetState_e getState(assetHandle_t handle) const { return assets[handle].state; }
+		inline re::buffer_ptr const& getBuffer(assetHandle_t handle) const { return assets[handle].buffer; }
+		inline VkDeviceSize getCommittedBytes(void) const { return committed; }
+		inline VkDeviceSize getBudget(void) const { return budget; }
+
+	private:
+		void onRead(assetHandle_t handle, bool ok);
+		void issueReads(void);
+		void submitUploads(void);
+		void retireBatches(void);
+		bool makeRoom(VkDeviceSize size, float priority);
+		void evict(assetHandle_t handle);
+		void release(assetHandle_t handle);
+		bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+		void freeStaging(VkDeviceSize offset, VkDeviceSize size);
+
+		re::Device& device;
+		re::JobSystem& jobs;
+		re::Package& package;
+		VkDeviceSize budget;
+		VkDeviceSize committed = 0;
+		uint64_t frame = 1;
+		uint32_t transferFamily;
+		uint32_t graphicsFamily;
+		VkQueue transferQueue;
+
+		std::deque<asset_s> assets;
+		std::unordered_map<packageEntry_s const*, assetHandle_t> lookup;
+		std::unordered_map<uint32_t, assetDecoder_t> decoders;
+		std::vector<assetHandle_t> acquires;
+		std::deque<std::pair<uint64_t, re::buffer_ptr>> graveyard;
+
+		std::mutex decodedMutex;
+		std::vector<assetHandle_t> decodedAssets;
+		// decoders that threw, update releases their staging memory and budget
+		std::vector<assetHandle_t> failedAssets;
+		jobCounter_t decodeJobs{ 0 };
+
+		re::buffer_ptr staging;
+		std::map<VkDeviceSize, VkDeviceSize> stagingFree;
+		re::commandPool_ptr commandPool;
+		std::vector<batch_s> batches;
+		uint32_t packageFile;
+		re::AsyncReader reader;
+	};
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include "Device.hpp"
+#include "Image.hpp"
+#include "CommandPool.hpp"
+
+namespace re {
+
+	// how one queue uses a shared image
+	struct queueUse_s {
+		VkImageLayout layout;
+		VkPipelineStageFlags stage;
+		VkAccessFlags access;
+	};
+
+	// runs compute work on the compute queue next to the graphics queue, a frame goes:
+	//   graphics: shadows (N) -> submitBeforeAcquire
+	//             recordAcquire, composite (N - 1), scene (N), recordRelease -> submitGraphics
+	//   compute:  beginCompute, post processing (N) -> submitCompute
+	// so the compute work of a frame overlaps the shadows of the next one: the submission carrying the acquire waits
+	// for the compute queue at every graphics stage of the shared images, with depth shared that includes the fragment
+	// tests, so the shadows must be their own submission before it or they wait for the compute work too
+	// shared images change queue family with release/acquire barrier pairs, submitGraphics and submitCompute add the
+	// timeline semaphore waits and signals those transfers need; without a separate compute family the same frame
+	// runs in order on the graphics queue
+	class AsyncCompute {
+	private:
+		enum owner_e {
+			OWNER_GRAPHICS,
+			OWNER_TO_COMPUTE,
+			OWNER_COMPUTE,
+			OWNER_TO_GRAPHICS
+		};
+
+		struct shared_s {
+			re::Image* image;
+			queueUse_s graphics;
+			queueUse_s compute;
+			owner_e owner;
+			// layout the pending transfer leaves, the acquire half must repeat the release half's transition
+			VkImageLayout releasedLayout;
+			bool discard;
+		};
+
+	public:
+		AsyncCompute(re::Device& device);
+		// waits for the submitted work
+		~AsyncCompute(void);
+
+		AsyncCompute(AsyncCompute const&) = delete;
+		AsyncCompute& operator=(AsyncCompute const&) = delete;
+
+		// the image must be owned by the graphics queue, discard drops its content on the first transfer
+		void share(re::Image& image, queueUse_s const& graphics, queueUse_s const& compute, bool discard = false);
+		// the image must be back on the graphics queue
+		void unshare(re::Image& image);
+
+		// graphics side, after the work producing the shared images, the next submitGraphics signals the compute queue
+		void recordRelease(VkCommandBuffer cmd);
+		// graphics side, first in its command buffer, before the shared images are used again, the next submitGraphics
+		// waits for the compute work
+		void recordAcquire(VkCommandBuffer cmd);
+		// graphics work of the frame not touching the shared images, without any wait on the compute queue,
+		// must come before this frame's recordAcquire and recordRelease
+		void submitBeforeAcquire(VkCommandBuffer cmd, std::vector<VkSemaphore> waits = {}, std::vector<VkPipelineStageFlags> waitStages = {},
+			std::vector<VkSemaphore> signals = {}, VkFence fence = nullptr);
+		void submitGraphics(VkCommandBuffer cmd, std::vector<VkSemaphore> waits = {}, std::vector<VkPipelineStageFlags> waitStages = {},
+			std::vector<VkSemaphore> signals = {}, VkFence fence = nullptr);
+
+		// compute command buffer of the frame, the shared images are acquired
+		VkCommandBuffer beginCompute(void);
+		// releases the shared images back and submits once the graphics queue released them
+		void submitCompute(void);
+
+		inline bool isAsync(void) const { return computeFamily != graphicsFamily; }
+		inline uint64_t getComputeValue(void) const { return computeValue; }
+
+	private:
+		void recordTransfers(VkCommandBuffer cmd, owner_e from, owner_e to, bool release);
+		void submit(VkCommandBuffer cmd, std::vector<VkSemaphore> waits, std::vector<VkPipelineStageFlags> waitStages,
+			std::vector<VkSemaphore> signals, VkFence fence, bool transfers);
+
+		re::Device& device;
+		uint32_t graphicsFamily;
+		uint32_t computeFamily;
+		VkQueue graphicsQueue;
+		VkQueue computeQueue;
+		re::TimelineSemaphore graphicsTimeline;
+		re::TimelineSemaphore computeTimeline;
+		uint64_t graphicsValue = 0;
+		uint64_t computeValue = 0;
+		bool pendingRelease = false;
+		bool pendingAcquire = false;
+		VkPipelineStageFlags pendingAcquireStages = 0;
+
+		re::commandPool_ptr pool;
+		std::vector<VkCommandBuffer> cmds;
+		VkCommandBuffer recording = nullptr;
+		std::vector<shared_s> images;
+	};
+}
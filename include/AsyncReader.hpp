@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+#if defined(__linux__) && __has_include(<liburing.h>)
+	#include <liburing.h>
+	#define RE_ASYNC_IO_URING
+#endif
+
+namespace re {
+
+	// positional file reads completed in the background, callbacks run on the thread calling poll
+	// io_uring when liburing is available, a small pool of blocking reader threads otherwise
+	class AsyncReader {
+	private:
+		struct request_s {
+			uint32_t file;
+			uint64_t offset;
+			size_t size;
+			size_t done;
+			uint8_t* destination;
+			std::function<void(bool)> callback;
+			bool ok;
+		};
+
+	public:
+		AsyncReader(uint32_t threadCount = 2, uint32_t queueDepth = 64);
+		~AsyncReader(void);
+
+		AsyncReader(AsyncReader const&) = delete;
+		AsyncReader& operator=(AsyncReader const&) = delete;
+
+		uint32_t open(std::string const& path);
+		// destination must stay valid until the callback ran
+		void read(uint32_t file, uint64_t offset, size_t size, void* destination, std::function<void(bool)> callback);
+		// runs the callbacks of finished reads, returns how many
+		size_t poll(void);
+
+		inline size_t getPendingCount(void) const { return inflight; }
+
+	private:
+		std::vector<intptr_t> files;
+		std::deque<request_s*> pending;
+		std::vector<request_s*> completed;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::vector<std::thread> workers;
+		size_t inflight = 0;
+		bool running = true;
+
+#if defined(RE_ASYNC_IO_URING)
+		void submitPending(void);
+
+		io_uring ring;
+		uint32_t queueDepth;
+		uint32_t submitted = 0;
+#else
+		void workerLoop(void);
+		bool readBlocking(request_s& request, intptr_t file);
+#endif
+	};
+}
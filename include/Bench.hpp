@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+namespace re {
+
+	// RathalosEngine bench <name>: times a system against its naive counterpart and prints both,
+	// an unknown name lists the benchmarks
+	void runBenchmark(std::string const& name);
+}
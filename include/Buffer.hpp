@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+
+#include "Device.hpp"
+
+namespace re {
+
+	class Buffer {
+	public:
+		Buffer(re::Device& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+		~Buffer(void);
+
+		Buffer(Buffer const&) = delete;
+		Buffer& operator=(Buffer const&) = delete;
+
+		void upload(void const* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		VkDescriptorBufferInfo getDescriptorInfo(void) const { return { ptr, 0, VK_WHOLE_SIZE }; }
+
+		VkBuffer ptr = nullptr;
+		VkDeviceMemory memory = nullptr;
+		VkDeviceSize size = 0;
+		void* mapped = nullptr;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<Buffer> buffer_ptr;
+}
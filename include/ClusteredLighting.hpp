@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+
+namespace re {
+
+	enum lightType_e : uint32_t {
+		LIGHT_TYPE_POINT = 0,
+		LIGHT_TYPE_SPOT = 1
+	};
+
+	// layout mirrors the std430 Light in shaders/clustered_lighting.glsl, positions and directions in world space
+	struct gpuLight_s {
+		glm::vec3 position;
+		float range;
+		glm::vec3 color;
+		uint32_t type;
+		glm::vec3 direction;
+		// cosines of the spot cone half angles, the light fades between them
+		float cosOuter;
+		float cosInner;
+		float pad[3];
+	};
+
+	// clustered forward lighting: the view frustum is split in screen tiles and exponential depth slices,
+	// a compute pass bins the lights into a compact list per cluster before the shading passes,
+	// which include shaders/clustered_lighting.glsl and loop only over the lights of their fragment's cluster
+	class ClusteredLighting {
+	private:
+		struct clusterInfo_s {
+			glm::mat4 view;
+			glm::vec4 projection;
+			glm::uvec4 grid;
+			glm::vec4 screen;
+			glm::vec4 slicing;
+		};
+
+	public:
+		// the index pool holds averageLightsPerCluster per cluster, crowded clusters past it drop lights
+		ClusteredLighting(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxLights, uint32_t averageLightsPerCluster = 32);
+		~ClusteredLighting(void);
+
+		ClusteredLighting(ClusteredLighting const&) = delete;
+		ClusteredLighting& operator=(ClusteredLighting const&) = delete;
+
+		// the pipeline follows edits of its shader until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		// reallocates the cluster buffers, the frames using the old ones must be done
+		void resize(VkExtent2D extent);
+		// kept until record writes them, the frames in flight keep reading the previous lights
+		void setLights(std::vector<gpuLight_s> const& lights);
+		// projection is a perspective, depths are positive distances
+		void setView(glm::mat4 const& view, glm::mat4 const& projection, float znear, float zfar);
+		// before the shading passes, the pending lights and view are written first, the lists are made visible to fragment shaders
+		void record(VkCommandBuffer cmd);
+
+		// set CLUSTERED_LIGHTING_SET of the shading pipelines, fragment stage
+		inline VkDescriptorSet getDescriptorSet(void) const { return set; }
+		inline glm::uvec3 getGridSize(void) const { return glm::uvec3(info.grid); }
+		inline uint32_t getLightCount(void) const { return info.grid.w; }
+
+		static constexpr uint32_t tileSize = 64;
+		static constexpr uint32_t depthSlices = 24;
+
+		re::buffer_ptr infoBuffer;
+		re::buffer_ptr lightBuffer;
+		re::buffer_ptr clusterBuffer;
+		re::buffer_ptr indexBuffer;
+		re::buffer_ptr counterBuffer;
+		re::descriptorSetLayout_ptr setLayout;
+
+	private:
+		void upload(VkCommandBuffer cmd);
+
+		re::Device& device;
+		uint32_t maxLights;
+		uint32_t averageLightsPerCluster;
+		clusterInfo_s info{};
+		std::vector<gpuLight_s> lights;
+		bool infoPending = true;
+		bool lightsPending = false;
+
+		re::shaderModule_ptr shader;
+		re::descriptorPool_ptr pool;
+		re::computePipeline_ptr pipeline;
+		re::ShaderWatcher* watcher = nullptr;
+		VkDescriptorSet set = nullptr;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+
+#include "Device.hpp"
+
+namespace re {
+
+	class CommandPool {
+	public:
+		CommandPool(re::Device& device, uint32_t queueFamily, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+		~CommandPool(void);
+
+		CommandPool(CommandPool const&) = delete;
+		CommandPool& operator=(CommandPool const&) = delete;
+
+		VkCommandBuffer allocate(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		void free(VkCommandBuffer cmd);
+
+		VkCommandPool ptr = nullptr;
+		uint32_t queueFamily;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<CommandPool> commandPool_ptr;
+
+	class Fence {
+	public:
+		Fence(re::Device& device, bool signaled = false);
+		~Fence(void);
+
+		Fence(Fence const&) = delete;
+		Fence& operator=(Fence const&) = delete;
+
+		inline bool signaled(void) const { return vkGetFenceStatus(device.ptr, ptr) == VK_SUCCESS; }
+		void wait(uint64_t timeout = UINT64_MAX);
+		void reset(void);
+
+		VkFence ptr = nullptr;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<Fence> fence_ptr;
+
+	// a counter the queues signal and wait on, the host can wait on it too
+	class TimelineSemaphore {
+	public:
+		TimelineSemaphore(re::Device& device, uint64_t initialValue = 0);
+		~TimelineSemaphore(void);
+
+		TimelineSemaphore(TimelineSemaphore const&) = delete;
+		TimelineSemaphore& operator=(TimelineSemaphore const&) = delete;
+
+		uint64_t getValue(void) const;
+		void wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+		void signal(uint64_t value);
+
+		VkSemaphore ptr = nullptr;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<TimelineSemaphore> timelineSemaphore_ptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "JobSystem.hpp"
+
+namespace re {
+
+	struct Frustum {
+		glm::vec4 planes[6];
+
+		static Frustum fromMatrix(glm::mat4 const& viewProjection);
+	};
+
+	struct SphereArray {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+
+		void push_back(glm::vec3 const& center, float r);
+		inline size_t size(void) const { return x.size(); }
+	};
+
+	struct AabbArray {
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+
+		void push_back(glm::vec3 const& min, glm::vec3 const& max);
+		inline size_t size(void) const { return minX.size(); }
+	};
+
+	// write the indices of the visible objects in [begin, end) to out, return how many were written
+	size_t cullSpheres(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* out);
+	size_t cullAabbs(Frustum const& frustum, AabbArray const& boxes, size_t begin, size_t end, uint32_t* out);
+	size_t cullSpheresScalar(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* out);
+	size_t cullAabbsScalar(Frustum const& frustum, AabbArray const& boxes, size_t begin, size_t end, uint32_t* out);
+
+	void cullSpheres(re::JobSystem& jobs, Frustum const& frustum, SphereArray const& spheres, std::vector<uint32_t>& visible);
+	void cullAabbs(re::JobSystem& jobs, Frustum const& frustum, AabbArray const& boxes, std::vector<uint32_t>& visible);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+
+namespace re {
+
+	class DescriptorSetLayout {
+	public:
+		DescriptorSetLayout(re::Device& device, std::vector<VkDescriptorSetLayoutBinding> const& bindings);
+		~DescriptorSetLayout(void);
+
+		DescriptorSetLayout(DescriptorSetLayout const&) = delete;
+		DescriptorSetLayout& operator=(DescriptorSetLayout const&) = delete;
+
+		VkDescriptorSetLayout ptr = nullptr;
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<DescriptorSetLayout> descriptorSetLayout_ptr;
+
+	class DescriptorPool {
+	public:
+		DescriptorPool(re::Device& device, uint32_t maxSets, std::vector<VkDescriptorPoolSize> const& sizes);
+		~DescriptorPool(void);
+
+		DescriptorPool(DescriptorPool const&) = delete;
+		DescriptorPool& operator=(DescriptorPool const&) = delete;
+
+		VkDescriptorSet allocate(re::DescriptorSetLayout& layout);
+
+		VkDescriptorPool ptr = nullptr;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<DescriptorPool> descriptorPool_ptr;
+
+	void writeDescriptor(re::Device& device, VkDescriptorSet set, uint32_t binding, VkDescriptorType type, re::Buffer& buffer);
+	void writeDescriptor(re::Device& device, VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkDescriptorImageInfo const& image);
+}
@@ -8,6 +8,9 @@
 
 namespace re {
 
+	// frames recorded ahead of the GPU, every per frame ring and deferred destruction is sized by it
+	constexpr uint64_t FRAMES_IN_FLIGHT = 3;
+
 	class PhysicalDevice {
 	private:
 		struct queueFamily_s {
@@ -34,7 +37,13 @@ namespace re {
 		VkPhysicalDevice ptr = nullptr;
 		VkPhysicalDeviceProperties properties{};
 		VkPhysicalDeviceFeatures features{};
+		VkPhysicalDeviceVulkan12Features features12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		VkPhysicalDeviceVulkan13Features features13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+		// before 1.3
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR };
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
 		std::vector<VkQueueFamilyProperties> queueFamilyProperties;
+		std::vector<VkExtensionProperties> extensions;
 
 		queueFamily_s queueFamily;
 		swapChainSupportDetails_s swapChainSupportDetails;
@@ -42,6 +51,11 @@ namespace re {
 		void getSwapChainSupportDetails(re::Surface& surface);
 		VkSurfaceFormatKHR getFormat(void);
 		VkPresentModeKHR getPresentMode(void);
+		uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags);
+		bool supportsBufferFormat(VkFormat format, VkFormatFeatureFlags features);
+		bool supportsImageFormat(VkFormat format, VkFormatFeatureFlags features);
+		bool supportsExtension(char const* name) const;
+		inline bool supportsDynamicRendering(void) const { return features13.dynamicRendering || dynamicRenderingFeatures.dynamicRendering; }
 	private:
 	};
 
@@ -80,17 +94,29 @@ namespace re {
 
 		VkDevice ptr = nullptr;
 		PhysicalDevice physicalDevice;
+		VkPhysicalDeviceFeatures2 enabledFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+		VkPhysicalDeviceVulkan12Features enabledFeatures12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		VkPhysicalDeviceVulkan13Features enabledFeatures13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR enabledDynamicRendering{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR };
 		queueHandles_s queueHandles;
+		// core in 1.3, VK_KHR_dynamic_rendering before, render passes without either
+		bool dynamicRendering = false;
+		PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
 		swapChain_ptr swapChain = nullptr;
 
 		void createSwapChain(void);
+		// the compute queue is from its own family and runs alongside the graphics queue
+		inline bool hasAsyncCompute(void) const { return queueHandles.compute && physicalDevice.queueFamily.compute != physicalDevice.queueFamily.graphics; }
 
 	private:
 		void pickPhysicalDevice(void);
 		std::vector<VkDeviceQueueCreateInfo> getDeviceQueueCreateInfos(re::PhysicalDevice& ref);
 		VkExtent2D getSwapChainExtent(void);
 		std::vector<char const*> getExtensions(void);
+		void getFeatures(void);
 		void getQueueHandles(void);
+		void getFunctions(void);
 		re::Instance& instance;
 		re::Surface& surface;
 		float queuePriority = 1.0f;
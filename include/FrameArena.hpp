@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+namespace re {
+
+	class LinearArena : public std::pmr::memory_resource {
+	public:
+		LinearArena(size_t blockSize);
+		~LinearArena(void);
+
+		LinearArena(LinearArena const&) = delete;
+		LinearArena& operator=(LinearArena const&) = delete;
+
+		void reset(void);
+
+		inline size_t used(void) const { return bytesUsed; }
+		inline size_t peak(void) const { return bytesPeak; }
+		inline size_t capacity(void) const { return bytesReserved; }
+
+	private:
+		struct block_s {
+			std::byte* data;
+			size_t size;
+		};
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override {}
+		bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+		void grow(size_t bytes, size_t alignment);
+
+		std::vector<block_s> blocks;
+		size_t current = 0;
+		std::byte* cursor = nullptr;
+		std::byte* end = nullptr;
+		size_t blockSize;
+		size_t bytesUsed = 0;
+		size_t bytesPeak = 0;
+		size_t bytesReserved = 0;
+	};
+
+	// one LinearArena per thread, all rewound together by reset() at frame end
+	class FrameArena {
+	public:
+		FrameArena(size_t blockSize = 1 << 20);
+		~FrameArena(void) {};
+
+		FrameArena(FrameArena const&) = delete;
+		FrameArena& operator=(FrameArena const&) = delete;
+
+		LinearArena& local(void);
+		inline std::pmr::memory_resource* resource(void) { return &local(); }
+
+		void reset(void);
+		size_t used(void);
+
+	private:
+		std::mutex mutex;
+		std::vector<std::unique_ptr<LinearArena>> arenas;
+		size_t blockSize;
+		uint64_t id;
+	};
+
+	template <typename T>
+	using frame_vector = std::pmr::vector<T>;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+#include "Culling.hpp"
+
+namespace re {
+
+	// layouts mirror the std430 structs in shaders/cull.comp
+	struct gpuInstance_s {
+		glm::vec4 sphere;
+		uint32_t mesh;
+		uint32_t material;
+		uint32_t lodCount;
+		uint32_t pad;
+	};
+
+	struct gpuMesh_s {
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		float lodError;
+	};
+
+	struct gpuMaterialRange_s {
+		uint32_t firstCommand;
+		uint32_t capacity;
+		uint32_t pad[2];
+	};
+
+	// frustum culls instances in a compute pass and emits one compacted indirect draw list per material
+	// an instance with lodCount > 1 uses meshes [mesh, mesh + lodCount), ordered from finest to coarsest
+	class GpuCulling {
+	private:
+		struct pushConstants_s {
+			glm::vec4 planes[6];
+			glm::vec4 lodCamera;
+			uint32_t instanceCount;
+		};
+
+	public:
+		GpuCulling(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxInstances, uint32_t maxMeshes, uint32_t maxMaterials);
+		~GpuCulling(void);
+
+		// the pipeline follows edits of its shader until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		void setMeshes(std::vector<gpuMesh_s> const& meshes);
+		void setInstances(std::vector<gpuInstance_s> const& instances);
+		// lodScale comes from re::getLodScale, 0 always draws the finest lod
+		void setLodView(glm::vec3 const& camera, float lodScale);
+
+		void record(VkCommandBuffer cmd, re::Frustum const& frustum);
+		void clearDraws(VkCommandBuffer cmd);
+		void finishDraws(VkCommandBuffer cmd);
+		void drawMaterial(VkCommandBuffer cmd, uint32_t material);
+		void draw(VkCommandBuffer cmd);
+
+		inline uint32_t getMaterialCount(void) const { return static_cast<uint32_t>(ranges.size()); }
+		inline uint32_t getInstanceCount(void) const { return instanceCount; }
+		inline bool usesDrawCount(void) const { return drawCount; }
+		inline glm::vec4 const& getLodCamera(void) const { return lodCamera; }
+
+		re::buffer_ptr instanceBuffer;
+		re::buffer_ptr meshBuffer;
+		re::buffer_ptr materialBuffer;
+		re::buffer_ptr commandBuffer;
+		re::buffer_ptr countBuffer;
+
+	private:
+		re::Device& device;
+		uint32_t maxInstances;
+		uint32_t maxMaterials;
+		uint32_t instanceCount = 0;
+		bool drawCount = false;
+		glm::vec4 lodCamera = glm::vec4(0.0f);
+		std::vector<gpuMaterialRange_s> ranges;
+
+		re::shaderModule_ptr shader;
+		re::descriptorSetLayout_ptr setLayout;
+		re::descriptorPool_ptr pool;
+		re::computePipeline_ptr pipeline;
+		re::ShaderWatcher* watcher = nullptr;
+		VkDescriptorSet set = nullptr;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include "Device.hpp"
+#include "Image.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+
+namespace re {
+
+	// max-depth pyramid built from the depth buffer, kept in VK_IMAGE_LAYOUT_GENERAL
+	class HiZBuffer {
+	private:
+		struct pushConstants_s {
+			int32_t sourceSize[2];
+			int32_t destinationSize[2];
+		};
+
+	public:
+		HiZBuffer(re::Device& device, re::PipelineLibrary& pipelines);
+		~HiZBuffer(void);
+
+		HiZBuffer(HiZBuffer const&) = delete;
+		HiZBuffer& operator=(HiZBuffer const&) = delete;
+
+		// the pipeline follows edits of its shader until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		// depthView must stay valid until the next resize, it is sampled in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		void resize(VkExtent2D depthExtent, VkImageView depthView);
+		void build(VkCommandBuffer cmd);
+
+		inline bool valid(void) const { return built; }
+		VkDescriptorImageInfo getDescriptorInfo(void) const { return { sampler, pyramid->view, VK_IMAGE_LAYOUT_GENERAL }; }
+
+		re::image_ptr pyramid;
+		VkSampler sampler = nullptr;
+
+	private:
+		re::Device& device;
+		VkExtent2D depthExtent{};
+		std::vector<VkDescriptorSet> sets;
+		bool initialized = false;
+		bool built = false;
+
+		re::shaderModule_ptr shader;
+		re::descriptorSetLayout_ptr setLayout;
+		re::descriptorPool_ptr pool;
+		re::computePipeline_ptr pipeline;
+		re::ShaderWatcher* watcher = nullptr;
+	};
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include "Device.hpp"
+
+namespace re {
+
+	class Image {
+	public:
+		Image(re::Device& device, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, uint32_t mipLevels = 1, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+		~Image(void);
+
+		Image(Image const&) = delete;
+		Image& operator=(Image const&) = delete;
+
+		void barrier(VkCommandBuffer cmd, VkImageLayout oldLayout, VkImageLayout newLayout,
+			VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess,
+			uint32_t baseMip = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS);
+
+		VkImage ptr = nullptr;
+		VkDeviceMemory memory = nullptr;
+		VkImageView view = nullptr;
+		std::vector<VkImageView> mipViews;
+		VkFormat format;
+		VkExtent2D extent;
+		uint32_t mipLevels;
+		VkImageAspectFlags aspect;
+		re::Device& device;
+	private:
+		VkImageView createView(uint32_t baseMip, uint32_t levelCount);
+	};
+
+	typedef std::shared_ptr<Image> image_ptr;
+}
@@ -16,6 +16,7 @@ namespace re {
 		~Instance(void);
 
 		VkInstance ptr;
+		uint32_t const apiVersion = VK_API_VERSION_1_3;
 
 	private:
 		std::vector<char const *> getLayers(void);
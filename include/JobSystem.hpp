@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <unordered_map>
+#include <exception>
+
+#include "Utils.hpp"
+#include "Pool.hpp"
+
+namespace re {
+
+	typedef std::atomic<uint32_t> jobCounter_t;
+
+	class JobSystem {
+	private:
+		struct job_s {
+			std::function<void(void)> function;
+			jobCounter_t* counter = nullptr;
+		};
+
+	public:
+		JobSystem(uint32_t threadCount = 0);
+		~JobSystem(void);
+
+		JobSystem(JobSystem const&) = delete;
+		JobSystem& operator=(JobSystem const&) = delete;
+
+		void submit(std::function<void(void)> function, jobCounter_t* counter = nullptr);
+		// runs queued jobs until counter reaches 0, then rethrows the first exception one of its jobs threw
+		void wait(jobCounter_t& counter);
+		void parallelFor(size_t count, size_t grain, std::function<void(size_t begin, size_t end)> const& function);
+
+		inline uint32_t getThreadCount(void) const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+	private:
+		void workerLoop(void);
+		bool runOne(void);
+		void execute(job_s* job);
+
+		std::vector<std::thread> workers;
+		std::deque<job_s*> queue;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool running = true;
+		re::Pool<job_s> jobs;
+		// first exception per counter until its wait
+		std::unordered_map<jobCounter_t*, std::exception_ptr> failures;
+	};
+}
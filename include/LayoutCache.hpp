@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+
+#include "Device.hpp"
+#include "Shader.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+
+namespace re {
+
+	// descriptor set and pipeline layouts deduplicated by content, so pipelines built from the same
+	// resource interface share one layout and stay compatible for descriptor binding
+	class LayoutCache {
+	public:
+		LayoutCache(re::Device& device);
+
+		LayoutCache(LayoutCache const&) = delete;
+		LayoutCache& operator=(LayoutCache const&) = delete;
+
+		re::descriptorSetLayout_ptr getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+		re::pipelineLayout_ptr getPipelineLayout(std::vector<re::descriptorSetLayout_ptr> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants);
+		// the reflections of all stages merged: one set layout per set, one push constant range for every stage using it
+		re::pipelineLayout_ptr getPipelineLayout(std::vector<re::ShaderModule const*> const& shaders);
+		// from a describe string, what a logged pipeline is rebuilt with
+		re::pipelineLayout_ptr getPipelineLayout(std::string const& description);
+
+		// the layout as text without spaces: [binding:type:count:stages,...] per set then |stages:offset:size,... per range,
+		// immutable samplers are left out
+		static std::string describe(re::PipelineLayout const& layout);
+
+		inline size_t getSetLayoutCount(void) const { return setLayoutCount; }
+		inline size_t getPipelineLayoutCount(void) const { return pipelineLayoutCount; }
+
+	private:
+		static uint64_t hashBindings(std::vector<VkDescriptorSetLayoutBinding> const& bindings);
+		static uint64_t hashPipelineLayout(std::vector<re::descriptorSetLayout_ptr> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants);
+
+		re::Device& device;
+		// hash collisions are resolved by comparing the content of each candidate
+		std::unordered_multimap<uint64_t, re::descriptorSetLayout_ptr> setLayouts;
+		std::unordered_multimap<uint64_t, re::pipelineLayout_ptr> pipelineLayouts;
+		size_t setLayoutCount = 0;
+		size_t pipelineLayoutCount = 0;
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace re {
+
+	// read-only view of a whole file, mmap on POSIX and MapViewOfFile on Windows
+	class MappedFile {
+	public:
+		MappedFile(std::string const& path);
+		~MappedFile(void);
+
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		// hints the kernel to start reading [offset, offset + size) into the page cache
+		void prefetch(size_t offset, size_t size) const;
+
+		inline uint8_t const* data(void) const { return static_cast<uint8_t const*>(mapping); }
+		inline size_t size(void) const { return length; }
+
+	private:
+		void* mapping = nullptr;
+		size_t length = 0;
+#if defined(_WIN32)
+		void* file = nullptr;
+		void* fileMapping = nullptr;
+#else
+		int fd = -1;
+#endif
+	};
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace re {
+
+	struct Vertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	struct Mesh {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// triangulated Wavefront obj, only positions, normals and uvs are read
+	Mesh loadObj(std::string const& path);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Mesh.hpp"
+
+namespace re {
+
+	// acmr: transformed vertices per triangle, atvr: transformed vertices per referenced vertex, 1 is ideal
+	struct vertexCacheStats_s {
+		float acmr;
+		float atvr;
+	};
+
+	// simulates a FIFO post-transform cache
+	vertexCacheStats_s analyzeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+	// Forsyth's linear-speed vertex cache optimisation, returns the reordered index buffer
+	std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount);
+	// splits a cache optimised index buffer into clusters and draws the outward facing ones first
+	// threshold bounds how much ACMR each cluster may lose against the input, 1.05 allows 5%
+	std::vector<uint32_t> optimizeOverdraw(re::Mesh const& mesh, std::vector<uint32_t> const& indices, float threshold = 1.05f);
+	// reorders the vertex buffer by first use in the index buffer, unused vertices are dropped
+	void optimizeVertexFetch(re::Mesh& mesh);
+
+	// runs the three passes in order, prints ACMR and ATVR before and after when verbose
+	void optimizeMesh(re::Mesh& mesh, bool verbose = false);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+
+namespace re {
+
+	// index-only level of detail, every LOD of a mesh shares its vertex buffer
+	// error is the geometric deviation from LOD 0 in mesh units
+	struct MeshLod {
+		std::vector<uint32_t> indices;
+		float error;
+	};
+
+	// quadric error metric edge collapse, stops at targetIndexCount or once a collapse would exceed targetError
+	// targetError and resultError are relative to the mesh extent, UV and normal seams are kept in place
+	std::vector<uint32_t> simplifyMesh(re::Mesh const& mesh, std::vector<uint32_t> const& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	// each level keeps about reduction of the previous one, the chain ends early when simplification stalls
+	std::vector<MeshLod> buildLodChain(re::Mesh const& mesh, uint32_t maxLods = 6, float reduction = 0.5f, float maxError = 0.05f);
+
+	// pixels of error per mesh unit at distance 1, divided by the tolerated pixels
+	float getLodScale(glm::mat4 const& projection, float viewportHeight, float thresholdPixels);
+	// coarsest lod whose error projects under the threshold, distance is from the camera to the bounding sphere surface
+	uint32_t selectLod(std::vector<MeshLod> const& lods, float distance, float lodScale);
+}
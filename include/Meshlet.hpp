@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+
+namespace re {
+
+	constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// layout mirrors the std430 struct in shaders/meshlet_cull.comp
+	struct Meshlet {
+		glm::vec4 sphere;
+		glm::vec4 cone;
+		uint32_t vertexOffset;
+		uint32_t triangleOffset;
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+	};
+
+	// vertices maps meshlet-local vertex ids to mesh vertices, triangles holds 3 local ids per triangle
+	struct MeshletData {
+		std::vector<Meshlet> meshlets;
+		std::vector<uint32_t> vertices;
+		std::vector<uint8_t> triangles;
+
+		std::vector<uint32_t> getIndices(void) const;
+	};
+
+	MeshletData buildMeshlets(re::Mesh const& mesh, uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+	void computeMeshletBounds(re::Mesh const& mesh, MeshletData& data);
+}
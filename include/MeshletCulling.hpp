@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+#include "Meshlet.hpp"
+#include "HiZBuffer.hpp"
+
+namespace re {
+
+	// layouts mirror the std430 structs in shaders/meshlet_cull.comp
+	struct gpuMeshlet_s {
+		glm::vec4 sphere;
+		glm::vec4 cone;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t pad;
+	};
+
+	struct gpuMeshletInstance_s {
+		glm::mat4 model;
+		uint32_t meshletOffset;
+		uint32_t meshletCount;
+		uint32_t pad[2];
+	};
+
+	// per-cluster frustum, normal cone and Hi-Z culling in a compute pass, every surviving meshlet becomes one indirect draw
+	// the index buffer is MeshletData::getIndices, firstInstance of each draw is the instance id
+	class MeshletCulling {
+	private:
+		struct viewData_s {
+			glm::mat4 view;
+			glm::mat4 projection;
+			glm::vec4 planes[6];
+			glm::vec4 camera;
+			glm::vec2 pyramidSize;
+			float znear;
+			float pad;
+		};
+
+		struct pushConstants_s {
+			uint32_t instanceCount;
+			uint32_t maxDraws;
+			uint32_t occlusion;
+		};
+
+	public:
+		MeshletCulling(re::Device& device, re::PipelineLibrary& pipelines, re::HiZBuffer& hzb, uint32_t maxMeshlets, uint32_t maxInstances, uint32_t maxDraws);
+		~MeshletCulling(void);
+
+		// the pipeline follows edits of its shader until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		// returns the offset of the mesh's meshlets, firstIndex and vertexOffset locate the mesh in the shared index and vertex buffers
+		uint32_t addMeshlets(re::MeshletData const& data, uint32_t firstIndex, int32_t vertexOffset);
+		void setInstances(std::vector<gpuMeshletInstance_s> const& instances);
+		void setView(glm::mat4 const& view, glm::mat4 const& projection, float znear);
+
+		void record(VkCommandBuffer cmd);
+		void draw(VkCommandBuffer cmd);
+
+		inline uint32_t getMeshletCount(void) const { return static_cast<uint32_t>(meshlets.size()); }
+		inline uint32_t getDrawCapacity(void) const { return drawCapacity; }
+
+		re::buffer_ptr meshletBuffer;
+		re::buffer_ptr instanceBuffer;
+		re::buffer_ptr commandBuffer;
+		re::buffer_ptr countBuffer;
+		re::buffer_ptr viewBuffer;
+
+	private:
+		re::Device& device;
+		re::HiZBuffer& hzb;
+		re::Image* boundPyramid = nullptr;
+		uint32_t maxMeshlets;
+		uint32_t maxInstances;
+		uint32_t maxDraws;
+		uint32_t instanceCount = 0;
+		uint32_t maxMeshletsPerInstance = 0;
+		uint32_t drawCapacity = 0;
+		bool drawCount = false;
+		std::vector<gpuMeshlet_s> meshlets;
+
+		re::shaderModule_ptr shader;
+		re::descriptorSetLayout_ptr setLayout;
+		re::descriptorPool_ptr pool;
+		re::computePipeline_ptr pipeline;
+		re::ShaderWatcher* watcher = nullptr;
+		VkDescriptorSet set = nullptr;
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+#include "GpuCulling.hpp"
+#include "HiZBuffer.hpp"
+
+namespace re {
+
+	// two-phase occlusion culling on top of GpuCulling, a frame goes:
+	//   recordEarly -> GpuCulling::draw -> HiZBuffer::build -> recordLate -> GpuCulling::draw (load the depth of the first pass)
+	// the early phase tests against the previous frame's pyramid, the late phase re-tests what it rejected against the new one
+	class OcclusionCulling {
+	private:
+		struct viewData_s {
+			glm::mat4 view;
+			glm::mat4 projection;
+			glm::vec4 planes[6];
+			glm::vec2 pyramidSize;
+			float znear;
+			uint32_t instanceCount;
+			glm::vec4 lodCamera;
+		};
+
+		struct pushConstants_s {
+			uint32_t phase;
+			uint32_t occlusion;
+		};
+
+	public:
+		OcclusionCulling(re::Device& device, re::PipelineLibrary& pipelines, re::GpuCulling& culling, re::HiZBuffer& hzb);
+		~OcclusionCulling(void);
+
+		// the pipeline follows edits of its shader until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		void setView(glm::mat4 const& view, glm::mat4 const& projection, float znear);
+		void recordEarly(VkCommandBuffer cmd);
+		void recordLate(VkCommandBuffer cmd);
+
+		re::buffer_ptr viewBuffer;
+		re::buffer_ptr visibilityBuffer;
+
+	private:
+		void recordPhase(VkCommandBuffer cmd, uint32_t phase);
+
+		re::Device& device;
+		re::GpuCulling& culling;
+		re::HiZBuffer& hzb;
+		re::Image* boundPyramid = nullptr;
+		bool visibilityCleared = false;
+
+		re::shaderModule_ptr shader;
+		re::descriptorSetLayout_ptr setLayout;
+		re::descriptorPool_ptr pool;
+		re::computePipeline_ptr pipeline;
+		re::ShaderWatcher* watcher = nullptr;
+		VkDescriptorSet set = nullptr;
+	};
+}
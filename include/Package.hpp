@@ -0,0 +1,197 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "MappedFile.hpp"
+#include "Buffer.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+
+namespace re {
+
+	#define PACKAGE_MAGIC 0x4b415052u
+	#define PACKAGE_VERSION 1
+	#define PACKAGE_ALIGNMENT 256
+
+	enum assetType_e : uint32_t {
+		ASSET_TYPE_RAW = 0,
+		ASSET_TYPE_MESH = 1,
+		ASSET_TYPE_TEXTURE = 2,
+		ASSET_TYPE_VIRTUAL_TEXTURE = 3
+	};
+
+	enum vertexFormat_e : uint32_t {
+		VERTEX_FORMAT_FLOAT = 0,
+		VERTEX_FORMAT_PACKED = 1
+	};
+
+	// .rpak layout: header, table of contents sorted by name hash, names, then blobs aligned to PACKAGE_ALIGNMENT
+	// entry offsets are from the start of the file, offsets inside a blob are from the start of the blob
+	struct packageHeader_s {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t alignment;
+		uint64_t tocOffset;
+		uint64_t namesOffset;
+		uint64_t fileSize;
+	};
+
+	struct packageEntry_s {
+		uint64_t nameHash;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		assetType_e type;
+		uint32_t pad;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// vertices are re::Vertex or re::PackedVertex, indices hold every lod back to back
+	struct packageMesh_s {
+		vertexFormat_e vertexFormat;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		float positionOffset[3];
+		float positionScale[3];
+		uint32_t verticesOffset;
+		uint32_t indicesOffset;
+		uint32_t lodsOffset;
+		uint32_t pad;
+	};
+
+	struct packageLod_s {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+		uint32_t pad;
+	};
+
+	// followed by mipLevels packageMip_s
+	struct packageTexture_s {
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		VkFormat format;
+	};
+
+	struct packageMip_s {
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// followed by mipLevels packageVirtualMip_s and tileCount packageTile_s
+	// a page covers tileSize - 2 * border texels of its mip, the tile around it repeats border texels of the neighbours
+	struct packageVirtualTexture_s {
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		VkFormat format;
+		uint32_t tileSize;
+		uint32_t border;
+		uint32_t tileCount;
+		uint32_t pad;
+	};
+
+	struct packageVirtualMip_s {
+		uint32_t width;
+		uint32_t height;
+		uint32_t pagesX;
+		uint32_t pagesY;
+		uint32_t firstTile;
+		uint32_t pad;
+	};
+
+	struct packageTile_s {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// pointers straight into the mapped file
+	struct meshView_s {
+		packageMesh_s const* header;
+		void const* vertices;
+		uint32_t const* indices;
+		packageLod_s const* lods;
+	};
+
+	struct textureView_s {
+		packageTexture_s const* header;
+		packageMip_s const* mips;
+		uint8_t const* data;
+	};
+
+	struct virtualTextureView_s {
+		packageVirtualTexture_s const* header;
+		packageVirtualMip_s const* mips;
+		packageTile_s const* tiles;
+		uint8_t const* data;
+	};
+
+	uint64_t hashName(std::string_view name);
+
+	// texture blob layout shared by the packer, Package::getTexture and the texture transcoder
+	std::vector<uint8_t> serializeTexture(re::TextureData const& texture);
+	textureView_s parseTexture(uint8_t const* blob, size_t size);
+	re::TextureData loadTexture(textureView_s const& view);
+
+	class Package {
+	public:
+		Package(std::string const& path);
+		~Package(void) {};
+
+		packageEntry_s const* find(std::string_view name) const;
+		std::string_view getName(packageEntry_s const& entry) const;
+		meshView_s getMesh(packageEntry_s const& entry) const;
+		textureView_s getTexture(packageEntry_s const& entry) const;
+		virtualTextureView_s getVirtualTexture(packageEntry_s const& entry) const;
+
+		void prefetch(packageEntry_s const& entry) const;
+		// the only copy a payload goes through, page cache to host visible staging memory
+		void copyTo(packageEntry_s const& entry, re::Buffer& staging, VkDeviceSize offset = 0) const;
+
+		inline uint8_t const* getData(packageEntry_s const& entry) const { return file.data() + entry.offset; }
+		inline uint32_t getEntryCount(void) const { return header->entryCount; }
+		inline packageEntry_s const* getEntries(void) const { return entries; }
+		inline std::string const& getPath(void) const { return path; }
+
+	private:
+		std::string path;
+		re::MappedFile file;
+		packageHeader_s const* header = nullptr;
+		packageEntry_s const* entries = nullptr;
+	};
+
+	class PackageWriter {
+	private:
+		struct pending_s {
+			std::string name;
+			assetType_e type;
+			std::vector<uint8_t> blob;
+		};
+
+	public:
+		void addBlob(std::string const& name, assetType_e type, std::vector<uint8_t> blob);
+		// the mesh is optimised, gets a lod chain and is quantized when asked before it is stored,
+		// verbose prints the vertex cache figures before and after the optimisation
+		void addMesh(std::string const& name, re::Mesh const& mesh, bool quantize = true, uint32_t maxLods = 4, bool verbose = false);
+		void addTexture(std::string const& name, re::TextureData const& texture);
+		// RGBA8 texture with its mips, cut in tiles and block compressed to format, mips stop at the first one fitting a page
+		void addVirtualTexture(std::string const& name, re::TextureData const& texture, VkFormat format, uint32_t tileSize = 128, uint32_t border = 4);
+		void write(std::string const& path) const;
+
+	private:
+		std::vector<pending_s> pending;
+	};
+
+	// packer entry point, .obj files become meshes, .tga block compressed textures (virtual textures for a "_vt" suffix)
+	// and anything else raw blobs
+	void packAssets(std::string const& output, std::vector<std::string> const& inputs);
+}
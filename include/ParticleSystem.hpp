@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+
+namespace re {
+
+	// layout mirrors the std430 Particle in shaders/particles.glsl, a slot with no lifetime left is on the dead list
+	struct gpuParticle_s {
+		glm::vec3 position;
+		float age;
+		glm::vec3 velocity;
+		float lifetime;
+		glm::vec4 color;
+		float size;
+		float drag;
+		float pad[2];
+	};
+
+	// spawn parameters of one emit call, positions and velocities in world space
+	struct particleEmitter_s {
+		glm::vec3 position{ 0.0f };
+		// particles spawn in a sphere of this radius around position
+		float radius = 0.0f;
+		glm::vec3 velocity{ 0.0f };
+		// speed of the random direction added to velocity
+		float spread = 0.0f;
+		glm::vec4 color{ 1.0f };
+		float size = 0.1f;
+		float drag = 0.0f;
+		float minLifetime = 1.0f;
+		float maxLifetime = 1.0f;
+	};
+
+	// gpu particles, nothing goes through the cpu after the emit requests:
+	//   emission pops free slots from a dead list, the simulation integrates every slot, pushes the expired ones back
+	//   and appends the live ones with their squared camera distance,
+	//   a bitonic sort orders that list back to front for blending, its dispatches are indirect and sized by the live count,
+	//   the draw is one indirect instanced quad per live particle, shaders/particle.vert reads the sorted list
+	class ParticleSystem {
+	private:
+		enum pass_e {
+			PASS_EMIT,
+			PASS_SIMULATE,
+			PASS_SORT_ARGS,
+			PASS_SORT,
+			PASS_COUNT
+		};
+
+		struct pass_s {
+			char const* path;
+			re::shaderModule_ptr shader;
+			re::computePipeline_ptr pipeline;
+		};
+
+		// layout mirrors the push constants in shaders/particles.glsl
+		struct pushConstants_s {
+			// emitter position, spawn radius
+			glm::vec4 position;
+			// emitter velocity, spread
+			glm::vec4 velocity;
+			glm::vec4 color;
+			// camera position, delta time
+			glm::vec4 camera;
+			// gravity, unused
+			glm::vec4 gravity;
+			float size;
+			float drag;
+			float minLifetime;
+			float maxLifetime;
+			uint32_t emitCount;
+			uint32_t seed;
+			uint32_t maxParticles;
+			// of the sort list, a power of two
+			uint32_t capacity;
+			// simulate: 0 simulate, 1 reset; sort: 0 local sort, 1 global step, 2 local merge
+			uint32_t phase;
+			// bitonic stage and step
+			uint32_t k;
+			uint32_t j;
+			uint32_t pad;
+		};
+
+		struct emission_s {
+			particleEmitter_s emitter;
+			uint32_t count;
+		};
+
+	public:
+		ParticleSystem(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxParticles);
+		~ParticleSystem(void);
+
+		ParticleSystem(ParticleSystem const&) = delete;
+		ParticleSystem& operator=(ParticleSystem const&) = delete;
+
+		// the pipelines follow edits of their shaders until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		// spawned by the next record, emissions past the free slots are dropped on the gpu
+		void emit(particleEmitter_s const& emitter, uint32_t count);
+		void setGravity(glm::vec3 const& gravity);
+		// the sort keys are distances to this position
+		void setCamera(glm::vec3 const& position);
+		// emits, simulates and sorts, the list and draw arguments are made visible to the draw
+		void record(VkCommandBuffer cmd, float deltaTime);
+		// inside a pass with a pipeline built from shaders/particle.vert and particle.frag bound, set 0 is getDescriptorSet
+		void draw(VkCommandBuffer cmd);
+
+		// vertex stage for particles and the sorted list
+		inline VkDescriptorSet getDescriptorSet(void) const { return set; }
+		inline uint32_t getMaxParticles(void) const { return maxParticles; }
+		inline uint32_t getSortDispatchCount(void) const { return static_cast<uint32_t>(sortSteps.size()); }
+
+		re::buffer_ptr particleBuffer;
+		re::buffer_ptr deadBuffer;
+		re::buffer_ptr listBuffer;
+		re::buffer_ptr counterBuffer;
+		// the VkDrawIndirectCommand then a VkDispatchIndirectCommand per sort dispatch
+		re::buffer_ptr argsBuffer;
+		re::descriptorSetLayout_ptr setLayout;
+
+	private:
+		re::Device& device;
+		uint32_t maxParticles;
+		uint32_t capacity;
+		uint32_t seed = 0;
+		bool initialized = false;
+		pushConstants_s constants{};
+		std::vector<emission_s> emissions;
+		// phase, k and j of every sort dispatch, the args pass sizes them in the same order
+		std::vector<glm::uvec3> sortSteps;
+
+		pass_s passes[PASS_COUNT];
+		re::descriptorPool_ptr pool;
+		re::ShaderWatcher* watcher = nullptr;
+		VkDescriptorSet set = nullptr;
+	};
+}
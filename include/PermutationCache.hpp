@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "Device.hpp"
+#include "Shader.hpp"
+#include "Pipeline.hpp"
+#include "JobSystem.hpp"
+
+namespace re {
+
+	// constant_id -> value of the feature switches of one variant, switches left out keep the shader's default
+	typedef std::map<uint32_t, uint32_t> permutation_t;
+
+	// the variants of a shader compiled once, features switched with specialization constants instead of defines so the
+	// driver folds the dead branches: every permutation gets its own pipeline, built on first use and found by a hash
+	// of its constant values
+	// safe to use from several threads, a permutation being built is waited for instead of built twice
+	class PermutationCache {
+	public:
+		PermutationCache(re::Device& device, re::shaderModule_ptr const& shader, re::pipelineLayout_ptr const& layout, VkPipelineCache cache = nullptr);
+
+		PermutationCache(PermutationCache const&) = delete;
+		PermutationCache& operator=(PermutationCache const&) = delete;
+
+		re::computePipeline_ptr get(permutation_t const& permutation);
+		bool contains(permutation_t const& permutation) const;
+
+		// builds the permutations ahead of their first use
+		void prewarm(std::vector<permutation_t> const& permutations);
+		// a job per permutation not built yet, counter reaches 0 once they all are, returns how many were submitted
+		size_t prewarm(re::JobSystem& jobs, re::jobCounter_t& counter, std::vector<permutation_t> const& permutations);
+		// a list written by record, returns how many permutations were built
+		size_t prewarm(std::string const& path);
+		// every permutation requested through get in order of first use, one per line as id=value pairs,
+		// prewarmed permutations nobody asked for are left out so the list only holds what is still used
+		void record(std::string const& path) const;
+		// the lines record writes
+		std::vector<std::string> getRecord(void) const;
+
+		// id=value pairs separated by spaces
+		static permutation_t parse(std::string const& pairs);
+
+		// permutations built, used or prewarmed
+		size_t size(void) const;
+		// permutations get had to build itself, each one a hitch prewarm will avoid on the next run
+		size_t getCompiledOnUse(void) const;
+
+	private:
+		std::vector<re::specializationConstant_s> resolve(permutation_t const& permutation) const;
+		re::computePipeline_ptr find(uint64_t hash, std::vector<re::specializationConstant_s> const& constants) const;
+		re::computePipeline_ptr build(uint64_t hash, std::vector<re::specializationConstant_s> const& constants);
+		re::computePipeline_ptr acquire(std::vector<re::specializationConstant_s> const& constants, bool use);
+		static uint64_t hashConstants(std::vector<re::specializationConstant_s> const& constants);
+
+		re::Device& device;
+		re::shaderModule_ptr shader;
+		re::pipelineLayout_ptr layout;
+		VkPipelineCache cache;
+		std::unordered_multimap<uint64_t, re::computePipeline_ptr> pipelines;
+		std::vector<re::computePipeline_ptr> used;
+		std::unordered_set<re::ComputePipeline const*> usedPipelines;
+		std::unordered_set<uint64_t> building;
+		size_t compiledOnUse = 0;
+		mutable std::mutex mutex;
+		std::condition_variable condition;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include "Device.hpp"
+#include "Shader.hpp"
+#include "Descriptor.hpp"
+
+namespace re {
+
+	class PipelineLayout {
+	public:
+		PipelineLayout(re::Device& device, std::vector<re::descriptorSetLayout_ptr> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants);
+		~PipelineLayout(void);
+
+		PipelineLayout(PipelineLayout const&) = delete;
+		PipelineLayout& operator=(PipelineLayout const&) = delete;
+
+		VkPipelineLayout ptr = nullptr;
+		std::vector<re::descriptorSetLayout_ptr> setLayouts;
+		std::vector<VkPushConstantRange> pushConstants;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<PipelineLayout> pipelineLayout_ptr;
+
+	// value of the specialization constant declared with layout(constant_id = id), 32 bit bool, int, uint or float bits
+	struct specializationConstant_s {
+		uint32_t id;
+		uint32_t value;
+	};
+
+	class ComputePipeline {
+	public:
+		ComputePipeline(re::Device& device, re::ShaderModule& shader, std::vector<VkDescriptorSetLayout> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants);
+		// the layout is shared, usually from re::LayoutCache
+		ComputePipeline(re::Device& device, re::ShaderModule& shader, re::pipelineLayout_ptr const& sharedLayout, std::vector<re::specializationConstant_s> const& constants = {}, VkPipelineCache cache = nullptr);
+		// same layout and constants as previous with a new shader, for hot reload, previous is only read
+		// and keeps owning its layout until the swap hands ownsLayout over
+		ComputePipeline(re::Device& device, re::ShaderModule& shader, re::ComputePipeline const& previous);
+		~ComputePipeline(void);
+
+		ComputePipeline(ComputePipeline const&) = delete;
+		ComputePipeline& operator=(ComputePipeline const&) = delete;
+
+		VkPipeline ptr = nullptr;
+		VkPipelineLayout layout = nullptr;
+		re::pipelineLayout_ptr sharedLayout;
+		std::vector<re::specializationConstant_s> constants;
+		// the layout was created by this pipeline and is destroyed with it
+		bool ownsLayout = false;
+		re::Device& device;
+	private:
+		void create(re::ShaderModule& shader, VkPipelineCache cache = nullptr);
+	};
+
+	typedef std::shared_ptr<ComputePipeline> computePipeline_ptr;
+}
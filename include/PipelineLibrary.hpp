@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include "Device.hpp"
+#include "Shader.hpp"
+#include "Pipeline.hpp"
+#include "LayoutCache.hpp"
+#include "JobSystem.hpp"
+#include "PermutationCache.hpp"
+
+namespace re {
+
+	// every pipeline the engine builds, a permutation cache per shader and layout, with their permutations logged across runs:
+	//   a pipeline built on first use is a hitch, the log is the record of every cache prefixed by its shader path and layout,
+	//   the next runs prewarm the logged permutations on the job system while loading and find them built,
+	//   the driver's VkPipelineCache is saved next to the log so prewarming itself mostly hits
+	// layouts are given by the systems sharing sets between passes or stages, otherwise they come from the shader
+	// reflection, both through the layout cache so a logged layout rebuilt by prewarm is the one a system asks for later
+	class PipelineLibrary {
+	public:
+		PipelineLibrary(re::Device& device, re::LayoutCache& layouts, std::string const& cachePath = "pipelines.cache", std::string const& logPath = "pipelines.log");
+		// saves, the prewarm jobs must be done
+		~PipelineLibrary(void);
+
+		PipelineLibrary(PipelineLibrary const&) = delete;
+		PipelineLibrary& operator=(PipelineLibrary const&) = delete;
+
+		// waits for the pipeline when a prewarm job is building it, a null layout is the shader's reflected one
+		re::computePipeline_ptr getCompute(std::string const& shaderPath, re::pipelineLayout_ptr const& layout = nullptr, re::permutation_t const& permutation = {});
+		re::PermutationCache& getPermutations(std::string const& shaderPath, re::pipelineLayout_ptr const& layout = nullptr);
+		// loaded once, shared by the caches of every layout
+		re::shaderModule_ptr getShader(std::string const& shaderPath);
+		// a job per logged permutation not built yet, counter reaches 0 once they all are, returns how many were submitted
+		size_t prewarm(re::JobSystem& jobs, re::jobCounter_t& counter);
+		void save(void);
+
+		inline VkPipelineCache getCache(void) const { return cache; }
+		// not thread safe, layouts are made while loading before the systems ask for their pipelines
+		inline re::LayoutCache& getLayouts(void) { return layouts; }
+		size_t getLoggedCount(void);
+		// pipelines getCompute had to build itself, each one a hitch prewarm will avoid on the next run
+		size_t getCompiledOnUse(void);
+
+	private:
+		std::vector<char> readCache(void);
+		void readLog(void);
+		void writeLog(void);
+
+		re::Device& device;
+		re::LayoutCache& layouts;
+		std::string cachePath;
+		std::string logPath;
+		VkPipelineCache cache = nullptr;
+
+		std::unordered_map<std::string, re::shaderModule_ptr> shaders;
+		// per shader path and layout description
+		std::unordered_map<std::string, std::unique_ptr<re::PermutationCache>> permutations;
+		// read from the log, kept for the shaders this run never loaded
+		std::map<std::string, std::vector<std::string>> logged;
+		std::mutex mutex;
+	};
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace re {
+
+	struct poolStats_s {
+		size_t slabs = 0;
+		size_t capacity = 0;
+		size_t live = 0;
+		size_t peak = 0;
+		size_t allocations = 0;
+		size_t deallocations = 0;
+		size_t refills = 0;
+		size_t flushes = 0;
+	};
+
+	inline std::atomic<uint64_t> poolCount{ 0 };
+
+	// slab allocator, each thread keeps a small free-list so the shared lock is only taken per batch
+	template <typename T, size_t SlabSize = 256>
+	class Pool {
+	private:
+		union slot_u {
+			slot_u* next;
+			alignas(T) std::byte storage[sizeof(T)];
+		};
+
+		struct cache_s {
+			uint64_t owner = 0;
+			slot_u* head = nullptr;
+			size_t count = 0;
+		};
+
+		static constexpr size_t batch = SlabSize / 4 ? SlabSize / 4 : 1;
+
+	public:
+		Pool(void) : id(++poolCount) {}
+		~Pool(void)
+		{
+			for (int i = 0; i < slabs.size(); i++)
+				::operator delete(slabs[i], std::align_val_t(alignof(slot_u)));
+		}
+
+		Pool(Pool const&) = delete;
+		Pool& operator=(Pool const&) = delete;
+
+		template <typename... Args>
+		T* create(Args&&... args)
+		{
+			slot_u* slot = allocateSlot();
+			try {
+				return new (slot->storage) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				releaseSlot(slot);
+				throw;
+			}
+		}
+
+		void destroy(T* object)
+		{
+			if (!object)
+				return;
+			object->~T();
+			releaseSlot(reinterpret_cast<slot_u*>(object));
+		}
+
+		poolStats_s getStats(void)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			poolStats_s stats;
+			stats.slabs = slabs.size();
+			stats.capacity = slabs.size() * SlabSize;
+			stats.live = live.load(std::memory_order_relaxed);
+			stats.peak = peak.load(std::memory_order_relaxed);
+			stats.allocations = allocations.load(std::memory_order_relaxed);
+			stats.deallocations = deallocations.load(std::memory_order_relaxed);
+			stats.refills = refills;
+			stats.flushes = flushes;
+			return stats;
+		}
+
+	private:
+		slot_u* allocateSlot(void)
+		{
+			cache_s& cache = threadCache();
+
+			if (!cache.head)
+				refill(cache);
+
+			slot_u* slot = cache.head;
+			cache.head = slot->next;
+			cache.count--;
+
+			size_t count = live.fetch_add(1, std::memory_order_relaxed) + 1;
+			size_t previous = peak.load(std::memory_order_relaxed);
+			while (count > previous && !peak.compare_exchange_weak(previous, count, std::memory_order_relaxed));
+			allocations.fetch_add(1, std::memory_order_relaxed);
+			return slot;
+		}
+
+		void releaseSlot(slot_u* slot)
+		{
+			cache_s& cache = threadCache();
+
+			slot->next = cache.head;
+			cache.head = slot;
+			cache.count++;
+
+			if (cache.count >= batch * 2)
+				flush(cache, batch);
+
+			live.fetch_sub(1, std::memory_order_relaxed);
+			deallocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void refill(cache_s& cache)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!freeList)
+				addSlab();
+
+			for (size_t i = 0; i < batch && freeList; i++) {
+				slot_u* slot = freeList;
+				freeList = slot->next;
+				slot->next = cache.head;
+				cache.head = slot;
+				cache.count++;
+			}
+			refills++;
+		}
+
+		void flush(cache_s& cache, size_t count)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			for (size_t i = 0; i < count && cache.head; i++) {
+				slot_u* slot = cache.head;
+				cache.head = slot->next;
+				cache.count--;
+				slot->next = freeList;
+				freeList = slot;
+			}
+			flushes++;
+		}
+
+		void addSlab(void)
+		{
+			slot_u* slab = static_cast<slot_u*>(::operator new(sizeof(slot_u) * SlabSize, std::align_val_t(alignof(slot_u))));
+			slabs.push_back(slab);
+
+			// thread the slab back to front so consecutive allocations walk forward in memory
+			for (size_t i = SlabSize; i-- > 0;) {
+				slab[i].next = freeList;
+				freeList = &slab[i];
+			}
+		}
+
+		cache_s& threadCache(void)
+		{
+			for (int i = 0; i < caches.size(); i++)
+				if (caches[i].owner == id)
+					return caches[i];
+			caches.push_back({ id, nullptr, 0 });
+			return *caches.rbegin();
+		}
+
+		static inline thread_local std::vector<cache_s> caches;
+
+		uint64_t const id;
+		std::mutex mutex;
+		std::vector<slot_u*> slabs;
+		slot_u* freeList = nullptr;
+		size_t refills = 0;
+		size_t flushes = 0;
+		std::atomic<size_t> live{ 0 };
+		std::atomic<size_t> peak{ 0 };
+		std::atomic<size_t> allocations{ 0 };
+		std::atomic<size_t> deallocations{ 0 };
+	};
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "Descriptor.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "ShaderWatcher.hpp"
+#include "AsyncCompute.hpp"
+
+namespace re {
+
+	// compute post processing of the hdr scene, recorded on the async compute queue:
+	//   ssao and the luminance histogram, auto exposure, bloom down and up the mip chain, then the tone map to output
+	// the hdr and depth images are shared with the compute queue, the graphics queue gets output back to composite it
+	class PostProcess {
+	private:
+		enum pass_e {
+			PASS_SSAO,
+			PASS_HISTOGRAM,
+			PASS_EXPOSURE,
+			PASS_BLOOM_DOWN,
+			PASS_BLOOM_UP,
+			PASS_TONE_MAP,
+			PASS_COUNT
+		};
+
+		struct pass_s {
+			char const* path;
+			re::shaderModule_ptr shader;
+			re::computePipeline_ptr pipeline;
+		};
+
+		// layout mirrors the push constants in shaders/post_process.glsl
+		struct pushConstants_s {
+			// projection[0][0], projection[1][1], projection[2][2], projection[3][2]
+			glm::vec4 projection;
+			glm::vec2 size;
+			float minLogLuminance;
+			float logLuminanceRange;
+			float adaptation;
+			float bloomThreshold;
+			float bloomIntensity;
+			float aoRadius;
+			float aoIntensity;
+			float exposureCompensation;
+			uint32_t mip;
+			float pad;
+		};
+
+	public:
+		struct settings_s {
+			float bloomThreshold = 1.0f;
+			float bloomIntensity = 0.05f;
+			// view space units
+			float aoRadius = 0.5f;
+			float aoIntensity = 1.0f;
+			// the histogram covers [minLogLuminance, minLogLuminance + logLuminanceRange] in log2 luminance
+			float minLogLuminance = -10.0f;
+			float logLuminanceRange = 12.0f;
+			// per second, higher adapts faster
+			float adaptationRate = 1.5f;
+			// in stops
+			float exposureCompensation = 0.0f;
+		};
+
+		PostProcess(re::Device& device, re::PipelineLibrary& pipelines, re::AsyncCompute& async);
+		~PostProcess(void);
+
+		PostProcess(PostProcess const&) = delete;
+		PostProcess& operator=(PostProcess const&) = delete;
+
+		// the pipelines follow edits of their shaders until destruction
+		void watchShaders(re::ShaderWatcher& watcher);
+
+		// hdr is rendered in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL and depth in VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		// both are sampled and stay valid until the next resize, which must happen while the graphics queue owns them
+		void resize(re::Image& hdr, re::Image& depth);
+		// the perspective the depth was rendered with, for ssao
+		void setProjection(glm::mat4 const& projection);
+		// on the command buffer from AsyncCompute::beginCompute
+		void record(VkCommandBuffer cmd, float deltaTime);
+
+		settings_s settings;
+
+		// tone mapped and sRGB encoded, sampled by the graphics queue in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		re::image_ptr output;
+		re::image_ptr bloom;
+		re::image_ptr occlusion;
+		re::buffer_ptr histogramBuffer;
+		re::buffer_ptr exposureBuffer;
+
+	private:
+		void dispatch(VkCommandBuffer cmd, pass_e pass, VkDescriptorSet set, pushConstants_s const& constants, uint32_t x, uint32_t y);
+		void barrier(VkCommandBuffer cmd);
+
+		re::Device& device;
+		re::AsyncCompute& async;
+		re::Image* hdr = nullptr;
+		re::Image* depth = nullptr;
+		glm::vec4 projection{ 1.0f };
+		bool initialized = false;
+
+		VkSampler linearSampler = nullptr;
+		VkSampler pointSampler = nullptr;
+		re::descriptorSetLayout_ptr setLayout;
+		re::descriptorSetLayout_ptr bloomSetLayout;
+		re::descriptorPool_ptr pool;
+		VkDescriptorSet set = nullptr;
+		std::vector<VkDescriptorSet> downSets;
+		std::vector<VkDescriptorSet> upSets;
+
+		pass_s passes[PASS_COUNT];
+		re::ShaderWatcher* watcher = nullptr;
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+#include "Device.hpp"
+
+namespace re {
+
+	// 16 bytes against 32 for re::Vertex
+	// position: unorm16 inside the mesh AABB, normal: octahedral snorm16, uv: half floats
+	struct PackedVertex {
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+	};
+
+	// position = positionOffset + unorm * positionScale, both go to the vertex shader
+	struct QuantizedMesh {
+		std::vector<PackedVertex> vertices;
+		std::vector<uint32_t> indices;
+		glm::vec3 positionOffset;
+		glm::vec3 positionScale;
+	};
+
+	// attribute formats for PackedVertex, packed falls back to one R32G32B32A32_UINT attribute decoded by hand
+	struct vertexInputLayout_s {
+		VkVertexInputBindingDescription binding;
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		char const* shaderPath;
+		bool packed;
+	};
+
+	QuantizedMesh quantizeMesh(re::Mesh const& mesh);
+	re::Mesh dequantizeMesh(QuantizedMesh const& mesh);
+
+	glm::i16vec2 encodeOctahedral(glm::vec3 normal);
+	glm::vec3 decodeOctahedral(glm::i16vec2 encoded);
+
+	vertexInputLayout_s getQuantizedVertexLayout(re::PhysicalDevice& physicalDevice, uint32_t binding = 0);
+}
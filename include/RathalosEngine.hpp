@@ -6,6 +6,11 @@
 #include "Instance.hpp"
 #include "Surface.hpp"
 #include "Device.hpp"
+#include "FrameArena.hpp"
+#include "JobSystem.hpp"
+#include "LayoutCache.hpp"
+#include "PipelineLibrary.hpp"
+#include "Scene.hpp"
 
 namespace re {
 
@@ -18,6 +23,11 @@ namespace re {
 		re::Instance instance;
 		re::Surface surface{ window, instance };
 		re::Device device{ instance, surface };
+		re::FrameArena frameArena;
+		re::JobSystem jobs;
+		re::LayoutCache layouts{ device };
+		re::PipelineLibrary pipelines{ device, layouts };
+		re::Scene scene;
 
 	private:
 
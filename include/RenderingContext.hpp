@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstdint>
+
+#include "Device.hpp"
+
+namespace re {
+
+	struct attachment_s {
+		VkImageView view = nullptr;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		// the layout of the image during the pass, transitions are the caller's barriers on both paths
+		VkImageLayout layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		VkClearValue clear{};
+	};
+
+	struct renderingInfo_s {
+		VkExtent2D extent{};
+		std::vector<re::attachment_s> colors;
+		// no depth attachment while its view is null
+		re::attachment_s depth;
+	};
+
+	// begins and ends passes with dynamic rendering when the device has it, no render pass or framebuffer objects then;
+	// otherwise render passes are cached by attachment description and framebuffers by views and extent,
+	// a swapchain rebuild only has to release the framebuffers of its old views
+	class RenderingContext {
+	private:
+		struct framebuffer_s {
+			VkFramebuffer ptr;
+			uint64_t lastUsedFrame;
+		};
+
+	public:
+		RenderingContext(re::Device& device);
+		~RenderingContext(void);
+
+		RenderingContext(RenderingContext const&) = delete;
+		RenderingContext& operator=(RenderingContext const&) = delete;
+
+		void begin(VkCommandBuffer cmd, re::renderingInfo_s const& info);
+		void end(VkCommandBuffer cmd);
+
+		// for graphics pipelines on the render pass path, null with dynamic rendering where the formats go to VkPipelineRenderingCreateInfo
+		VkRenderPass getRenderPass(re::renderingInfo_s const& info);
+		// before the views are destroyed, their framebuffers are destroyed once the frames using them retired
+		void releaseViews(std::vector<VkImageView> const& views);
+		// once per frame, also drops framebuffers left unused
+		void nextFrame(void);
+
+		inline bool isDynamic(void) const { return device.dynamicRendering; }
+		inline size_t getRenderPassCount(void) const { return renderPasses.size(); }
+		inline size_t getFramebufferCount(void) const { return framebuffers.size(); }
+
+	private:
+		void beginDynamic(VkCommandBuffer cmd, re::renderingInfo_s const& info);
+		void beginRenderPass(VkCommandBuffer cmd, re::renderingInfo_s const& info);
+		VkFramebuffer getFramebuffer(VkRenderPass renderPass, re::renderingInfo_s const& info);
+
+		re::Device& device;
+		uint64_t frame = 0;
+		// format, layout, load and store op of every attachment
+		std::map<std::vector<uint32_t>, VkRenderPass> renderPasses;
+		// render pass, views, extent
+		std::map<std::vector<uint64_t>, framebuffer_s> framebuffers;
+		std::deque<std::pair<uint64_t, VkFramebuffer>> graveyard;
+	};
+}
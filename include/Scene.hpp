@@ -0,0 +1,249 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <bitset>
+#include <memory>
+#include <unordered_map>
+#include <stdexcept>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include "Utils.hpp"
+#include "JobSystem.hpp"
+
+namespace re {
+
+	struct Entity {
+		uint32_t index = INVALID_UINT32;
+		uint32_t generation = 0;
+
+		inline bool operator==(Entity const& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(Entity const& other) const { return !(*this == other); }
+	};
+
+	constexpr uint32_t MAX_COMPONENTS = 64;
+	constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+	typedef std::bitset<MAX_COMPONENTS> signature_t;
+
+	struct componentInfo_s {
+		size_t size;
+		size_t alignment;
+		void (*moveConstruct)(void* dst, void* src);
+		void (*destroy)(void* ptr);
+	};
+
+	class ComponentRegistry {
+	public:
+		static uint32_t add(componentInfo_s const& info);
+		static componentInfo_s const& get(uint32_t id);
+	private:
+		static std::vector<componentInfo_s>& infos(void);
+	};
+
+	template <typename T>
+	uint32_t componentId(void)
+	{
+		static uint32_t const id = ComponentRegistry::add({
+			sizeof(T),
+			alignof(T),
+			[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+			[](void* ptr) { static_cast<T*>(ptr)->~T(); }
+		});
+		return id;
+	}
+
+	template <typename... C>
+	signature_t signatureOf(void)
+	{
+		signature_t signature;
+		(signature.set(componentId<C>()), ...);
+		return signature;
+	}
+
+	// components of an archetype live in fixed-size chunks, one tightly packed array per component
+	class Archetype {
+	public:
+		struct chunk_s {
+			std::byte* data = nullptr;
+			uint32_t count = 0;
+		};
+
+		Archetype(signature_t signature);
+		~Archetype(void);
+
+		Archetype(Archetype const&) = delete;
+		Archetype& operator=(Archetype const&) = delete;
+
+		inline bool has(uint32_t component) const { return signature.test(component); }
+		inline void* column(chunk_s const& chunk, uint32_t component) const { return chunk.data + offsets[component]; }
+		inline Entity* entities(chunk_s const& chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+		inline void* at(uint32_t chunk, uint32_t row, uint32_t component) const
+		{
+			return static_cast<std::byte*>(column(chunks[chunk], component)) + row * ComponentRegistry::get(component).size;
+		}
+
+		void allocateRow(Entity entity, uint32_t& chunk, uint32_t& row);
+		Entity removeRow(uint32_t chunk, uint32_t row);
+
+		signature_t const signature;
+		std::vector<uint32_t> components;
+		std::vector<chunk_s> chunks;
+		uint32_t capacity = 0;
+		size_t entityCount = 0;
+
+	private:
+		std::array<size_t, MAX_COMPONENTS> offsets{};
+		size_t chunkSize = CHUNK_SIZE;
+	};
+
+	class Scene {
+	private:
+		struct record_s {
+			Archetype* archetype = nullptr;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+			uint32_t generation = 0;
+		};
+
+	public:
+		Scene(void) {};
+		~Scene(void);
+
+		Scene(Scene const&) = delete;
+		Scene& operator=(Scene const&) = delete;
+
+		Entity create(void);
+		void destroy(Entity entity);
+		bool alive(Entity entity) const;
+		inline size_t size(void) const { return records.size() - freeIndices.size(); }
+
+		template <typename... C>
+		Entity create(C... components)
+		{
+			Entity entity = allocate();
+			record_s& record = records[entity.index];
+			Archetype& archetype = getArchetype(signatureOf<C...>());
+
+			archetype.allocateRow(entity, record.chunk, record.row);
+			record.archetype = &archetype;
+			(new (archetype.at(record.chunk, record.row, componentId<C>())) C(std::move(components)), ...);
+			return entity;
+		}
+
+		template <typename T>
+		void add(Entity entity, T component)
+		{
+			uint32_t id = componentId<T>();
+			record_s& record = getRecord(entity);
+
+			if (record.archetype->has(id)) {
+				*static_cast<T*>(record.archetype->at(record.chunk, record.row, id)) = std::move(component);
+				return;
+			}
+
+			signature_t signature = record.archetype->signature;
+			move(entity, getArchetype(signature.set(id)));
+			new (record.archetype->at(record.chunk, record.row, id)) T(std::move(component));
+		}
+
+		template <typename T>
+		void remove(Entity entity)
+		{
+			uint32_t id = componentId<T>();
+			record_s& record = getRecord(entity);
+
+			if (!record.archetype->has(id))
+				return;
+
+			signature_t signature = record.archetype->signature;
+			move(entity, getArchetype(signature.reset(id)));
+		}
+
+		template <typename T>
+		T* get(Entity entity)
+		{
+			uint32_t id = componentId<T>();
+			record_s& record = getRecord(entity);
+
+			if (!record.archetype->has(id))
+				return nullptr;
+			return static_cast<T*>(record.archetype->at(record.chunk, record.row, id));
+		}
+
+		template <typename T>
+		inline bool has(Entity entity) { return get<T>(entity) != nullptr; }
+
+		// fn(uint32_t count, Entity const* entities, C*... arrays), called once per matching chunk
+		template <typename... C, typename F>
+		void eachChunk(F&& fn)
+		{
+			signature_t required = signatureOf<C...>();
+
+			for (int i = 0; i < archetypes.size(); i++) {
+				Archetype& archetype = *archetypes[i];
+				if ((archetype.signature & required) != required)
+					continue;
+				for (int j = 0; j < archetype.chunks.size(); j++) {
+					Archetype::chunk_s const& chunk = archetype.chunks[j];
+					fn(chunk.count, archetype.entities(chunk), static_cast<C*>(archetype.column(chunk, componentId<C>()))...);
+				}
+			}
+		}
+
+		// fn(Entity, C&...), called once per matching entity
+		template <typename... C, typename F>
+		void each(F&& fn)
+		{
+			eachChunk<C...>([&fn](uint32_t count, Entity const* entities, C*... arrays) {
+				for (uint32_t i = 0; i < count; i++)
+					fn(entities[i], arrays[i]...);
+			});
+		}
+
+		// same as eachChunk but chunks are spread over the job system, no structural change allowed inside
+		template <typename... C, typename F>
+		void parallelEachChunk(re::JobSystem& jobs, F&& fn)
+		{
+			signature_t required = signatureOf<C...>();
+			std::vector<std::pair<Archetype*, uint32_t>> matches;
+
+			for (int i = 0; i < archetypes.size(); i++)
+				if ((archetypes[i]->signature & required) == required)
+					for (uint32_t j = 0; j < archetypes[i]->chunks.size(); j++)
+						matches.push_back({ archetypes[i], j });
+
+			jobs.parallelFor(matches.size(), 1, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					Archetype& archetype = *matches[i].first;
+					Archetype::chunk_s const& chunk = archetype.chunks[matches[i].second];
+					fn(chunk.count, archetype.entities(chunk), static_cast<C*>(archetype.column(chunk, componentId<C>()))...);
+				}
+			});
+		}
+
+		template <typename... C, typename F>
+		void parallelEach(re::JobSystem& jobs, F&& fn)
+		{
+			parallelEachChunk<C...>(jobs, [&fn](uint32_t count, Entity const* entities, C*... arrays) {
+				for (uint32_t i = 0; i < count; i++)
+					fn(entities[i], arrays[i]...);
+			});
+		}
+
+	private:
+		Entity allocate(void);
+		record_s& getRecord(Entity entity);
+		Archetype& getArchetype(signature_t signature);
+		void move(Entity entity, Archetype& destination);
+		void detach(record_s& record);
+
+		std::vector<record_s> records;
+		std::vector<uint32_t> freeIndices;
+		std::unordered_map<signature_t, std::unique_ptr<Archetype>> archetypeMap;
+		std::vector<Archetype*> archetypes;
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "Device.hpp"
+#include "ShaderReflection.hpp"
+
+namespace re {
+
+	#define SHADER_PATH "shaders/"
+
+	class ShaderModule {
+	public:
+		ShaderModule(re::Device& device, std::string const& path);
+		~ShaderModule(void);
+
+		ShaderModule(ShaderModule const&) = delete;
+		ShaderModule& operator=(ShaderModule const&) = delete;
+
+		static std::vector<uint32_t> readFile(std::string const& path);
+
+		VkShaderModule ptr = nullptr;
+		std::vector<uint32_t> code;
+		uint64_t hash = 0;
+		re::ShaderReflection reflection;
+		re::Device& device;
+	private:
+	};
+
+	typedef std::shared_ptr<ShaderModule> shaderModule_ptr;
+}
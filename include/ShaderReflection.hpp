@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace re {
+
+	#define REFLECTION_MAGIC 0x4c464552u
+	#define REFLECTION_VERSION 2
+
+	struct shaderBinding_s {
+		uint32_t set;
+		uint32_t binding;
+		VkDescriptorType type;
+		uint32_t count;
+		VkShaderStageFlags stages;
+	};
+
+	struct shaderVertexInput_s {
+		uint32_t location;
+		VkFormat format;
+	};
+
+	struct shaderSpecConstant_s {
+		uint32_t id;
+		uint32_t size;
+		uint32_t defaultValue;
+	};
+
+	// what a SPIR-V module expects from its pipeline, read straight from the SPIR-V instructions
+	struct ShaderReflection {
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+		uint32_t pushConstantSize = 0;
+		uint32_t localSize[3] = { 1, 1, 1 };
+		std::vector<shaderBinding_s> bindings;
+		std::vector<shaderVertexInput_s> vertexInputs;
+		std::vector<shaderSpecConstant_s> specConstants;
+
+		static ShaderReflection reflect(std::vector<uint32_t> const& code);
+
+		// <spv>.refl next to the module, keyed by a hash of the code so a recompiled module is reflected again
+		static bool loadCache(std::string const& path, uint64_t codeHash, ShaderReflection& reflection);
+		static void saveCache(std::string const& path, uint64_t codeHash, ShaderReflection const& reflection);
+	};
+
+	uint64_t hashCode(std::vector<uint32_t> const& code);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+
+#include "Device.hpp"
+#include "Shader.hpp"
+#include "Pipeline.hpp"
+
+#if defined(__linux__)
+	#define RE_SHADER_WATCH_INOTIFY
+#endif
+
+namespace re {
+
+	// recompiles the shaders of a directory when their source changes and reloads the pipelines built from them:
+	//   a background thread waits for changes (inotify on linux, modification times polled otherwise), runs the compiler
+	//   and builds the new shader modules and pipelines,
+	//   update only swaps them in at the frame boundary and the replaced ones are destroyed once their frames retired,
+	//   nothing waits for the device
+	class ShaderWatcher {
+	public:
+		// applied by update on the frame thread
+		typedef std::function<void(void)> reloadSwap_t;
+		// runs on the watcher thread, builds what the reload needs and returns its swap, an empty one when the code is identical
+		typedef std::function<reloadSwap_t(void)> reloadCallback_t;
+
+		ShaderWatcher(std::string const& directory = SHADER_PATH, std::string const& compiler = "glslc --target-env=vulkan1.2");
+		~ShaderWatcher(void);
+
+		ShaderWatcher(ShaderWatcher const&) = delete;
+		ShaderWatcher& operator=(ShaderWatcher const&) = delete;
+
+		// callback runs on the watcher thread after the SPIR-V at path changed, until the owner is removed
+		void add(std::string const& path, void const* owner, reloadCallback_t callback);
+		void remove(void const* owner);
+		// reloads shader and rebuilds pipeline with the same layout, the shader interface must not change,
+		// shader and pipeline are only written by update
+		void watch(re::Device& device, std::string const& path, void const* owner, re::shaderModule_ptr& shader, re::computePipeline_ptr& pipeline);
+		// keeps resource alive until the frames that may use it retired
+		void retire(std::shared_ptr<void> resource);
+
+		// once per frame at the frame boundary, returns how many shaders were reloaded
+		size_t update(void);
+
+	private:
+		struct watch_s {
+			std::string path;
+			void const* owner;
+			reloadCallback_t callback;
+			bool active = true;
+		};
+
+		struct swap_s {
+			std::shared_ptr<watch_s> watch;
+			reloadSwap_t apply;
+		};
+
+		void watchLoop(void);
+		void scan(std::map<std::string, std::filesystem::file_time_type>& times, std::set<std::string>& changed);
+		void process(std::set<std::string> const& changed);
+		void reload(std::string const& path);
+		bool compile(std::filesystem::path const& source);
+		std::vector<std::filesystem::path> getDependents(std::string const& name);
+		static std::string normalize(std::string const& path);
+
+		std::filesystem::path directory;
+		std::string compiler;
+		std::deque<std::pair<uint64_t, std::shared_ptr<void>>> graveyard;
+		uint64_t frame = 0;
+		// modules the compiler wrote and their write times, their own change events are not reloads
+		std::map<std::string, std::filesystem::file_time_type> written;
+
+		std::vector<std::shared_ptr<watch_s>> watches;
+		std::vector<swap_s> swaps;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::thread thread;
+		bool running = true;
+#if defined(RE_SHADER_WATCH_INOTIFY)
+		int notify = -1;
+#endif
+	};
+}
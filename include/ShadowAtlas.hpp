@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <set>
+#include <functional>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "Descriptor.hpp"
+#include "RenderingContext.hpp"
+
+namespace re {
+
+	// layout mirrors the std430 Shadow in shaders/shadow_atlas.glsl
+	struct gpuShadow_s {
+		glm::mat4 viewProjection;
+		// atlas uv offset then scale of the tile
+		glm::vec4 rect;
+	};
+
+	// records the casters of a shadow with its view, viewport and scissor are set to its tile
+	typedef std::function<void(VkCommandBuffer cmd, uint32_t shadow, glm::mat4 const& viewProjection)> shadowDraw_t;
+
+	// every shadow map packed in one depth atlas, square power of two tiles from a buddy allocator
+	// static casters are rendered to a cache atlas only when the shadow's view or the static geometry it sees changed,
+	// each frame the cached tiles are copied to the sampled atlas and only the dynamic casters are drawn over them,
+	// a tile without dynamic casters this frame and the last one is left as it is
+	class ShadowAtlas {
+	private:
+		struct shadow_s {
+			bool used = false;
+			uint32_t level = 0;
+			glm::uvec2 offset{};
+			glm::mat4 viewProjection{ 1.0f };
+			bool staticDirty = true;
+			bool dynamicCasters = true;
+			// the atlas tile still holds last frame's dynamic casters
+			bool dynamicDrawn = false;
+			// its gpuShadow_s is written by the next record
+			bool uploadPending = true;
+		};
+
+	public:
+		// size is a power of two, tiles go from the whole atlas down to minTileSize
+		ShadowAtlas(re::Device& device, re::RenderingContext& rendering, uint32_t size = 4096, uint32_t maxShadows = 256,
+			uint32_t minTileSize = 128, VkFormat format = VK_FORMAT_D32_SFLOAT);
+		~ShadowAtlas(void);
+
+		ShadowAtlas(ShadowAtlas const&) = delete;
+		ShadowAtlas& operator=(ShadowAtlas const&) = delete;
+
+		// resolution is rounded up to a power of two, a full atlas hands out a smaller tile, throws when nothing fits
+		uint32_t add(uint32_t resolution);
+		void remove(uint32_t shadow);
+		// the static cache is re-rendered when the view differs
+		void setView(uint32_t shadow, glm::mat4 const& viewProjection);
+		// shadows without dynamic casters only show their cache
+		void setDynamicCasters(uint32_t shadow, bool any);
+		void invalidate(uint32_t shadow);
+		// static geometry in the box moved or changed, the shadows that see it re-render their cache
+		void invalidateStatic(glm::vec3 const& min, glm::vec3 const& max);
+		void invalidateStatic(void);
+
+		// the atlas is left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL for the shading passes,
+		// shadowBuffer is written in cmd so the frames still in flight keep reading their own views
+		void record(VkCommandBuffer cmd, shadowDraw_t const& drawStatic, shadowDraw_t const& drawDynamic);
+
+		// both passes share it, for the depth pipelines of the casters
+		re::renderingInfo_s getRenderingInfo(void) const;
+		// set SHADOW_ATLAS_SET of the shading pipelines
+		inline VkDescriptorSet getDescriptorSet(void) const { return set; }
+		inline uint32_t getResolution(uint32_t shadow) const { return size >> shadows[shadow].level; }
+		inline size_t getStaticRenders(void) const { return staticRenders; }
+		inline size_t getDynamicRenders(void) const { return dynamicRenders; }
+
+		// practical split scheme, count + 1 view depths from znear to zfar, lambda blends logarithmic and uniform splits
+		static std::vector<float> cascadeSplits(float znear, float zfar, uint32_t count, float lambda = 0.75f);
+		// ortho view projection of the slice [splitNear, splitFar] of a perspective camera, lightDirection points away from the light
+		// the bounds keep their size as the camera turns and move by whole texels, the shadow edges do not shimmer
+		static glm::mat4 stableCascade(glm::mat4 const& view, float fovY, float aspect, float splitNear, float splitFar,
+			glm::vec3 const& lightDirection, uint32_t resolution, float casterDistance);
+
+		re::image_ptr atlas;
+		re::image_ptr cache;
+		re::buffer_ptr shadowBuffer;
+		re::descriptorSetLayout_ptr setLayout;
+		VkSampler sampler = nullptr;
+
+	private:
+		bool allocateTile(uint32_t level, glm::uvec2& offset);
+		void freeTile(uint32_t level, glm::uvec2 offset);
+		void upload(VkCommandBuffer cmd);
+		void render(VkCommandBuffer cmd, re::Image& target, std::vector<uint32_t> const& list, shadowDraw_t const& draw, bool clear);
+
+		re::Device& device;
+		re::RenderingContext& rendering;
+		uint32_t size;
+		uint32_t levelCount;
+		// free tiles of each level, level 0 is the whole atlas
+		std::vector<std::set<std::pair<uint32_t, uint32_t>>> freeTiles;
+		std::vector<shadow_s> shadows;
+		std::vector<uint32_t> freeShadows;
+		bool atlasInitialized = false;
+		bool cacheInitialized = false;
+		size_t staticRenders = 0;
+		size_t dynamicRenders = 0;
+
+		re::descriptorPool_ptr pool;
+		VkDescriptorSet set = nullptr;
+	};
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace re {
+
+	// CPU side texture, mips[0] is the full resolution level
+	struct TextureData {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+		std::vector<std::vector<uint8_t>> mips;
+	};
+
+	// uncompressed or RLE truecolor tga, always expanded to RGBA8
+	TextureData loadTga(std::string const& path);
+	// box filtered chain down to 1x1, RGBA8 only
+	void generateMips(TextureData& texture);
+
+	inline uint32_t getMipSize(uint32_t size, uint32_t level) { return size >> level ? size >> level : 1; }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+#include "Texture.hpp"
+#include "Package.hpp"
+#include "Device.hpp"
+
+namespace re {
+
+	enum textureClass_e {
+		TEXTURE_CLASS_COLOR,
+		TEXTURE_CLASS_COLOR_ALPHA,
+		TEXTURE_CLASS_GRAYSCALE,
+		TEXTURE_CLASS_NORMAL
+	};
+
+	// every block covers 4x4 texels, pixels are 16 RGBA8 values in row order
+	void encodeBC1(uint8_t const pixels[64], uint8_t block[8]);
+	void encodeBC3(uint8_t const pixels[64], uint8_t block[16]);
+	void encodeBC4(uint8_t const pixels[64], uint8_t block[8], int channel = 0);
+	void encodeBC5(uint8_t const pixels[64], uint8_t block[16]);
+	// mode 6 only, one subset with RGBA endpoints and 4-bit indices
+	void encodeBC7(uint8_t const pixels[64], uint8_t block[16]);
+
+	void decodeBC1(uint8_t const block[8], uint8_t pixels[64]);
+	void decodeBC3(uint8_t const block[16], uint8_t pixels[64]);
+	void decodeBC4(uint8_t const block[8], uint8_t pixels[64], int channel = 0);
+	void decodeBC5(uint8_t const block[16], uint8_t pixels[64]);
+	// blocks in other modes than 6 decode to magenta
+	void decodeBC7(uint8_t const block[16], uint8_t pixels[64]);
+
+	bool isBlockCompressed(VkFormat format);
+	uint32_t getBlockBytes(VkFormat format);
+
+	textureClass_e classifyTexture(re::TextureData const& texture, bool normalMap);
+	// BC1 for opaque color, BC7 (or BC3) with alpha, BC4 for grayscale data read from .r and BC5 for normal maps
+	VkFormat getCompressedFormat(textureClass_e textureClass, bool srgb, bool preferBC7 = true);
+
+	// every mip of an RGBA8 texture is encoded
+	re::TextureData compressTexture(re::TextureData const& texture, VkFormat format);
+	// CPU fallback, any format produced by compressTexture back to RGBA8
+	re::TextureData decompressTexture(re::TextureData const& texture);
+
+	// the stored format when the device samples it, RGBA8 through decompressTexture otherwise
+	VkFormat selectTextureFormat(re::PhysicalDevice& physicalDevice, VkFormat stored);
+	// texture decoder for AssetStreamer, leaves blobs the device can sample untouched and rewrites the rest as RGBA8
+	void transcodeTexture(re::PhysicalDevice& physicalDevice, uint8_t const* blob, size_t size, std::vector<uint8_t>& output);
+}
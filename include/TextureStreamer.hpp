@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "Package.hpp"
+#include "AsyncReader.hpp"
+
+namespace re {
+
+	typedef uint32_t textureHandle_t;
+
+	// package textures with only the mips the GPU asks for resident:
+	//   add loads the mip tail -> shaders write the finest sampled mip to the feedback buffer (shaders/texture_feedback.glsl)
+	//   -> update streams one finer level at a time while the budget allows, taking mips from the least recently sampled textures
+	// the image is rebuilt with the new level count on every change, descriptors of textures in getChanged must be rewritten
+	class TextureStreamer {
+	private:
+		struct texture_s {
+			packageEntry_s const* entry;
+			textureView_s view;
+			VkFormat format;
+			bool transcode;
+			re::image_ptr image;
+			uint32_t residentMip;
+			uint32_t tailMip;
+			uint32_t wantedMip;
+			uint32_t loadingMip = INVALID_UINT32;
+			uint64_t lastUsedFrame = 0;
+			VkDeviceSize residentBytes = 0;
+			re::buffer_ptr staging;
+			std::vector<uint8_t> compressed;
+			bool loaded = false;
+			bool failed = false;
+		};
+
+	public:
+		TextureStreamer(re::Device& device, re::Package& package, VkDeviceSize budget, uint32_t maxTextures = 4096);
+		~TextureStreamer(void);
+
+		TextureStreamer(TextureStreamer const&) = delete;
+		TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+		textureHandle_t add(std::string_view name);
+
+		// once per frame after waiting for the frame FRAMES_IN_FLIGHT frames ago, the copies are recorded in cmd
+		void update(VkCommandBuffer cmd);
+
+		// uint per texture, the finest mip sampled this frame or 0xffffffff, read back FRAMES_IN_FLIGHT frames later
+		inline re::Buffer& getFeedbackBuffer(void) { return *feedback[frame % feedback.size()]; }
+		inline std::vector<textureHandle_t> const& getChanged(void) const { return changed; }
+		inline bool isResident(textureHandle_t handle) const { return textures[handle].image != nullptr; }
+		inline uint32_t getResidentMip(textureHandle_t handle) const { return textures[handle].residentMip; }
+		inline VkDeviceSize getResidentBytes(void) const { return residentBytes; }
+		inline VkDeviceSize getBudget(void) const { return budget; }
+		// null view until the mip tail is resident
+		VkDescriptorImageInfo getDescriptorInfo(textureHandle_t handle) const;
+
+	private:
+		void readFeedback(void);
+		void issueLoads(VkCommandBuffer cmd);
+		void applyLoad(VkCommandBuffer cmd, textureHandle_t handle);
+		void resize(VkCommandBuffer cmd, texture_s& texture, uint32_t residentMip, re::Buffer* staging);
+		bool makeRoom(VkCommandBuffer cmd, VkDeviceSize size, textureHandle_t requester);
+		bool isSampled(texture_s const& texture) const;
+		VkDeviceSize getLevelBytes(texture_s const& texture, uint32_t level) const;
+
+		re::Device& device;
+		re::Package& package;
+		VkDeviceSize budget;
+		VkDeviceSize residentBytes = 0;
+		VkDeviceSize loadingBytes = 0;
+		uint64_t frame = 0;
+		uint32_t maxTextures;
+		VkSampler sampler = nullptr;
+
+		std::deque<texture_s> textures;
+		std::unordered_map<packageEntry_s const*, textureHandle_t> lookup;
+		std::vector<re::buffer_ptr> feedback;
+		std::vector<textureHandle_t> changed;
+		std::deque<std::pair<uint64_t, re::image_ptr>> imageGraveyard;
+		std::deque<std::pair<uint64_t, re::buffer_ptr>> bufferGraveyard;
+		uint32_t packageFile;
+		re::AsyncReader reader;
+	};
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Utils.hpp"
+#include "JobSystem.hpp"
+
+namespace re {
+
+	typedef uint32_t transform_t;
+
+	// *dst[i] = *a[i] * b[i], column-major, SSE/AVX when the target has them
+	void multiplyMatrices(glm::mat4* const* dst, glm::mat4 const* const* a, glm::mat4 const* b, size_t count);
+
+	// local TRS stored as SoA sorted by hierarchy depth, world matrices are rebuilt level by level
+	class TransformSystem {
+	public:
+		TransformSystem(void) {};
+		~TransformSystem(void) {};
+
+		transform_t create(transform_t parent = INVALID_UINT32);
+		void destroy(transform_t transform);
+
+		void setParent(transform_t transform, transform_t parent);
+		void setPosition(transform_t transform, glm::vec3 const& position);
+		void setRotation(transform_t transform, glm::quat const& rotation);
+		void setScale(transform_t transform, glm::vec3 const& scale);
+		void setStatic(transform_t transform, bool value);
+
+		glm::vec3 const& getPosition(transform_t transform) const { return positions[slots[transform]]; }
+		glm::quat const& getRotation(transform_t transform) const { return rotations[slots[transform]]; }
+		glm::vec3 const& getScale(transform_t transform) const { return scales[slots[transform]]; }
+		glm::mat4 const& getWorld(transform_t transform) const { return worlds[slots[transform]]; }
+
+		void update(re::JobSystem& jobs);
+
+		inline size_t size(void) const { return handles.size(); }
+		inline size_t getUpdatedCount(void) const { return updatedCount; }
+
+	private:
+		struct level_s {
+			uint32_t begin;
+			uint32_t staticBegin;
+			uint32_t end;
+		};
+
+		enum flags_e : uint8_t {
+			FLAG_DIRTY = 1 << 0,
+			FLAG_STATIC = 1 << 1
+		};
+
+		void markDirty(transform_t transform);
+		void sortByDepth(void);
+		size_t updateRange(size_t begin, size_t end);
+
+		// indexed by handle
+		std::vector<uint32_t> slots;
+		std::vector<transform_t> parents;
+		std::vector<uint32_t> childCounts;
+		std::vector<transform_t> freeHandles;
+
+		// indexed by slot, sorted by depth then dynamic before static
+		std::vector<transform_t> handles;
+		std::vector<uint32_t> parentSlots;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<uint8_t> flags;
+		std::vector<uint32_t> stamps;
+		std::vector<glm::mat4> worlds;
+
+		std::vector<level_s> levels;
+		uint32_t frame = 0;
+		size_t dirtyCount = 0;
+		size_t staticDirtyCount = 0;
+		bool orderDirty = false;
+		size_t updatedCount = 0;
+	};
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <tuple>
+#include <string_view>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "Package.hpp"
+#include "AsyncReader.hpp"
+
+namespace re {
+
+	#define VIRTUAL_TEXTURE_MAX_MIPS 16
+
+	// uniform block of shaders/virtual_texture.glsl
+	struct virtualTextureInfo_s {
+		glm::uvec2 size;
+		uint32_t mipLevels;
+		uint32_t tileSize;
+		uint32_t border;
+		uint32_t cacheTiles;
+		uint32_t pad[2];
+		// first page, pages in x and y
+		glm::uvec4 mips[VIRTUAL_TEXTURE_MAX_MIPS];
+	};
+
+	// a package virtual texture with only the pages visible on screen resident:
+	//   shaders write the pages they sample to the feedback buffer -> update loads missing pages, coarse mips first,
+	//   and evicts the least recently sampled ones when the cache is full
+	// with sparseResidencyImage2D the pages are copied into a sparse image whose memory is bound block by block,
+	// the page table then holds the finest resident mip of every mip 0 page to clamp the lod
+	// otherwise they go to slots of a physical cache image and the page table maps every page to the slot of its finest resident ancestor
+	class VirtualTexture {
+	private:
+		struct page_s {
+			uint32_t slot = INVALID_UINT32;
+			uint64_t lastUsedFrame = 0;
+			bool loading = false;
+			bool pinned = false;
+			bool failed = false;
+		};
+
+		struct load_s {
+			uint32_t page;
+			uint32_t stagingSlot;
+			std::vector<uint8_t> compressed;
+			bool active = false;
+			bool done = false;
+			bool ok = false;
+		};
+
+		struct sparseBlock_s {
+			uint32_t memorySlot;
+			uint32_t references;
+		};
+
+	public:
+		VirtualTexture(re::Device& device, re::Package& package, std::string_view name, VkDeviceSize budget, bool allowSparse = true);
+		~VirtualTexture(void);
+
+		VirtualTexture(VirtualTexture const&) = delete;
+		VirtualTexture& operator=(VirtualTexture const&) = delete;
+
+		// once per frame after waiting for the frame FRAMES_IN_FLIGHT frames ago, the tile copies are recorded in cmd
+		void update(VkCommandBuffer cmd);
+
+		inline bool isSparse(void) const { return sparse; }
+		inline uint32_t getResidentPages(void) const { return residentPages; }
+		inline uint32_t getPageCount(void) const { return static_cast<uint32_t>(pages.size()); }
+		inline re::Buffer& getInfoBuffer(void) { return *infoBuffer; }
+		inline re::Buffer& getPageTable(void) { return *pageTables[frame % pageTables.size()]; }
+		inline re::Buffer& getFeedbackBuffer(void) { return *feedback[frame % feedback.size()]; }
+		VkDescriptorImageInfo getDescriptorInfo(void) const { return { sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }; }
+
+	private:
+		void createCache(VkDeviceSize budget);
+		bool createSparseImage(VkDeviceSize budget);
+		void readFeedback(void);
+		void issueLoads(void);
+		void applyLoads(VkCommandBuffer cmd);
+		bool reserve(uint32_t page);
+		void release(uint32_t page);
+		uint32_t evict(uint32_t count);
+		uint32_t getSlotsNeeded(uint32_t page) const;
+		void retire(void);
+		void writePageTable(void);
+		void flushBinds(void);
+		bool isResident(uint32_t page) const { return page != INVALID_UINT32 && pages[page].slot != INVALID_UINT32 && !pages[page].loading; }
+
+		void getPageCoords(uint32_t page, uint32_t& mip, uint32_t& x, uint32_t& y) const;
+		uint32_t getParent(uint32_t page) const;
+		std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> getBlocks(uint32_t page) const;
+		VkDeviceSize getTileBytes(void) const;
+
+		re::Device& device;
+		re::Package& package;
+		packageEntry_s const* entry;
+		virtualTextureView_s source;
+		VkFormat format;
+		bool transcode;
+		bool sparse = false;
+		uint32_t content;
+		uint64_t frame = 0;
+
+		std::vector<page_s> pages;
+		std::vector<uint32_t> freeSlots;
+		std::deque<std::pair<uint64_t, uint32_t>> slotGraveyard;
+		uint32_t residentPages = 0;
+		uint32_t pageTableVersion = 1;
+		std::vector<uint32_t> pageTableVersions;
+		std::vector<load_s> loads;
+		std::vector<uint32_t> freeStagingSlots;
+		std::deque<std::pair<uint64_t, uint32_t>> stagingGraveyard;
+
+		re::image_ptr cache;
+		VkImage image = nullptr;
+		VkDeviceMemory memory = nullptr;
+		VkImageView view = nullptr;
+		VkSampler sampler = nullptr;
+		bool initialized = false;
+		uint32_t cacheTiles = 0;
+
+		VkExtent3D sparseGranularity{};
+		uint32_t mipTailFirstLod = 0;
+		VkDeviceMemory tailMemory = nullptr;
+		VkDeviceSize blockSize = 0;
+		std::map<std::tuple<uint32_t, uint32_t, uint32_t>, sparseBlock_s> sparseBlocks;
+		std::vector<VkSparseImageMemoryBind> pendingBinds;
+		std::vector<VkSparseMemoryBind> pendingOpaqueBinds;
+		std::deque<std::pair<uint64_t, VkSparseImageMemoryBind>> unbindQueue;
+
+		re::buffer_ptr infoBuffer;
+		re::buffer_ptr staging;
+		std::vector<re::buffer_ptr> pageTables;
+		std::vector<re::buffer_ptr> feedback;
+		uint32_t packageFile;
+		re::AsyncReader reader;
+	};
+}
@@ -0,0 +1,89 @@
+// clustered lights, define CLUSTERED_LIGHTING_SET before including, the bindings follow ClusteredLighting's buffers
+// the binning pass defines CLUSTERED_LIGHTING_WRITE, shading only reads
+
+#ifdef CLUSTERED_LIGHTING_WRITE
+	#define CLUSTER_ACCESS
+#else
+	#define CLUSTER_ACCESS readonly
+#endif
+
+const uint LIGHT_TYPE_POINT = 0;
+const uint LIGHT_TYPE_SPOT = 1;
+
+struct Light {
+	vec3 position;
+	float range;
+	vec3 color;
+	uint type;
+	vec3 direction;
+	float cosOuter;
+	float cosInner;
+	float pad0;
+	float pad1;
+	float pad2;
+};
+
+layout(std140, set = CLUSTERED_LIGHTING_SET, binding = 0) uniform ClusterInfo {
+	mat4 view;
+	// 1 / projection[0][0], 1 / projection[1][1], znear, zfar
+	vec4 projection;
+	// clusters in x, y and z, light count
+	uvec4 grid;
+	// width, height, tile size in pixels
+	vec4 screen;
+	// slice = log(depth) * scale - bias
+	vec4 slicing;
+} clusterInfo;
+
+layout(std430, set = CLUSTERED_LIGHTING_SET, binding = 1) readonly buffer Lights { Light lights[]; };
+// offset in lightIndices and count of every cluster
+layout(std430, set = CLUSTERED_LIGHTING_SET, binding = 2) CLUSTER_ACCESS buffer Clusters { uvec2 clusterLights[]; };
+layout(std430, set = CLUSTERED_LIGHTING_SET, binding = 3) CLUSTER_ACCESS buffer LightIndices { uint lightIndices[]; };
+
+// depths are positive distances along the view axis
+float clusterSliceDepth(uint slice)
+{
+	return clusterInfo.projection.z * pow(clusterInfo.projection.w / clusterInfo.projection.z, float(slice) / float(clusterInfo.grid.z));
+}
+
+uint getClusterIndex(vec2 fragCoord, float depth)
+{
+	uint slice = uint(clamp(log(depth) * clusterInfo.slicing.x - clusterInfo.slicing.y, 0.0, float(clusterInfo.grid.z - 1)));
+	uvec2 tile = min(uvec2(fragCoord / clusterInfo.screen.z), clusterInfo.grid.xy - 1);
+	return tile.x + clusterInfo.grid.x * (tile.y + clusterInfo.grid.y * slice);
+}
+
+// inverse square falloff windowed to reach 0 at the range
+float lightAttenuation(Light light, vec3 toLight)
+{
+	float distance2 = dot(toLight, toLight);
+	float ratio = distance2 / (light.range * light.range);
+	float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+	return window * window / max(distance2, 1e-4);
+}
+
+// lambert diffuse and blinn-phong specular, everything in world space
+vec3 evaluateLight(Light light, vec3 position, vec3 normal, vec3 viewDirection, vec3 albedo, float shininess)
+{
+	vec3 toLight = light.position - position;
+	vec3 l = normalize(toLight);
+	float attenuation = lightAttenuation(light, toLight);
+
+	if (light.type == LIGHT_TYPE_SPOT)
+		attenuation *= smoothstep(light.cosOuter, light.cosInner, dot(-l, light.direction));
+
+	float diffuse = max(dot(normal, l), 0.0);
+	float specular = diffuse > 0.0 ? pow(max(dot(normal, normalize(l + viewDirection)), 0.0), shininess) : 0.0;
+	return light.color * attenuation * (albedo * diffuse + specular);
+}
+
+// fragCoord is gl_FragCoord.xy, depth the fragment's distance along the view axis
+vec3 shadeClusteredLights(vec2 fragCoord, float depth, vec3 position, vec3 normal, vec3 viewDirection, vec3 albedo, float shininess)
+{
+	uvec2 list = clusterLights[getClusterIndex(fragCoord, depth)];
+	vec3 color = vec3(0.0);
+
+	for (uint i = 0; i < list.y; i++)
+		color += evaluateLight(lights[lightIndices[list.x + i]], position, normal, viewDirection, albedo, shininess);
+	return color;
+}
@@ -0,0 +1,49 @@
+// sphere occlusion against the Hi-Z pyramid, shared by the culling passes
+// the including shader declares the view uniform as data, with view, projection, pyramidSize and znear,
+// and the pyramid sampler before including
+
+// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere, Mara & McGuire 2013
+// c is in view space with +z pointing forward, the result is a uv rectangle
+bool projectSphere(vec3 c, float r, out vec4 aabb)
+{
+	if (c.z < r + data.znear)
+		return false;
+
+	vec3 cr = c * r;
+	float czr2 = c.z * c.z - r * r;
+
+	float vx = sqrt(c.x * c.x + czr2);
+	float minx = (vx * c.x - cr.z) / (vx * c.z + cr.x);
+	float maxx = (vx * c.x + cr.z) / (vx * c.z - cr.x);
+
+	float vy = sqrt(c.y * c.y + czr2);
+	float miny = (vy * c.y - cr.z) / (vy * c.z + cr.y);
+	float maxy = (vy * c.y + cr.z) / (vy * c.z - cr.y);
+
+	aabb = vec4(minx * data.projection[0][0], miny * data.projection[1][1], maxx * data.projection[0][0], maxy * data.projection[1][1]);
+	aabb = aabb * 0.5 + 0.5;
+	aabb = vec4(min(aabb.xy, aabb.zw), max(aabb.xy, aabb.zw));
+	return true;
+}
+
+// center in world space
+bool occluded(vec3 center, float radius)
+{
+	vec3 c = (data.view * vec4(center, 1.0)).xyz;
+	vec4 aabb;
+
+	if (!projectSphere(vec3(c.xy, -c.z), radius, aabb))
+		return false;
+
+	vec4 clip = data.projection * vec4(0.0, 0.0, c.z + radius, 1.0);
+	float depth = clip.z / clip.w;
+
+	vec2 size = (aabb.zw - aabb.xy) * data.pyramidSize;
+	float level = ceil(log2(max(size.x, size.y)));
+
+	float farthest = max(
+		max(textureLod(pyramid, aabb.xy, level).r, textureLod(pyramid, aabb.zy, level).r),
+		max(textureLod(pyramid, aabb.xw, level).r, textureLod(pyramid, aabb.zw, level).r)
+	);
+	return depth > farthest;
+}
@@ -0,0 +1,18 @@
+// screen-space lod selection, shared by the culling passes
+// the including shader declares the Instance struct and the meshes buffer before including
+
+// coarsest lod whose error stays under the pixel threshold, lodCamera.w is the lod scale, 0 keeps the finest
+uint selectLod(Instance instance, vec4 lodCamera)
+{
+	uint lod = 0;
+	if (lodCamera.w <= 0.0)
+		return instance.mesh;
+
+	float distance = max(length(instance.sphere.xyz - lodCamera.xyz) - instance.sphere.w, 1e-4);
+	for (uint i = 1; i < instance.lodCount; i++) {
+		if (meshes[instance.mesh + i].lodError * lodCamera.w > distance)
+			break;
+		lod = i;
+	}
+	return instance.mesh + lod;
+}
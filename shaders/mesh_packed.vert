@@ -0,0 +1,32 @@
+#version 450
+
+// fallback for devices without 16-bit vertex formats, the PackedVertex bytes arrive as one uvec4
+layout(location = 0) in uvec4 inPacked;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outUv;
+
+layout(push_constant) uniform Constants {
+	mat4 model;
+	mat4 viewProjection;
+	vec4 positionOffset;
+	vec4 positionScale;
+} pc;
+
+vec3 decodeOctahedral(vec2 p)
+{
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+void main()
+{
+	vec3 unorm = vec3(unpackUnorm2x16(inPacked.x), unpackUnorm2x16(inPacked.y).x);
+	vec3 position = pc.positionOffset.xyz + unorm * pc.positionScale.xyz;
+
+	gl_Position = pc.viewProjection * pc.model * vec4(position, 1.0);
+	outNormal = mat3(pc.model) * decodeOctahedral(unpackSnorm2x16(inPacked.z));
+	outUv = unpackHalf2x16(inPacked.w);
+}
@@ -0,0 +1,32 @@
+#version 450
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inUv;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outUv;
+
+layout(push_constant) uniform Constants {
+	mat4 model;
+	mat4 viewProjection;
+	vec4 positionOffset;
+	vec4 positionScale;
+} pc;
+
+vec3 decodeOctahedral(vec2 p)
+{
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+void main()
+{
+	vec3 position = pc.positionOffset.xyz + inPosition.xyz * pc.positionScale.xyz;
+
+	gl_Position = pc.viewProjection * pc.model * vec4(position, 1.0);
+	outNormal = mat3(pc.model) * decodeOctahedral(inNormal);
+	outUv = inUv;
+}
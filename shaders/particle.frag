@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec4 inColor;
+layout(location = 1) in vec2 inUv;
+
+layout(location = 0) out vec4 outColor;
+
+// soft round sprite, alpha blended over what is behind it
+void main()
+{
+	float falloff = 1.0 - smoothstep(0.5, 1.0, length(inUv));
+	outColor = vec4(inColor.rgb, inColor.a * falloff);
+}
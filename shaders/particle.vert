@@ -0,0 +1,34 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#define PARTICLE_DRAW
+#include "particles.glsl"
+
+// ParticleSystem::draw issues 6 vertices per live particle, one instance each in back to front order
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec2 outUv;
+
+layout(push_constant) uniform Constants {
+	mat4 viewProjection;
+	// camera axes in world space, the quads face the camera
+	vec4 right;
+	vec4 up;
+} pc;
+
+const vec2 corners[6] = vec2[](
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main()
+{
+	Particle particle = particles[sortList[gl_InstanceIndex].y];
+	vec2 corner = corners[gl_VertexIndex];
+	vec3 position = particle.position + (pc.right.xyz * corner.x + pc.up.xyz * corner.y) * particle.size;
+
+	gl_Position = pc.viewProjection * vec4(position, 1.0);
+	// fades out over the last quarter of its life
+	outColor = particle.color;
+	outColor.a *= clamp(4.0 * (particle.lifetime - particle.age) / particle.lifetime, 0.0, 1.0);
+	outUv = corner;
+}
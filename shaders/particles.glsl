@@ -0,0 +1,59 @@
+// shared by the particle_*.comp passes and particle.vert, the bindings and constants follow ParticleSystem
+// particle.vert defines PARTICLE_DRAW, it only reads the particles and the sorted list and has its own constants
+
+struct Particle {
+	vec3 position;
+	float age;
+	vec3 velocity;
+	// 0 once expired, the slot is then on the dead list
+	float lifetime;
+	vec4 color;
+	float size;
+	float drag;
+	vec2 pad;
+};
+
+#ifdef PARTICLE_DRAW
+#define PARTICLE_ACCESS readonly
+#else
+#define PARTICLE_ACCESS
+#endif
+
+layout(std430, set = 0, binding = 0) PARTICLE_ACCESS buffer Particles { Particle particles[]; };
+// x the bits of the squared camera distance, at least 1 so the padding sorts last, y the particle index
+layout(std430, set = 0, binding = 2) PARTICLE_ACCESS buffer SortList { uvec2 sortList[]; };
+
+#ifndef PARTICLE_DRAW
+layout(std430, set = 0, binding = 1) buffer DeadList { uint deadList[]; };
+layout(std430, set = 0, binding = 3) buffer Counters { int deadCount; uint aliveCount; };
+// the VkDrawIndirectCommand then a VkDispatchIndirectCommand per sort dispatch
+layout(std430, set = 0, binding = 4) buffer Args { uint args[]; };
+
+layout(push_constant) uniform Constants {
+	// emitter position, spawn radius
+	vec4 position;
+	// emitter velocity, spread
+	vec4 velocity;
+	vec4 color;
+	// camera position, delta time
+	vec4 camera;
+	vec4 gravity;
+	float size;
+	float drag;
+	float minLifetime;
+	float maxLifetime;
+	uint emitCount;
+	uint seed;
+	uint maxParticles;
+	// of the sort list, a power of two
+	uint capacity;
+	// simulate: 0 simulate, 1 reset; sort: 0 local sort, 1 global step, 2 local merge
+	uint phase;
+	uint k;
+	uint j;
+	uint pad;
+} pc;
+
+// elements a sort workgroup orders in shared memory
+#define SORT_BLOCK 1024
+#endif
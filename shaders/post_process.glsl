@@ -0,0 +1,34 @@
+// shared by the post_*.comp passes, the bindings and constants follow PostProcess
+// the bloom passes define POST_BLOOM_PASS and declare their own source and destination
+
+layout(push_constant) uniform Constants {
+	// projection[0][0], projection[1][1], projection[2][2], projection[3][2]
+	vec4 projection;
+	// of the image the pass writes
+	vec2 size;
+	float minLogLuminance;
+	float logLuminanceRange;
+	float adaptation;
+	float bloomThreshold;
+	float bloomIntensity;
+	float aoRadius;
+	float aoIntensity;
+	float exposureCompensation;
+	uint mip;
+	float pad;
+} pc;
+
+#ifndef POST_BLOOM_PASS
+layout(set = 0, binding = 0) uniform sampler2D hdr;
+layout(set = 0, binding = 1) uniform sampler2D depth;
+layout(set = 0, binding = 2) uniform sampler2D bloom;
+layout(set = 0, binding = 3, r32f) uniform image2D occlusion;
+layout(set = 0, binding = 4, rgba8) uniform writeonly image2D outputImage;
+layout(std430, set = 0, binding = 5) buffer Histogram { uint histogram[256]; };
+layout(std430, set = 0, binding = 6) buffer Exposure { float averageLuminance; };
+#endif
+
+float luminance(vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
@@ -0,0 +1,32 @@
+// shadow atlas, define SHADOW_ATLAS_SET before including, the bindings follow ShadowAtlas's descriptor set
+
+struct Shadow {
+	mat4 viewProjection;
+	// atlas uv offset then scale of the tile
+	vec4 rect;
+};
+
+layout(set = SHADOW_ATLAS_SET, binding = 0) uniform sampler2DShadow shadowAtlas;
+layout(std430, set = SHADOW_ATLAS_SET, binding = 1) readonly buffer Shadows { Shadow shadows[]; };
+
+// 1 lit, 0 shadowed, 3x3 pcf kept inside the shadow's tile
+float sampleShadow(uint shadow, vec3 position)
+{
+	vec4 clip = shadows[shadow].viewProjection * vec4(position, 1.0);
+	vec3 ndc = clip.xyz / clip.w;
+
+	if (any(greaterThan(abs(ndc.xy), vec2(1.0))) || ndc.z < 0.0 || ndc.z > 1.0)
+		return 1.0;
+
+	vec4 rect = shadows[shadow].rect;
+	vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+	vec2 uv = rect.xy + (ndc.xy * 0.5 + 0.5) * rect.zw;
+	vec2 minimum = rect.xy + texel * 1.5;
+	vec2 maximum = rect.xy + rect.zw - texel * 1.5;
+	float lit = 0.0;
+
+	for (int y = -1; y <= 1; y++)
+		for (int x = -1; x <= 1; x++)
+			lit += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texel, minimum, maximum), ndc.z));
+	return lit / 9.0;
+}
@@ -0,0 +1,18 @@
+// streamed texture feedback, define TEXTURE_FEEDBACK_SET and TEXTURE_FEEDBACK_BINDING before including
+// the buffer is TextureStreamer::getFeedbackBuffer, one uint per texture handle
+
+layout(set = TEXTURE_FEEDBACK_SET, binding = TEXTURE_FEEDBACK_BINDING) buffer TextureFeedback {
+	uint feedbackMips[];
+};
+
+// the mip the sampler picks for the full chain, the bound image may start at a coarser level
+// one pixel of every 2x2 quad writes to keep the atomics down
+void writeTextureFeedback(uint textureId, vec2 uv, vec2 fullSize)
+{
+	vec2 dx = dFdx(uv) * fullSize;
+	vec2 dy = dFdy(uv) * fullSize;
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+
+	if (((uint(gl_FragCoord.x) | uint(gl_FragCoord.y)) & 1u) == 0u)
+		atomicMin(feedbackMips[textureId], uint(lod));
+}
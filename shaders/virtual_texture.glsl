@@ -0,0 +1,84 @@
+// virtual texture sampling, define VIRTUAL_TEXTURE_SET before including
+// and VIRTUAL_TEXTURE_SPARSE when VirtualTexture::isSparse, the bindings follow VirtualTexture's getters
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = 0) uniform sampler2D virtualImage;
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = 1) readonly buffer VirtualPageTable {
+	uint pageTable[];
+};
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = 2) buffer VirtualFeedback {
+	uint feedbackPages[];
+};
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = 3) uniform VirtualTextureInfo {
+	uvec2 size;
+	uint mipLevels;
+	uint tileSize;
+	uint border;
+	uint cacheTiles;
+	uvec2 pad;
+	uvec4 mips[16];
+} vt;
+
+float virtualTextureLod(vec2 uv)
+{
+	vec2 dx = dFdx(uv) * vec2(vt.size);
+	vec2 dy = dFdy(uv) * vec2(vt.size);
+	return clamp(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0)), 0.0, float(vt.mipLevels - 1));
+}
+
+uvec2 virtualTexturePage(vec2 uv, uint mip)
+{
+	uint content = vt.tileSize - 2 * vt.border;
+	uvec2 mipSize = max(vt.size >> mip, uvec2(1));
+	return min(uvec2(uv * vec2(mipSize)) / content, vt.mips[mip].yz - 1);
+}
+
+// one pixel of every 2x2 quad marks the page it needs
+void writeVirtualTextureFeedback(vec2 uv)
+{
+	uv = fract(uv);
+	uint mip = uint(virtualTextureLod(uv));
+	uvec2 page = virtualTexturePage(uv, mip);
+
+	if (((uint(gl_FragCoord.x) | uint(gl_FragCoord.y)) & 1u) == 0u)
+		feedbackPages[vt.mips[mip].x + page.y * vt.mips[mip].y + page.x] = 1u;
+}
+
+#ifdef VIRTUAL_TEXTURE_SPARSE
+
+// the lod is clamped to the finest mip resident over the mip 0 page
+vec4 sampleVirtualTexture(vec2 uv)
+{
+	uv = fract(uv);
+	uvec2 page = virtualTexturePage(uv, 0);
+	uint resident = pageTable[page.y * vt.mips[0].y + page.x];
+
+	if (resident >= vt.mipLevels)
+		return vec4(0.0);
+	return textureLod(virtualImage, uv, max(textureQueryLod(virtualImage, uv).y, float(resident)));
+}
+
+#else
+
+// bilinear inside the finest resident page, the tile border covers the filter footprint
+vec4 sampleVirtualTexture(vec2 uv)
+{
+	uv = fract(uv);
+	uint mip = uint(virtualTextureLod(uv));
+	uvec2 page = virtualTexturePage(uv, mip);
+	uint entry = pageTable[vt.mips[mip].x + page.y * vt.mips[mip].y + page.x];
+
+	if (entry == 0xffffffffu)
+		return vec4(0.0);
+
+	uint content = vt.tileSize - 2 * vt.border;
+	uint resident = entry >> 16 & 0xffu;
+	vec2 texel = uv * vec2(max(vt.size >> resident, uvec2(1)));
+	vec2 inPage = texel - vec2(virtualTexturePage(uv, resident) * content);
+	vec2 slot = vec2(entry & 0xffu, entry >> 8 & 0xffu);
+	return textureLod(virtualImage, (slot * float(vt.tileSize) + float(vt.border) + inPage) / float(vt.cacheTiles * vt.tileSize), 0.0);
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include "AssetStreamer.hpp"
+#include <iostream>
+#include <cstring>
+
+static constexpr size_t maxInflightReads = 32;
+static constexpr VkDeviceSize stagingAlignment = 16;
+
+re::AssetStreamer::AssetStreamer(re::Device& device, re::JobSystem& jobs, re::Package& package, VkDeviceSize budget, VkDeviceSize stagingSize)
+	: device(device), jobs(jobs), package(package), budget(budget)
+{
+	graphicsFamily = device.physicalDevice.queueFamily.graphics;
+	transferFamily = device.queueHandles.transfer ? device.physicalDevice.queueFamily.transfer : graphicsFamily;
+	transferQueue = device.queueHandles.transfer ? device.queueHandles.transfer : device.queueHandles.graphics;
+
+	staging = std::make_shared<re::Buffer>(device, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	stagingFree[0] = stagingSize;
+	commandPool = std::make_shared<re::CommandPool>(device, transferFamily);
+	packageFile = reader.open(package.getPath());
+}
+
+re::AssetStreamer::~AssetStreamer(void)
+{
+	try {
+		jobs.wait(decodeJobs);
+	}
+	catch (std::exception& e) {
+		std::cerr << TERMINAL_COLOR_RED << "failed to decode: " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+	}
+	for (int i = 0; i < batches.size(); i++)
+		if (batches[i].busy)
+			batches[i].fence->wait();
+}
+
+re::assetHandle_t re::AssetStreamer::request(std::string_view name, float priority)
+{
+	packageEntry_s const* entry = package.find(name);
+
+	if (!entry)
+		throw std::runtime_error("unknown asset: " + std::string(name));
+
+	auto it = lookup.find(entry);
+	if (it == lookup.end()) {
+		it = lookup.emplace(entry, static_cast<assetHandle_t>(assets.size())).first;
+		assets.emplace_back().entry = entry;
+	}
+
+	asset_s& asset = assets[it->second];
+	asset.priority = std::max(asset.priority, priority);
+	asset.lastUsedFrame = frame;
+	if (asset.state == ASSET_STATE_UNLOADED || asset.state == ASSET_STATE_FAILED)
+		asset.state = ASSET_STATE_QUEUED;
+	return it->second;
+}
+
+void re::AssetStreamer::setPriority(assetHandle_t handle, float priority)
+{
+	assets[handle].priority = priority;
+}
+
+void re::AssetStreamer::touch(assetHandle_t handle)
+{
+	assets[handle].lastUsedFrame = frame;
+}
+
+void re::AssetStreamer::setDecoder(assetType_e type, assetDecoder_t decoder)
+{
+	decoders[type] = std::move(decoder);
+}
+
+void re::AssetStreamer::update(void)
+{
+	retireBatches();
+	reader.poll();
+
+	std::vector<assetHandle_t> decoded, failed;
+	{
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		decoded.swap(decodedAssets);
+		failed.swap(failedAssets);
+	}
+	for (int i = 0; i < decoded.size(); i++)
+		assets[decoded[i]].state = ASSET_STATE_READY;
+	for (int i = 0; i < failed.size(); i++) {
+		release(failed[i]);
+		assets[failed[i]].decoded = {};
+		assets[failed[i]].state = ASSET_STATE_FAILED;
+	}
+
+	while (!graveyard.empty() && graveyard.front().first + FRAMES_IN_FLIGHT <= frame)
+		graveyard.pop_front();
+
+	issueReads();
+	submitUploads();
+	frame++;
+}
+
+void re::AssetStreamer::onRead(assetHandle_t handle, bool ok)
+{
+	asset_s& asset = assets[handle];
+
+	if (!ok) {
+		std::cerr << TERMINAL_COLOR_RED << "failed to stream " << package.getName(*asset.entry) << TERMINAL_COLOR_RESET << std::endl;
+		release(handle);
+		asset.state = ASSET_STATE_FAILED;
+		return;
+	}
+
+	auto decoder = decoders.find(asset.entry->type);
+	if (decoder == decoders.end()) {
+		asset.state = ASSET_STATE_READY;
+		return;
+	}
+
+	asset.state = ASSET_STATE_DECODING;
+	uint8_t* blob = static_cast<uint8_t*>(staging->mapped) + asset.stagingOffset;
+	// staging and the budget are only touched on the update thread, a failure is handed back to it
+	jobs.submit([this, handle, blob, &asset, decode = decoder->second]() {
+		bool ok = true;
+		try {
+			decode(blob, asset.entry->size, asset.decoded);
+		}
+		catch (std::exception& e) {
+			std::cerr << TERMINAL_COLOR_RED << "failed to decode " << package.getName(*asset.entry) << ": " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+			ok = false;
+		}
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		(ok ? decodedAssets : failedAssets).push_back(handle);
+	}, &decodeJobs);
+}
+
+// reads land directly in staging memory, a read only starts once the budget has room for it
+void re::AssetStreamer::issueReads(void)
+{
+	std::vector<assetHandle_t> queued;
+
+	for (assetHandle_t i = 0; i < assets.size(); i++)
+		if (assets[i].state == ASSET_STATE_QUEUED)
+			queued.push_back(i);
+	std::sort(queued.begin(), queued.end(), [this](assetHandle_t l, assetHandle_t r) { return assets[l].priority > assets[r].priority; });
+
+	for (int i = 0; i < queued.size() && reader.getPendingCount() < maxInflightReads; i++) {
+		asset_s& asset = assets[queued[i]];
+		VkDeviceSize size = asset.entry->size;
+
+		if (!size) {
+			asset.state = ASSET_STATE_RESIDENT;
+			continue;
+		}
+		if (size > staging->size)
+			throw std::runtime_error("asset larger than the staging buffer: " + std::string(package.getName(*asset.entry)));
+		if (!makeRoom(size, asset.priority) || !allocateStaging(size, asset.stagingOffset))
+			break;
+
+		committed += size;
+		asset.committedSize = size;
+		asset.state = ASSET_STATE_READING;
+		reader.read(packageFile, asset.entry->offset, size, static_cast<uint8_t*>(staging->mapped) + asset.stagingOffset,
+			[this, handle = queued[i]](bool ok) { onRead(handle, ok); });
+	}
+}
+
+void re::AssetStreamer::submitUploads(void)
+{
+	std::vector<assetHandle_t> ready;
+
+	for (assetHandle_t i = 0; i < assets.size(); i++)
+		if (assets[i].state == ASSET_STATE_READY)
+			ready.push_back(i);
+	if (ready.empty())
+		return;
+	std::sort(ready.begin(), ready.end(), [this](assetHandle_t l, assetHandle_t r) { return assets[l].priority > assets[r].priority; });
+
+	batch_s* batch = nullptr;
+	for (int i = 0; i < batches.size() && !batch; i++)
+		if (!batches[i].busy)
+			batch = &batches[i];
+	if (!batch) {
+		batches.push_back({ commandPool->allocate(), std::make_shared<re::Fence>(device), {}, {}, false });
+		batch = &*batches.rbegin();
+	}
+
+	VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(batch->cmd, &beginInfo);
+
+	std::vector<VkBufferMemoryBarrier> releases;
+	for (int i = 0; i < ready.size(); i++) {
+		asset_s& asset = assets[ready[i]];
+		VkDeviceSize offset = asset.stagingOffset;
+		VkDeviceSize size = asset.entry->size;
+
+		// a decoder that produced a new payload frees the raw blob, the GPU never saw it
+		if (!asset.decoded.empty()) {
+			VkDeviceSize decodedSize = asset.decoded.size();
+			if (!allocateStaging(decodedSize, offset))
+				break;
+			std::memcpy(static_cast<uint8_t*>(staging->mapped) + offset, asset.decoded.data(), decodedSize);
+			freeStaging(asset.stagingOffset, size);
+			committed += decodedSize - asset.committedSize;
+			asset.committedSize = decodedSize;
+			asset.stagingOffset = offset;
+			asset.decoded = std::vector<uint8_t>();
+			size = decodedSize;
+		}
+
+		asset.buffer = std::make_shared<re::Buffer>(device, size,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkBufferCopy region{ offset, 0, size };
+		vkCmdCopyBuffer(batch->cmd, staging->ptr, asset.buffer->ptr, 1, &region);
+
+		if (transferFamily != graphicsFamily) {
+			VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.buffer = asset.buffer->ptr;
+			barrier.size = VK_WHOLE_SIZE;
+			releases.push_back(barrier);
+		}
+
+		asset.state = ASSET_STATE_UPLOADING;
+		batch->assets.push_back(ready[i]);
+		batch->staging.push_back({ offset, size });
+	}
+
+	if (!releases.empty())
+		vkCmdPipelineBarrier(batch->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, static_cast<uint32_t>(releases.size()), releases.data(), 0, nullptr);
+	vkEndCommandBuffer(batch->cmd);
+
+	if (batch->assets.empty())
+		return;
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch->cmd;
+	batch->fence->reset();
+	if (vkQueueSubmit(transferQueue, 1, &submitInfo, batch->fence->ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit asset uploads");
+	batch->busy = true;
+}
+
+void re::AssetStreamer::retireBatches(void)
+{
+	for (int i = 0; i < batches.size(); i++) {
+		batch_s& batch = batches[i];
+		if (!batch.busy || !batch.fence->signaled())
+			continue;
+
+		for (int j = 0; j < batch.staging.size(); j++)
+			freeStaging(batch.staging[j].first, batch.staging[j].second);
+		acquires.insert(acquires.end(), batch.assets.begin(), batch.assets.end());
+		batch.assets.clear();
+		batch.staging.clear();
+		batch.busy = false;
+	}
+}
+
+void re::AssetStreamer::recordAcquireBarriers(VkCommandBuffer cmd)
+{
+	std::vector<VkBufferMemoryBarrier> barriers;
+	bool transfer = transferFamily != graphicsFamily;
+
+	for (int i = 0; i < acquires.size(); i++) {
+		asset_s& asset = assets[acquires[i]];
+		VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+
+		barrier.srcAccessMask = transfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		barrier.srcQueueFamilyIndex = transfer ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = transfer ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = asset.buffer->ptr;
+		barrier.size = VK_WHOLE_SIZE;
+		barriers.push_back(barrier);
+		asset.state = ASSET_STATE_RESIDENT;
+	}
+	acquires.clear();
+
+	if (barriers.empty())
+		return;
+	vkCmdPipelineBarrier(cmd, transfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+// only assets unused since the previous frame and less important than the incoming one are evicted
+bool re::AssetStreamer::makeRoom(VkDeviceSize size, float priority)
+{
+	if (committed + size <= budget)
+		return true;
+
+	std::vector<assetHandle_t> candidates;
+	for (assetHandle_t i = 0; i < assets.size(); i++)
+		if (assets[i].state == ASSET_STATE_RESIDENT && assets[i].lastUsedFrame + 1 < frame && assets[i].priority < priority)
+			candidates.push_back(i);
+	std::sort(candidates.begin(), candidates.end(), [this](assetHandle_t l, assetHandle_t r) { return assets[l].lastUsedFrame < assets[r].lastUsedFrame; });
+
+	for (int i = 0; i < candidates.size() && committed + size > budget; i++)
+		evict(candidates[i]);
+	return committed + size <= budget;
+}
+
+// the GPU may still read the buffer, it is kept alive for FRAMES_IN_FLIGHT more frames
+void re::AssetStreamer::evict(assetHandle_t handle)
+{
+	asset_s& asset = assets[handle];
+
+	if (asset.buffer)
+		graveyard.push_back({ frame, std::move(asset.buffer) });
+	asset.buffer = nullptr;
+	committed -= asset.committedSize;
+	asset.committedSize = 0;
+	asset.priority = 0.0f;
+	asset.state = ASSET_STATE_UNLOADED;
+}
+
+void re::AssetStreamer::release(assetHandle_t handle)
+{
+	asset_s& asset = assets[handle];
+
+	freeStaging(asset.stagingOffset, asset.entry->size);
+	committed -= asset.committedSize;
+	asset.committedSize = 0;
+}
+
+bool re::AssetStreamer::allocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+{
+	size = (size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+	for (auto it = stagingFree.begin(); it != stagingFree.end(); it++) {
+		if (it->second < size)
+			continue;
+		offset = it->first;
+		if (it->second > size)
+			stagingFree[it->first + size] = it->second - size;
+		stagingFree.erase(it);
+		return true;
+	}
+	return false;
+}
+
+void re::AssetStreamer::freeStaging(VkDeviceSize offset, VkDeviceSize size)
+{
+	size = (size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+	auto it = stagingFree.emplace(offset, size).first;
+
+	auto next = std::next(it);
+	if (next != stagingFree.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		stagingFree.erase(next);
+	}
+	if (it != stagingFree.begin()) {
+		auto previous = std::prev(it);
+		if (previous->first + previous->second == it->first) {
+			previous->second += it->second;
+			stagingFree.erase(it);
+		}
+	}
+}
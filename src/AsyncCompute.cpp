@@ -0,0 +1,218 @@
+#include "AsyncCompute.hpp"
+#include <algorithm>
+
+re::AsyncCompute::AsyncCompute(re::Device& device) : device(device), graphicsTimeline(device), computeTimeline(device)
+{
+	if (!device.enabledFeatures12.timelineSemaphore)
+		throw std::runtime_error("async compute needs timeline semaphores");
+
+	graphicsFamily = device.physicalDevice.queueFamily.graphics;
+	computeFamily = device.hasAsyncCompute() ? device.physicalDevice.queueFamily.compute : graphicsFamily;
+	graphicsQueue = device.queueHandles.graphics;
+	computeQueue = device.hasAsyncCompute() ? device.queueHandles.compute : graphicsQueue;
+
+	pool = std::make_shared<re::CommandPool>(device, computeFamily);
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+		cmds.push_back(pool->allocate());
+}
+
+re::AsyncCompute::~AsyncCompute(void)
+{
+	graphicsTimeline.wait(graphicsValue);
+	computeTimeline.wait(computeValue);
+}
+
+void re::AsyncCompute::share(re::Image& image, queueUse_s const& graphics, queueUse_s const& compute, bool discard)
+{
+	if (std::any_of(images.begin(), images.end(), [&image](shared_s const& shared) { return shared.image == &image; }))
+		throw std::runtime_error("image is already shared with the compute queue");
+	images.push_back({ &image, graphics, compute, OWNER_GRAPHICS, VK_IMAGE_LAYOUT_UNDEFINED, discard });
+}
+
+void re::AsyncCompute::unshare(re::Image& image)
+{
+	auto it = std::find_if(images.begin(), images.end(), [&image](shared_s const& shared) { return shared.image == &image; });
+
+	if (it == images.end())
+		return;
+	if (it->owner != OWNER_GRAPHICS)
+		throw std::runtime_error("unshared image is still owned by the compute queue");
+	images.erase(it);
+}
+
+// the release half runs on the queue giving the images up, the acquire half on the one taking them,
+// both describe the same layout transition; within one family only the release is needed, the semaphore orders the rest
+void re::AsyncCompute::recordTransfers(VkCommandBuffer cmd, owner_e from, owner_e to, bool release)
+{
+	bool toCompute = from == OWNER_GRAPHICS || from == OWNER_TO_COMPUTE;
+	std::vector<VkImageMemoryBarrier> barriers;
+	VkPipelineStageFlags stages = 0;
+
+	for (int i = 0; i < images.size(); i++) {
+		shared_s& shared = images[i];
+		if (shared.owner != from)
+			continue;
+		shared.owner = to;
+
+		queueUse_s const& source = toCompute ? shared.graphics : shared.compute;
+		queueUse_s const& destination = toCompute ? shared.compute : shared.graphics;
+		if (release)
+			shared.releasedLayout = shared.discard ? VK_IMAGE_LAYOUT_UNDEFINED : source.layout;
+		shared.discard = false;
+		if (!release && !isAsync())
+			continue;
+
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcAccessMask = release ? source.access : 0;
+		barrier.dstAccessMask = release ? 0 : destination.access;
+		barrier.oldLayout = shared.releasedLayout;
+		barrier.newLayout = destination.layout;
+		barrier.srcQueueFamilyIndex = isAsync() ? (toCompute ? graphicsFamily : computeFamily) : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = isAsync() ? (toCompute ? computeFamily : graphicsFamily) : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = shared.image->ptr;
+		barrier.subresourceRange = { shared.image->aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+		barriers.push_back(barrier);
+		stages |= release ? source.stage : destination.stage;
+	}
+
+	if (barriers.empty())
+		return;
+	// the acquire source stage is the semaphore wait stage so the two chain
+	vkCmdPipelineBarrier(cmd, stages, release ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : stages, 0,
+		0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void re::AsyncCompute::recordRelease(VkCommandBuffer cmd)
+{
+	recordTransfers(cmd, OWNER_GRAPHICS, OWNER_TO_COMPUTE, true);
+	pendingRelease = true;
+}
+
+void re::AsyncCompute::recordAcquire(VkCommandBuffer cmd)
+{
+	for (int i = 0; i < images.size(); i++) {
+		if (images[i].owner == OWNER_TO_COMPUTE || images[i].owner == OWNER_COMPUTE)
+			throw std::runtime_error("shared images acquired before the compute work was submitted");
+		if (images[i].owner == OWNER_TO_GRAPHICS)
+			pendingAcquireStages |= images[i].graphics.stage;
+	}
+	recordTransfers(cmd, OWNER_TO_GRAPHICS, OWNER_GRAPHICS, false);
+	pendingAcquire = true;
+}
+
+void re::AsyncCompute::submitBeforeAcquire(VkCommandBuffer cmd, std::vector<VkSemaphore> waits, std::vector<VkPipelineStageFlags> waitStages,
+	std::vector<VkSemaphore> signals, VkFence fence)
+{
+	if (pendingAcquire || pendingRelease)
+		throw std::runtime_error("submitBeforeAcquire after the frame's acquire or release was recorded");
+	submit(cmd, waits, waitStages, signals, fence, false);
+}
+
+void re::AsyncCompute::submitGraphics(VkCommandBuffer cmd, std::vector<VkSemaphore> waits, std::vector<VkPipelineStageFlags> waitStages,
+	std::vector<VkSemaphore> signals, VkFence fence)
+{
+	submit(cmd, waits, waitStages, signals, fence, true);
+}
+
+// the waits are taken by value, the timeline wait and signal of the transfers are appended to them
+void re::AsyncCompute::submit(VkCommandBuffer cmd, std::vector<VkSemaphore> waits, std::vector<VkPipelineStageFlags> waitStages,
+	std::vector<VkSemaphore> signals, VkFence fence, bool transfers)
+{
+	// binary semaphores ignore their values
+	std::vector<uint64_t> waitValues(waits.size(), 0);
+	std::vector<uint64_t> signalValues(signals.size(), 0);
+
+	if (transfers && pendingAcquireStages) {
+		waits.push_back(computeTimeline.ptr);
+		waitStages.push_back(pendingAcquireStages);
+		waitValues.push_back(computeValue);
+	}
+	if (transfers && pendingRelease) {
+		signals.push_back(graphicsTimeline.ptr);
+		signalValues.push_back(graphicsValue + 1);
+	}
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waits.size());
+	submitInfo.pWaitSemaphores = waits.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmd;
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
+	submitInfo.pSignalSemaphores = signals.data();
+
+	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit graphics work");
+
+	if (!transfers)
+		return;
+	if (pendingRelease)
+		graphicsValue++;
+	pendingRelease = false;
+	pendingAcquire = false;
+	pendingAcquireStages = 0;
+}
+
+VkCommandBuffer re::AsyncCompute::beginCompute(void)
+{
+	if (recording)
+		throw std::runtime_error("compute work already begun");
+
+	// the buffer was last submitted FRAMES_IN_FLIGHT submissions ago
+	if (computeValue >= FRAMES_IN_FLIGHT)
+		computeTimeline.wait(computeValue + 1 - FRAMES_IN_FLIGHT);
+
+	VkCommandBuffer cmd = cmds[computeValue % FRAMES_IN_FLIGHT];
+	VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkResetCommandBuffer(cmd, 0);
+	if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin compute command buffer");
+	recordTransfers(cmd, OWNER_TO_COMPUTE, OWNER_COMPUTE, false);
+	recording = cmd;
+	return cmd;
+}
+
+void re::AsyncCompute::submitCompute(void)
+{
+	if (!recording)
+		throw std::runtime_error("submitCompute without beginCompute");
+
+	VkCommandBuffer cmd = recording;
+	recording = nullptr;
+	recordTransfers(cmd, OWNER_COMPUTE, OWNER_TO_GRAPHICS, true);
+	if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+		throw std::runtime_error("failed to record compute command buffer");
+
+	// the queue only runs compute and transfers, waiting at every stage costs nothing
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	uint64_t signalValue = computeValue + 1;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+	timelineInfo.waitSemaphoreValueCount = 1;
+	timelineInfo.pWaitSemaphoreValues = &graphicsValue;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &graphicsTimeline.ptr;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmd;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &computeTimeline.ptr;
+
+	if (vkQueueSubmit(computeQueue, 1, &submitInfo, nullptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit compute work");
+	computeValue++;
+}
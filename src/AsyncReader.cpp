@@ -0,0 +1,221 @@
+#include "AsyncReader.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+#if defined(RE_ASYNC_IO_URING)
+
+re::AsyncReader::AsyncReader(uint32_t threadCount, uint32_t queueDepth) : queueDepth(queueDepth)
+{
+	(void)threadCount;
+	if (io_uring_queue_init(queueDepth, &ring, 0) < 0)
+		throw std::runtime_error("failed to create io_uring");
+}
+
+re::AsyncReader::~AsyncReader(void)
+{
+	// the kernel may still write into destinations, drain before tearing down
+	while (submitted) {
+		io_uring_cqe* cqe = nullptr;
+		if (io_uring_wait_cqe(&ring, &cqe) < 0)
+			break;
+		delete static_cast<request_s*>(io_uring_cqe_get_data(cqe));
+		io_uring_cqe_seen(&ring, cqe);
+		submitted--;
+	}
+	io_uring_queue_exit(&ring);
+	for (int i = 0; i < pending.size(); i++)
+		delete pending[i];
+	for (int i = 0; i < files.size(); i++)
+		close(static_cast<int>(files[i]));
+}
+
+void re::AsyncReader::read(uint32_t file, uint64_t offset, size_t size, void* destination, std::function<void(bool)> callback)
+{
+	pending.push_back(new request_s{ file, offset, size, 0, static_cast<uint8_t*>(destination), std::move(callback), true });
+	inflight++;
+	submitPending();
+}
+
+void re::AsyncReader::submitPending(void)
+{
+	uint32_t count = 0;
+
+	while (!pending.empty() && submitted < queueDepth) {
+		io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+		if (!sqe)
+			break;
+		request_s* request = pending.front();
+		pending.pop_front();
+		io_uring_prep_read(sqe, static_cast<int>(files[request->file]), request->destination + request->done,
+			static_cast<unsigned>(request->size - request->done), request->offset + request->done);
+		io_uring_sqe_set_data(sqe, request);
+		submitted++;
+		count++;
+	}
+	if (count)
+		io_uring_submit(&ring);
+}
+
+// short reads go back to the submission queue for the remainder
+size_t re::AsyncReader::poll(void)
+{
+	io_uring_cqe* cqe = nullptr;
+
+	while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+		request_s* request = static_cast<request_s*>(io_uring_cqe_get_data(cqe));
+		int result = cqe->res;
+		io_uring_cqe_seen(&ring, cqe);
+		submitted--;
+
+		if (result > 0 && request->done + result < request->size) {
+			request->done += result;
+			pending.push_front(request);
+			continue;
+		}
+		request->ok = result > 0 || (result == 0 && request->done == request->size);
+		completed.push_back(request);
+	}
+	submitPending();
+
+	std::vector<request_s*> finished;
+	finished.swap(completed);
+	for (int i = 0; i < finished.size(); i++) {
+		finished[i]->callback(finished[i]->ok);
+		delete finished[i];
+	}
+	inflight -= finished.size();
+	return finished.size();
+}
+
+#else
+
+re::AsyncReader::AsyncReader(uint32_t threadCount, uint32_t queueDepth)
+{
+	(void)queueDepth;
+	for (uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+		workers.emplace_back(&AsyncReader::workerLoop, this);
+}
+
+re::AsyncReader::~AsyncReader(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	for (int i = 0; i < pending.size(); i++)
+		delete pending[i];
+	for (int i = 0; i < completed.size(); i++)
+		delete completed[i];
+	for (int i = 0; i < files.size(); i++)
+#if defined(_WIN32)
+		CloseHandle(reinterpret_cast<HANDLE>(files[i]));
+#else
+		close(static_cast<int>(files[i]));
+#endif
+}
+
+void re::AsyncReader::read(uint32_t file, uint64_t offset, size_t size, void* destination, std::function<void(bool)> callback)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(new request_s{ file, offset, size, 0, static_cast<uint8_t*>(destination), std::move(callback), true });
+	}
+	inflight++;
+	condition.notify_one();
+}
+
+size_t re::AsyncReader::poll(void)
+{
+	std::vector<request_s*> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.swap(completed);
+	}
+	for (int i = 0; i < finished.size(); i++) {
+		finished[i]->callback(finished[i]->ok);
+		delete finished[i];
+	}
+	inflight -= finished.size();
+	return finished.size();
+}
+
+void re::AsyncReader::workerLoop(void)
+{
+	for (;;) {
+		request_s* request = nullptr;
+		intptr_t file = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return !running || !pending.empty(); });
+			if (!running)
+				return;
+			request = pending.front();
+			pending.pop_front();
+			file = files[request->file];
+		}
+		request->ok = readBlocking(*request, file);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			completed.push_back(request);
+		}
+	}
+}
+
+bool re::AsyncReader::readBlocking(request_s& request, intptr_t file)
+{
+	while (request.done < request.size) {
+#if defined(_WIN32)
+		OVERLAPPED overlapped{};
+		uint64_t offset = request.offset + request.done;
+		DWORD chunk = static_cast<DWORD>(std::min<size_t>(request.size - request.done, 1u << 30));
+		DWORD read = 0;
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		if (!ReadFile(reinterpret_cast<HANDLE>(file), request.destination + request.done, chunk, &read, &overlapped) || !read)
+			return false;
+#else
+		ssize_t read = pread(static_cast<int>(file), request.destination + request.done, request.size - request.done, request.offset + request.done);
+		if (read < 0 && errno == EINTR)
+			continue;
+		if (read <= 0)
+			return false;
+#endif
+		request.done += read;
+	}
+	return true;
+}
+
+#endif
+
+// files are opened up front, the list is only touched by the owning thread
+uint32_t re::AsyncReader::open(std::string const& path)
+{
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("failed to open file: " + path);
+	std::lock_guard<std::mutex> lock(mutex);
+	files.push_back(reinterpret_cast<intptr_t>(handle));
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("failed to open file: " + path);
+	std::lock_guard<std::mutex> lock(mutex);
+	files.push_back(fd);
+#endif
+	return static_cast<uint32_t>(files.size() - 1);
+}
@@ -0,0 +1,339 @@
+#include "Bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Utils.hpp"
+#include "JobSystem.hpp"
+#include "Scene.hpp"
+#include "Culling.hpp"
+#include "RathalosEngine.hpp"
+#include "CommandPool.hpp"
+#include "ParticleSystem.hpp"
+
+static constexpr int iterations = 20;
+
+// average milliseconds per run, after one warm up run
+template <typename F>
+static double measure(F&& function)
+{
+	function();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+		function();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+// result is what the run produced, the same across the versions of a benchmark
+static void report(std::string const& name, double milliseconds, size_t result)
+{
+	std::cout << TAB << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(10) << milliseconds << " ms" << TAB << result << std::endl;
+}
+
+static glm::mat4 composeTrs(glm::vec3 const& position, glm::quat const& rotation, float scale)
+{
+	glm::mat4 world = glm::mat4_cast(rotation) * scale;
+	world[3] = glm::vec4(position, 1.0f);
+	return world;
+}
+
+static bool sphereVisible(re::Frustum const& frustum, glm::vec3 const& center, float radius)
+{
+	for (int i = 0; i < 6; i++)
+		if (glm::dot(glm::vec3(frustum.planes[i]), center) + frustum.planes[i].w < -radius)
+			return false;
+	return true;
+}
+
+// one frame of transform update, sphere culling and draw collection over a scene
+namespace ecsBench {
+
+	struct transform_s {
+		glm::vec3 position;
+		float scale;
+		glm::quat rotation;
+	};
+
+	struct world_s {
+		glm::mat4 matrix;
+	};
+
+	struct bounds_s {
+		glm::vec3 center;
+		float radius;
+	};
+
+	struct renderable_s {
+		uint32_t mesh;
+		uint32_t material;
+	};
+
+	struct draw_s {
+		uint32_t mesh;
+		uint32_t material;
+		uint32_t object;
+	};
+
+	// the naive version: heap nodes owning their children, allocated out of traversal order
+	struct node_s {
+		transform_s local;
+		glm::mat4 world;
+		bounds_s bounds;
+		renderable_s renderable;
+		bool drawable = false;
+		uint32_t object = 0;
+		std::vector<node_s*> children;
+	};
+
+	static void updateNode(node_s* node, glm::mat4 const& parent, re::Frustum const& frustum, std::vector<draw_s>& draws)
+	{
+		node->world = parent * composeTrs(node->local.position, node->local.rotation, node->local.scale);
+		if (node->drawable) {
+			glm::vec3 center = glm::vec3(node->world * glm::vec4(node->bounds.center, 1.0f));
+			if (sphereVisible(frustum, center, node->bounds.radius * node->local.scale))
+				draws.push_back({ node->renderable.mesh, node->renderable.material, node->object });
+		}
+		for (int i = 0; i < node->children.size(); i++)
+			updateNode(node->children[i], node->world, frustum, draws);
+	}
+}
+
+static void benchEcs(void)
+{
+	using namespace ecsBench;
+	constexpr uint32_t objectCount = 250000;
+	constexpr uint32_t groupSize = 250;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<transform_s> transforms(objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+		transforms[i] = { glm::vec3(position(random), position(random), position(random)), 1.0f + unit(random) * 0.5f,
+			glm::normalize(glm::quat(1.0f, unit(random), unit(random), unit(random))) };
+
+	glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	re::Frustum frustum = re::Frustum::fromMatrix(projection * glm::lookAtRH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+	// groups of identity transforms under a root, so both versions compute the same matrices
+	std::vector<std::unique_ptr<node_s>> nodes;
+	std::vector<node_s*> leaves;
+	for (uint32_t i = 0; i < objectCount; i++) {
+		nodes.push_back(std::make_unique<node_s>());
+		node_s* node = nodes.back().get();
+		node->local = transforms[i];
+		node->bounds = { glm::vec3(0.0f), 1.0f };
+		node->renderable = { i % 64, i % 16 };
+		node->drawable = true;
+		node->object = i;
+		leaves.push_back(node);
+	}
+	std::shuffle(leaves.begin(), leaves.end(), random);
+	node_s root{ { glm::vec3(0.0f), 1.0f, glm::quat(1.0f, 0.0f, 0.0f, 0.0f) } };
+	for (uint32_t i = 0; i < objectCount; i += groupSize) {
+		nodes.push_back(std::make_unique<node_s>());
+		node_s* group = nodes.back().get();
+		group->local = root.local;
+		group->children.assign(leaves.begin() + i, leaves.begin() + std::min(i + groupSize, objectCount));
+		root.children.push_back(group);
+	}
+
+	re::Scene scene;
+	for (uint32_t i = 0; i < objectCount; i++)
+		scene.create(transforms[i], world_s{}, bounds_s{ glm::vec3(0.0f), 1.0f }, renderable_s{ i % 64, i % 16 });
+	re::JobSystem jobs;
+
+	std::vector<draw_s> draws;
+	draws.reserve(objectCount);
+	auto updateChunk = [&frustum](uint32_t count, re::Entity const* entities, transform_s* transforms, world_s* worlds,
+		bounds_s* bounds, renderable_s* renderables, draw_s* out) {
+		uint32_t written = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			worlds[i].matrix = composeTrs(transforms[i].position, transforms[i].rotation, transforms[i].scale);
+			glm::vec3 center = glm::vec3(worlds[i].matrix * glm::vec4(bounds[i].center, 1.0f));
+			if (sphereVisible(frustum, center, bounds[i].radius * transforms[i].scale))
+				out[written++] = { renderables[i].mesh, renderables[i].material, entities[i].index };
+		}
+		return written;
+	};
+
+	std::cout << "ecs, " << objectCount << " objects: transform update, sphere culling and draw collection" << std::endl;
+	double time = measure([&]() {
+		draws.clear();
+		ecsBench::updateNode(&root, glm::mat4(1.0f), frustum, draws);
+	});
+	report("aos scene graph", time, draws.size());
+
+	time = measure([&]() {
+		draws.resize(objectCount);
+		size_t count = 0;
+		scene.eachChunk<transform_s, world_s, bounds_s, renderable_s>([&](uint32_t n, re::Entity const* entities,
+			transform_s* t, world_s* w, bounds_s* b, renderable_s* r) {
+			count += updateChunk(n, entities, t, w, b, r, draws.data() + count);
+		});
+		draws.resize(count);
+	});
+	report("ecs chunks", time, draws.size());
+
+	time = measure([&]() {
+		std::atomic<size_t> count{ 0 };
+		draws.resize(objectCount);
+		scene.parallelEachChunk<transform_s, world_s, bounds_s, renderable_s>(jobs, [&](uint32_t n, re::Entity const* entities,
+			transform_s* t, world_s* w, bounds_s* b, renderable_s* r) {
+			draw_s local[re::CHUNK_SIZE / sizeof(transform_s)];
+			uint32_t written = updateChunk(n, entities, t, w, b, r, local);
+			std::copy(local, local + written, draws.data() + count.fetch_add(written));
+		});
+		draws.resize(count);
+	});
+	report("ecs chunks on " + std::to_string(jobs.getThreadCount()) + " threads", time, draws.size());
+}
+
+// the glm loop against the SIMD one, then the SIMD one per chunk on the job system
+static void benchCulling(void)
+{
+	constexpr uint32_t objectCount = 1 << 20;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+	re::SphereArray spheres;
+	re::AabbArray boxes;
+	for (uint32_t i = 0; i < objectCount; i++) {
+		glm::vec3 center(position(random), position(random), position(random));
+		glm::vec3 half(extent(random), extent(random), extent(random));
+		spheres.push_back(center, glm::length(half));
+		boxes.push_back(center - half, center + half);
+	}
+
+	glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	re::Frustum frustum = re::Frustum::fromMatrix(projection * glm::lookAtRH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	re::JobSystem jobs;
+	std::vector<uint32_t> visible(objectCount);
+	size_t count = 0;
+	double time;
+
+	std::cout << "culling, " << objectCount << " objects" << std::endl;
+	time = measure([&]() { count = re::cullSpheresScalar(frustum, spheres, 0, objectCount, visible.data()); });
+	report("spheres scalar", time, count);
+	time = measure([&]() { count = re::cullSpheres(frustum, spheres, 0, objectCount, visible.data()); });
+	report("spheres simd", time, count);
+	time = measure([&]() { re::cullSpheres(jobs, frustum, spheres, visible); });
+	report("spheres simd on " + std::to_string(jobs.getThreadCount()) + " threads", time, visible.size());
+
+	visible.resize(objectCount);
+	time = measure([&]() { count = re::cullAabbsScalar(frustum, boxes, 0, objectCount, visible.data()); });
+	report("aabbs scalar", time, count);
+	time = measure([&]() { count = re::cullAabbs(frustum, boxes, 0, objectCount, visible.data()); });
+	report("aabbs simd", time, count);
+	time = measure([&]() { re::cullAabbs(jobs, frustum, boxes, visible); });
+	report("aabbs simd on " + std::to_string(jobs.getThreadCount()) + " threads", time, visible.size());
+}
+
+// gpu time of the particle passes from timestamps around record, the first frame emits every particle
+static void benchParticles(void)
+{
+	constexpr uint32_t particleCount = 1 << 20;
+
+	re::RathalosEngine engine;
+	re::Device& device = engine.device;
+	uint32_t family = device.physicalDevice.queueFamily.graphics;
+	uint32_t validBits = device.physicalDevice.queueFamilyProperties[family].timestampValidBits;
+	if (!validBits)
+		throw std::runtime_error("the graphics queue does not support timestamps");
+	uint64_t mask = validBits == 64 ? ~0ull : (1ull << validBits) - 1;
+	double period = device.physicalDevice.properties.limits.timestampPeriod;
+
+	re::ParticleSystem particles(device, engine.pipelines, particleCount);
+	re::CommandPool pool(device, family);
+	re::Fence fence(device);
+	VkCommandBuffer cmd = pool.allocate();
+
+	VkQueryPoolCreateInfo queryInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+	queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryInfo.queryCount = 2;
+	VkQueryPool queries = nullptr;
+	if (vkCreateQueryPool(device.ptr, &queryInfo, nullptr, &queries) != VK_SUCCESS)
+		throw std::runtime_error("failed to create query pool");
+
+	// the particles outlive the run so every frame simulates and sorts all of them
+	re::particleEmitter_s emitter;
+	emitter.radius = 50.0f;
+	emitter.spread = 5.0f;
+	emitter.minLifetime = 1000.0f;
+	emitter.maxLifetime = 1000.0f;
+	particles.setCamera(glm::vec3(0.0f, 0.0f, 100.0f));
+
+	auto frame = [&]() -> double {
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("failed to begin command buffer");
+		vkCmdResetQueryPool(cmd, queries, 0, 2);
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries, 0);
+		particles.record(cmd, 1.0f / 60.0f);
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries, 1);
+		if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+			throw std::runtime_error("failed to end command buffer");
+
+		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmd;
+		if (vkQueueSubmit(device.queueHandles.graphics, 1, &submitInfo, fence.ptr) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit command buffer");
+		fence.wait();
+		fence.reset();
+
+		uint64_t timestamps[2];
+		if (vkGetQueryPoolResults(device.ptr, queries, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+			throw std::runtime_error("failed to get query results");
+		return ((timestamps[1] - timestamps[0]) & mask) * period / 1e6;
+	};
+
+	std::cout << "particles, " << particleCount << " particles, " << particles.getSortDispatchCount() << " sort dispatches" << std::endl;
+	try {
+		particles.emit(emitter, particleCount);
+		report("emit, simulate and sort (gpu)", frame(), particleCount);
+
+		frame();
+		double time = 0.0;
+		for (int i = 0; i < iterations; i++)
+			time += frame();
+		report("simulate and sort (gpu)", time / iterations, particleCount);
+	}
+	catch (...) {
+		vkDestroyQueryPool(device.ptr, queries, nullptr);
+		throw;
+	}
+	vkDestroyQueryPool(device.ptr, queries, nullptr);
+}
+
+void re::runBenchmark(std::string const& name)
+{
+	static std::map<std::string, void (*)(void)> const benchmarks{
+		{ "ecs", benchEcs },
+		{ "culling", benchCulling },
+		{ "particles", benchParticles }
+	};
+
+	auto it = benchmarks.find(name);
+	if (it == benchmarks.end()) {
+		std::string names;
+		for (auto const& benchmark : benchmarks)
+			names += " " + benchmark.first;
+		throw std::runtime_error("unknown benchmark: " + name + ", available:" + names);
+	}
+	it->second();
+}
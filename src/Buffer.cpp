@@ -0,0 +1,42 @@
+#include "Buffer.hpp"
+#include <cstring>
+
+re::Buffer::Buffer(re::Device& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) : size(size), device(device)
+{
+	VkBufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	createInfo.size = size;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create buffer");
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device.ptr, ptr, &requirements);
+
+	VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = device.physicalDevice.findMemoryType(requirements.memoryTypeBits, properties);
+
+	if (vkAllocateMemory(device.ptr, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate buffer memory");
+	vkBindBufferMemory(device.ptr, ptr, memory, 0);
+
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		vkMapMemory(device.ptr, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+}
+
+re::Buffer::~Buffer(void)
+{
+	if (mapped)
+		vkUnmapMemory(device.ptr, memory);
+	vkDestroyBuffer(device.ptr, ptr, nullptr);
+	vkFreeMemory(device.ptr, memory, nullptr);
+}
+
+void re::Buffer::upload(void const* data, VkDeviceSize size, VkDeviceSize offset)
+{
+	if (!mapped)
+		throw std::runtime_error("buffer is not host visible");
+	std::memcpy(static_cast<char*>(mapped) + offset, data, size);
+}
@@ -0,0 +1,138 @@
+#include "ClusteredLighting.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t groupSize = 128;
+
+re::ClusteredLighting::ClusteredLighting(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxLights, uint32_t averageLightsPerCluster)
+	: device(device), maxLights(maxLights), averageLightsPerCluster(averageLightsPerCluster)
+{
+	// written by record in the frame's command buffer, never while an earlier frame may still read them
+	infoBuffer = std::make_shared<re::Buffer>(device, sizeof(clusterInfo_s),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	lightBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuLight_s) * maxLights,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	counterBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// the shading passes bind the same set, only the counter stays compute side
+	std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr };
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }
+	});
+	set = pool->allocate(*setLayout);
+
+	re::writeDescriptor(device, set, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, *infoBuffer);
+	re::writeDescriptor(device, set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *lightBuffer);
+	re::writeDescriptor(device, set, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *counterBuffer);
+
+	shader = pipelines.getShader(SHADER_PATH "light_cull.comp.spv");
+	pipeline = pipelines.getCompute(SHADER_PATH "light_cull.comp.spv", pipelines.getLayouts().getPipelineLayout({ setLayout }, {}));
+}
+
+re::ClusteredLighting::~ClusteredLighting(void)
+{
+	if (watcher)
+		watcher->remove(this);
+}
+
+void re::ClusteredLighting::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	watcher.watch(device, SHADER_PATH "light_cull.comp.spv", this, shader, pipeline);
+}
+
+void re::ClusteredLighting::resize(VkExtent2D extent)
+{
+	glm::uvec3 grid((extent.width + tileSize - 1) / tileSize, (extent.height + tileSize - 1) / tileSize, depthSlices);
+	uint32_t clusterCount = grid.x * grid.y * grid.z;
+
+	clusterBuffer = std::make_shared<re::Buffer>(device, sizeof(glm::uvec2) * clusterCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	indexBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t) * clusterCount * averageLightsPerCluster,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	re::writeDescriptor(device, set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *clusterBuffer);
+	re::writeDescriptor(device, set, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *indexBuffer);
+
+	info.grid = glm::uvec4(grid, info.grid.w);
+	info.screen = glm::vec4(extent.width, extent.height, tileSize, 0.0f);
+	infoPending = true;
+}
+
+void re::ClusteredLighting::setLights(std::vector<gpuLight_s> const& lights)
+{
+	if (lights.size() > maxLights)
+		throw std::runtime_error("too many lights for clustered lighting");
+
+	this->lights = lights;
+	info.grid.w = static_cast<uint32_t>(lights.size());
+	lightsPending = true;
+	infoPending = true;
+}
+
+// slice = log(depth) * slices / log(far / near) - slices * log(near) / log(far / near), the slices grow with the depth like the perspective
+void re::ClusteredLighting::setView(glm::mat4 const& view, glm::mat4 const& projection, float znear, float zfar)
+{
+	float logRange = std::log(zfar / znear);
+
+	info.view = view;
+	info.projection = glm::vec4(1.0f / projection[0][0], 1.0f / projection[1][1], znear, zfar);
+	info.slicing = glm::vec4(depthSlices / logRange, depthSlices * std::log(znear) / logRange, 0.0f, 0.0f);
+	infoPending = true;
+}
+
+// vkCmdUpdateBuffer takes at most 65536 bytes, the lights go in chunks
+void re::ClusteredLighting::upload(VkCommandBuffer cmd)
+{
+	constexpr VkDeviceSize maxUpdate = 65536;
+
+	if (infoPending)
+		vkCmdUpdateBuffer(cmd, infoBuffer->ptr, 0, sizeof(info), &info);
+	if (lightsPending) {
+		VkDeviceSize size = lights.size() * sizeof(gpuLight_s);
+		for (VkDeviceSize offset = 0; offset < size; offset += maxUpdate)
+			vkCmdUpdateBuffer(cmd, lightBuffer->ptr, offset, std::min(size - offset, maxUpdate),
+				reinterpret_cast<char const*>(lights.data()) + offset);
+	}
+	infoPending = false;
+	lightsPending = false;
+}
+
+void re::ClusteredLighting::record(VkCommandBuffer cmd)
+{
+	if (!clusterBuffer)
+		throw std::runtime_error("ClusteredLighting needs resize before record");
+
+	uint32_t clusterCount = info.grid.x * info.grid.y * info.grid.z;
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+
+	// the previous frame's culling and shading are done with the lists, the lights and the view
+	barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	upload(cmd);
+	vkCmdFillBuffer(cmd, counterBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+
+	// the shading passes read the lights and the view too
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->ptr);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set, 0, nullptr);
+	vkCmdDispatch(cmd, (clusterCount + groupSize - 1) / groupSize, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
@@ -0,0 +1,101 @@
+#include "CommandPool.hpp"
+
+re::CommandPool::CommandPool(re::Device& device, uint32_t queueFamily, VkCommandPoolCreateFlags flags) : queueFamily(queueFamily), device(device)
+{
+	VkCommandPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	createInfo.flags = flags;
+	createInfo.queueFamilyIndex = queueFamily;
+
+	if (vkCreateCommandPool(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create command pool");
+}
+
+re::CommandPool::~CommandPool(void)
+{
+	vkDestroyCommandPool(device.ptr, ptr, nullptr);
+}
+
+VkCommandBuffer re::CommandPool::allocate(VkCommandBufferLevel level)
+{
+	VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	VkCommandBuffer cmd = nullptr;
+
+	allocInfo.commandPool = ptr;
+	allocInfo.level = level;
+	allocInfo.commandBufferCount = 1;
+
+	if (vkAllocateCommandBuffers(device.ptr, &allocInfo, &cmd) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate command buffer");
+	return cmd;
+}
+
+void re::CommandPool::free(VkCommandBuffer cmd)
+{
+	vkFreeCommandBuffers(device.ptr, ptr, 1, &cmd);
+}
+
+re::Fence::Fence(re::Device& device, bool signaled) : device(device)
+{
+	VkFenceCreateInfo createInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	createInfo.flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+
+	if (vkCreateFence(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create fence");
+}
+
+re::Fence::~Fence(void)
+{
+	vkDestroyFence(device.ptr, ptr, nullptr);
+}
+
+void re::Fence::wait(uint64_t timeout)
+{
+	vkWaitForFences(device.ptr, 1, &ptr, VK_TRUE, timeout);
+}
+
+void re::Fence::reset(void)
+{
+	vkResetFences(device.ptr, 1, &ptr);
+}
+
+re::TimelineSemaphore::TimelineSemaphore(re::Device& device, uint64_t initialValue) : device(device)
+{
+	VkSemaphoreTypeCreateInfo typeInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+	createInfo.pNext = &typeInfo;
+
+	if (vkCreateSemaphore(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create timeline semaphore");
+}
+
+re::TimelineSemaphore::~TimelineSemaphore(void)
+{
+	vkDestroySemaphore(device.ptr, ptr, nullptr);
+}
+
+uint64_t re::TimelineSemaphore::getValue(void) const
+{
+	uint64_t value = 0;
+	vkGetSemaphoreCounterValue(device.ptr, ptr, &value);
+	return value;
+}
+
+void re::TimelineSemaphore::wait(uint64_t value, uint64_t timeout)
+{
+	VkSemaphoreWaitInfo waitInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &ptr;
+	waitInfo.pValues = &value;
+	vkWaitSemaphores(device.ptr, &waitInfo, timeout);
+}
+
+void re::TimelineSemaphore::signal(uint64_t value)
+{
+	VkSemaphoreSignalInfo signalInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO };
+	signalInfo.semaphore = ptr;
+	signalInfo.value = value;
+	vkSignalSemaphore(device.ptr, &signalInfo);
+}
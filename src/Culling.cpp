@@ -0,0 +1,229 @@
+#include "Culling.hpp"
+#include <bit>
+#include <algorithm>
+#include <functional>
+
+// 8 objects per plane test with AVX, which the project's /arch:AVX2 enables, 4 with SSE otherwise
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define RE_CULLING_AVX
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define RE_CULLING_SSE
+#endif
+
+static constexpr size_t chunkSize = 16384;
+
+re::Frustum re::Frustum::fromMatrix(glm::mat4 const& m)
+{
+	Frustum frustum;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	// vulkan clip space, 0 <= z <= w
+	frustum.planes[0] = row3 + row0;
+	frustum.planes[1] = row3 - row0;
+	frustum.planes[2] = row3 + row1;
+	frustum.planes[3] = row3 - row1;
+	frustum.planes[4] = row2;
+	frustum.planes[5] = row3 - row2;
+
+	for (int i = 0; i < 6; i++)
+		frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+	return frustum;
+}
+
+void re::SphereArray::push_back(glm::vec3 const& center, float r)
+{
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	radius.push_back(r);
+}
+
+void re::AabbArray::push_back(glm::vec3 const& min, glm::vec3 const& max)
+{
+	minX.push_back(min.x);
+	minY.push_back(min.y);
+	minZ.push_back(min.z);
+	maxX.push_back(max.x);
+	maxY.push_back(max.y);
+	maxZ.push_back(max.z);
+}
+
+size_t re::cullSpheresScalar(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* out)
+{
+	size_t count = 0;
+
+	for (size_t i = begin; i < end; i++) {
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			visible = glm::dot(glm::vec3(plane), glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i])) + plane.w >= -spheres.radius[i];
+		}
+		if (visible)
+			out[count++] = static_cast<uint32_t>(i);
+	}
+	return count;
+}
+
+// per box and plane, only the corner furthest along the plane normal is tested, a box is culled once that corner is outside
+size_t re::cullAabbsScalar(Frustum const& frustum, AabbArray const& boxes, size_t begin, size_t end, uint32_t* out)
+{
+	size_t count = 0;
+
+	for (size_t i = begin; i < end; i++) {
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			glm::vec3 corner(
+				plane.x > 0.0f ? boxes.maxX[i] : boxes.minX[i],
+				plane.y > 0.0f ? boxes.maxY[i] : boxes.minY[i],
+				plane.z > 0.0f ? boxes.maxZ[i] : boxes.minZ[i]
+			);
+			visible = glm::dot(glm::vec3(plane), corner) + plane.w >= 0.0f;
+		}
+		if (visible)
+			out[count++] = static_cast<uint32_t>(i);
+	}
+	return count;
+}
+
+static size_t compact(uint32_t mask, size_t base, uint32_t* out)
+{
+	size_t count = 0;
+
+	while (mask) {
+		out[count++] = static_cast<uint32_t>(base + std::countr_zero(mask));
+		mask &= mask - 1;
+	}
+	return count;
+}
+
+size_t re::cullSpheres(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* out)
+{
+	size_t count = 0;
+	size_t i = begin;
+
+#if defined(RE_CULLING_AVX)
+	for (; i + 8 <= end; i += 8) {
+		__m256 x = _mm256_loadu_ps(&spheres.x[i]);
+		__m256 y = _mm256_loadu_ps(&spheres.y[i]);
+		__m256 z = _mm256_loadu_ps(&spheres.z[i]);
+		__m256 r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			__m256 d = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w));
+			d = _mm256_add_ps(d, _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(plane.z)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, r, _CMP_GE_OQ));
+		}
+		count += compact(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, out + count);
+	}
+#elif defined(RE_CULLING_SSE)
+	for (; i + 4 <= end; i += 4) {
+		__m128 x = _mm_loadu_ps(&spheres.x[i]);
+		__m128 y = _mm_loadu_ps(&spheres.y[i]);
+		__m128 z = _mm_loadu_ps(&spheres.z[i]);
+		__m128 r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+		__m128 inside = _mm_cmpeq_ps(r, r);
+
+		for (int p = 0; p < 6; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			__m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+			d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+			d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, r));
+		}
+		count += compact(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, out + count);
+	}
+#endif
+
+	return count + cullSpheresScalar(frustum, spheres, i, end, out + count);
+}
+
+size_t re::cullAabbs(Frustum const& frustum, AabbArray const& boxes, size_t begin, size_t end, uint32_t* out)
+{
+	size_t count = 0;
+	size_t i = begin;
+
+#if defined(RE_CULLING_AVX) || defined(RE_CULLING_SSE)
+	float const* corners[6][3];
+	for (int p = 0; p < 6; p++) {
+		corners[p][0] = frustum.planes[p].x > 0.0f ? boxes.maxX.data() : boxes.minX.data();
+		corners[p][1] = frustum.planes[p].y > 0.0f ? boxes.maxY.data() : boxes.minY.data();
+		corners[p][2] = frustum.planes[p].z > 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+	}
+#endif
+
+#if defined(RE_CULLING_AVX)
+	for (; i + 8 <= end; i += 8) {
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			__m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(corners[p][0] + i), _mm256_set1_ps(plane.x)), _mm256_set1_ps(plane.w));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(corners[p][1] + i), _mm256_set1_ps(plane.y)));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(corners[p][2] + i), _mm256_set1_ps(plane.z)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		count += compact(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, out + count);
+	}
+#elif defined(RE_CULLING_SSE)
+	for (; i + 4 <= end; i += 4) {
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; p++) {
+			glm::vec4 const& plane = frustum.planes[p];
+			__m128 d = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(corners[p][0] + i), _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(corners[p][1] + i), _mm_set1_ps(plane.y)));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(corners[p][2] + i), _mm_set1_ps(plane.z)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+		}
+		count += compact(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, out + count);
+	}
+#endif
+
+	return count + cullAabbsScalar(frustum, boxes, i, end, out + count);
+}
+
+// every chunk writes at its own offset, the gaps are closed afterwards
+static void cullParallel(re::JobSystem& jobs, size_t total, std::vector<uint32_t>& visible, std::function<size_t(size_t, size_t, uint32_t*)> const& cull)
+{
+	size_t chunks = (total + chunkSize - 1) / chunkSize;
+	std::vector<size_t> counts(chunks);
+
+	visible.resize(total);
+	jobs.parallelFor(chunks, 1, [&](size_t first, size_t last) {
+		for (size_t c = first; c < last; c++) {
+			size_t begin = c * chunkSize;
+			counts[c] = cull(begin, std::min(begin + chunkSize, total), visible.data() + begin);
+		}
+	});
+
+	size_t offset = 0;
+	for (size_t c = 0; c < chunks; c++) {
+		if (offset != c * chunkSize)
+			std::copy(visible.begin() + c * chunkSize, visible.begin() + c * chunkSize + counts[c], visible.begin() + offset);
+		offset += counts[c];
+	}
+	visible.resize(offset);
+}
+
+void re::cullSpheres(re::JobSystem& jobs, Frustum const& frustum, SphereArray const& spheres, std::vector<uint32_t>& visible)
+{
+	cullParallel(jobs, spheres.size(), visible, [&](size_t begin, size_t end, uint32_t* out) {
+		return cullSpheres(frustum, spheres, begin, end, out);
+	});
+}
+
+void re::cullAabbs(re::JobSystem& jobs, Frustum const& frustum, AabbArray const& boxes, std::vector<uint32_t>& visible)
+{
+	cullParallel(jobs, boxes.size(), visible, [&](size_t begin, size_t end, uint32_t* out) {
+		return cullAabbs(frustum, boxes, begin, end, out);
+	});
+}
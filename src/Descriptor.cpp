@@ -0,0 +1,71 @@
+#include "Descriptor.hpp"
+
+re::DescriptorSetLayout::DescriptorSetLayout(re::Device& device, std::vector<VkDescriptorSetLayoutBinding> const& bindings) : bindings(bindings), device(device)
+{
+	VkDescriptorSetLayoutCreateInfo createInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	createInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create descriptor set layout");
+}
+
+re::DescriptorSetLayout::~DescriptorSetLayout(void)
+{
+	vkDestroyDescriptorSetLayout(device.ptr, ptr, nullptr);
+}
+
+re::DescriptorPool::DescriptorPool(re::Device& device, uint32_t maxSets, std::vector<VkDescriptorPoolSize> const& sizes) : device(device)
+{
+	VkDescriptorPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	createInfo.maxSets = maxSets;
+	createInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+	createInfo.pPoolSizes = sizes.data();
+
+	if (vkCreateDescriptorPool(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create descriptor pool");
+}
+
+re::DescriptorPool::~DescriptorPool(void)
+{
+	vkDestroyDescriptorPool(device.ptr, ptr, nullptr);
+}
+
+VkDescriptorSet re::DescriptorPool::allocate(re::DescriptorSetLayout& layout)
+{
+	VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	VkDescriptorSet set = nullptr;
+
+	allocInfo.descriptorPool = ptr;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout.ptr;
+
+	if (vkAllocateDescriptorSets(device.ptr, &allocInfo, &set) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate descriptor set");
+	return set;
+}
+
+void re::writeDescriptor(re::Device& device, VkDescriptorSet set, uint32_t binding, VkDescriptorType type, re::Buffer& buffer)
+{
+	VkDescriptorBufferInfo info = buffer.getDescriptorInfo();
+	VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+
+	write.dstSet = set;
+	write.dstBinding = binding;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pBufferInfo = &info;
+	vkUpdateDescriptorSets(device.ptr, 1, &write, 0, nullptr);
+}
+
+void re::writeDescriptor(re::Device& device, VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkDescriptorImageInfo const& image)
+{
+	VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+
+	write.dstSet = set;
+	write.dstBinding = binding;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pImageInfo = &image;
+	vkUpdateDescriptorSets(device.ptr, 1, &write, 0, nullptr);
+}
@@ -11,18 +11,21 @@ re::Device::Device(re::Instance& instance, re::Surface &surface) : instance(inst
 	std::vector<char const*> extensions = getExtensions();
 
 	VkDeviceCreateInfo createInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-	VkPhysicalDeviceFeatures deviceFeatures{};
 
+	getFeatures();
+
+	createInfo.pNext = &enabledFeatures;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	createInfo.ppEnabledExtensionNames = extensions.data();
-	createInfo.pEnabledFeatures = &deviceFeatures;
+	createInfo.pEnabledFeatures = nullptr;
 
 	if (vkCreateDevice(physicalDevice.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
 		throw std::runtime_error("failed to create device");
 
 	getQueueHandles();
+	getFunctions();
 
 	createSwapChain();
 
@@ -67,12 +70,26 @@ void re::Device::getQueueHandles(void)
 		vkGetDeviceQueue(ptr, physicalDevice.queueFamily.transfer, 0, &queueHandles.transfer);
 }
 
+void re::Device::getFunctions(void)
+{
+	dynamicRendering = physicalDevice.supportsDynamicRendering();
+	if (!dynamicRendering)
+		return;
+
+	bool core = physicalDevice.properties.apiVersion >= VK_API_VERSION_1_3;
+	cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(ptr, core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR"));
+	cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(ptr, core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR"));
+	dynamicRendering = cmdBeginRendering && cmdEndRendering;
+}
+
 void re::PhysicalDevice::getQueueIndices(re::Instance& instance, re::Surface& surface)
 {
 	for (int i = 0; i < queueFamilyProperties.size(); i++) {
 		if (queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
 			queueFamily.graphics = i;
-		if (queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+		// a compute family without graphics runs next to the graphics queue, the graphics one is the fallback
+		if ((queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+			&& (queueFamily.compute == INVALID_UINT32 || !(queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)))
 			queueFamily.compute = i;
 		if (queueFamilyProperties[i].queueFlags & VK_QUEUE_TRANSFER_BIT)
 			queueFamily.transfer = i;
@@ -103,14 +120,65 @@ re::PhysicalDevice::PhysicalDevice(VkPhysicalDevice physicalDevice) : ptr(physic
 	queueFamilyProperties.resize(count);
 	vkGetPhysicalDeviceQueueFamilyProperties(ptr, &count, queueFamilyProperties.data());
 	vkGetPhysicalDeviceProperties(ptr, &properties);
-	vkGetPhysicalDeviceFeatures(ptr, &features);
+	vkGetPhysicalDeviceMemoryProperties(ptr, &memoryProperties);
+
+	vkEnumerateDeviceExtensionProperties(ptr, nullptr, &count, nullptr);
+	extensions.resize(count);
+	vkEnumerateDeviceExtensionProperties(ptr, nullptr, &count, extensions.data());
+
+	VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+	void** next = &features2.pNext;
+	if (properties.apiVersion >= VK_API_VERSION_1_2) {
+		*next = &features12;
+		next = &features12.pNext;
+	}
+	if (properties.apiVersion >= VK_API_VERSION_1_3)
+		*next = &features13;
+	else if (supportsExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		*next = &dynamicRenderingFeatures;
+	vkGetPhysicalDeviceFeatures2(ptr, &features2);
+	features = features2.features;
+	features12.pNext = nullptr;
+}
+
+bool re::PhysicalDevice::supportsExtension(char const* name) const
+{
+	for (int i = 0; i < extensions.size(); i++)
+		if (!std::strcmp(extensions[i].extensionName, name))
+			return true;
+	return false;
+}
+
+uint32_t re::PhysicalDevice::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags)
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		if ((typeBits & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+			return i;
+	throw std::runtime_error("failed to find suitable memory type");
+}
 
+bool re::PhysicalDevice::supportsBufferFormat(VkFormat format, VkFormatFeatureFlags features)
+{
+	VkFormatProperties formatProperties;
+
+	vkGetPhysicalDeviceFormatProperties(ptr, format, &formatProperties);
+	return (formatProperties.bufferFeatures & features) == features;
+}
+
+bool re::PhysicalDevice::supportsImageFormat(VkFormat format, VkFormatFeatureFlags features)
+{
+	VkFormatProperties formatProperties;
+
+	vkGetPhysicalDeviceFormatProperties(ptr, format, &formatProperties);
+	return (formatProperties.optimalTilingFeatures & features) == features;
 }
 
 bool re::PhysicalDevice::isSuitable(void)
 {
 	return (
 		features.geometryShader &&
+		// the culling passes write the instance id of each indirect draw as its firstInstance
+		features.drawIndirectFirstInstance &&
 		swapChainSupportDetails.presentModes.empty() == false &&
 		swapChainSupportDetails.formats.empty() == false &&
 		queueFamily.present != INVALID_UINT32 &&
@@ -123,23 +191,44 @@ std::vector<char const*> re::Device::getExtensions(void)
 	std::vector<char const*> extensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
-	uint32_t count = 0;
-	vkEnumerateDeviceExtensionProperties(physicalDevice.ptr, nullptr, &count, nullptr);
-	std::vector<VkExtensionProperties> properties(count);
-	vkEnumerateDeviceExtensionProperties(physicalDevice.ptr, nullptr, &count, properties.data());
-
-	for (int i = 0; i < extensions.size(); i++) {
-		bool found = false;
-		for (int j = 0; j < properties.size(); j++)
-			if (!std::strcmp(extensions[i], properties[j].extensionName))
-				found = true;
-		if (!found)
+
+	for (int i = 0; i < extensions.size(); i++)
+		if (!physicalDevice.supportsExtension(extensions[i]))
 			throw std::runtime_error("Device extension nout found: " + std::string(extensions[i]));
-	}
+
+	// optional, features without them have a fallback
+	if (physicalDevice.properties.apiVersion < VK_API_VERSION_1_3 && physicalDevice.dynamicRenderingFeatures.dynamicRendering)
+		extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
 
 	return extensions;
 }
 
+// only what the physical device reports is turned on, modules check enabledFeatures before relying on anything
+void re::Device::getFeatures(void)
+{
+	void** next = &enabledFeatures.pNext;
+	if (physicalDevice.properties.apiVersion >= VK_API_VERSION_1_2) {
+		*next = &enabledFeatures12;
+		next = &enabledFeatures12.pNext;
+	}
+	if (physicalDevice.properties.apiVersion >= VK_API_VERSION_1_3)
+		*next = &enabledFeatures13;
+	else if (physicalDevice.dynamicRenderingFeatures.dynamicRendering)
+		*next = &enabledDynamicRendering;
+
+	enabledFeatures.features.multiDrawIndirect = physicalDevice.features.multiDrawIndirect;
+	enabledFeatures.features.drawIndirectFirstInstance = VK_TRUE;
+	enabledFeatures.features.textureCompressionBC = physicalDevice.features.textureCompressionBC;
+	enabledFeatures.features.textureCompressionETC2 = physicalDevice.features.textureCompressionETC2;
+	enabledFeatures.features.textureCompressionASTC_LDR = physicalDevice.features.textureCompressionASTC_LDR;
+	enabledFeatures.features.sparseBinding = physicalDevice.features.sparseBinding;
+	enabledFeatures.features.sparseResidencyImage2D = physicalDevice.features.sparseResidencyImage2D;
+	enabledFeatures12.drawIndirectCount = physicalDevice.features12.drawIndirectCount;
+	enabledFeatures12.timelineSemaphore = physicalDevice.features12.timelineSemaphore;
+	enabledFeatures13.dynamicRendering = physicalDevice.features13.dynamicRendering;
+	enabledDynamicRendering.dynamicRendering = physicalDevice.dynamicRenderingFeatures.dynamicRendering;
+}
+
 std::vector<VkDeviceQueueCreateInfo> re::Device::getDeviceQueueCreateInfos(re::PhysicalDevice& ref)
 {
 	std::vector<VkDeviceQueueCreateInfo> createInfos;
@@ -227,9 +316,11 @@ void re::Device::dumpInfo(void)
 	std::cout << TERMINAL_COLOR_MAGENTA << "choosen GPU: " << physicalDevice.properties.deviceName << TERMINAL_COLOR_RESET << std::endl;
 	std::cout << TERMINAL_COLOR_YELLOW << "Queues available:" << TERMINAL_COLOR_RESET << std::endl;
 	std::cout << TAB << (queueHandles.graphics ? TERMINAL_COLOR_GREEN : TERMINAL_COLOR_RED) << "graphics queue" << std::endl;
-	std::cout << TAB << (queueHandles.compute ? TERMINAL_COLOR_GREEN : TERMINAL_COLOR_RED) << "compute queue" << std::endl;
+	std::cout << TAB << (queueHandles.compute ? TERMINAL_COLOR_GREEN : TERMINAL_COLOR_RED) << "compute queue" << (hasAsyncCompute() ? " (async)" : "") << std::endl;
 	std::cout << TAB << (queueHandles.present ? TERMINAL_COLOR_GREEN : TERMINAL_COLOR_RED) << "present queue" << std::endl;
 	std::cout << TAB << (queueHandles.transfer ? TERMINAL_COLOR_GREEN : TERMINAL_COLOR_RED) << "transfer queue" << std::endl;
+	std::cout << TERMINAL_COLOR_YELLOW << "Rendering:" << TERMINAL_COLOR_RESET << std::endl;
+	std::cout << TAB << TERMINAL_COLOR_GREEN << (dynamicRendering ? "dynamic rendering" : "render passes") << std::endl;
 
 
 	std::cout << TERMINAL_COLOR_YELLOW << "Present Modes available:" << TERMINAL_COLOR_GREEN << std::endl;
@@ -0,0 +1,114 @@
+#include "FrameArena.hpp"
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+static std::byte* alignUp(std::byte* p, size_t alignment)
+{
+	uintptr_t v = reinterpret_cast<uintptr_t>(p);
+	return reinterpret_cast<std::byte*>((v + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+}
+
+re::LinearArena::LinearArena(size_t blockSize) : blockSize(blockSize)
+{
+}
+
+re::LinearArena::~LinearArena(void)
+{
+	for (int i = 0; i < blocks.size(); i++)
+		::operator delete(blocks[i].data, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void* re::LinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+	std::byte* p = alignUp(cursor, alignment);
+
+	if (!cursor || p + bytes > end) {
+		grow(bytes, alignment);
+		p = alignUp(cursor, alignment);
+	}
+
+	bytesUsed += (p + bytes) - cursor;
+	bytesPeak = std::max(bytesPeak, bytesUsed);
+	cursor = p + bytes;
+	return p;
+}
+
+void re::LinearArena::grow(size_t bytes, size_t alignment)
+{
+	size_t needed = bytes + alignment;
+
+	for (current = cursor ? current + 1 : current; current < blocks.size(); current++) {
+		if (blocks[current].size >= needed) {
+			cursor = blocks[current].data;
+			end = cursor + blocks[current].size;
+			return;
+		}
+	}
+
+	size_t size = std::max(blockSize, needed);
+	std::byte* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(alignof(std::max_align_t))));
+	blocks.push_back({ data, size });
+	bytesReserved += size;
+	current = blocks.size() - 1;
+	cursor = data;
+	end = data + size;
+}
+
+void re::LinearArena::reset(void)
+{
+	// frames that spilled into several blocks get a single block big enough for the peak next time
+	if (blocks.size() > 1) {
+		for (int i = 0; i < blocks.size(); i++)
+			::operator delete(blocks[i].data, std::align_val_t(alignof(std::max_align_t)));
+		blocks.clear();
+		blockSize = std::max(blockSize, bytesReserved);
+		bytesReserved = 0;
+	}
+
+	current = 0;
+	bytesUsed = 0;
+	cursor = blocks.empty() ? nullptr : blocks[0].data;
+	end = blocks.empty() ? nullptr : blocks[0].data + blocks[0].size;
+}
+
+static std::atomic<uint64_t> frameArenaCount{ 0 };
+
+struct threadArenaSlot_s {
+	uint64_t owner;
+	re::LinearArena* arena;
+};
+
+static thread_local std::vector<threadArenaSlot_s> threadArenas;
+
+re::FrameArena::FrameArena(size_t blockSize) : blockSize(blockSize), id(++frameArenaCount)
+{
+}
+
+re::LinearArena& re::FrameArena::local(void)
+{
+	for (int i = 0; i < threadArenas.size(); i++)
+		if (threadArenas[i].owner == id)
+			return *threadArenas[i].arena;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	arenas.push_back(std::make_unique<LinearArena>(blockSize));
+	threadArenas.push_back({ id, arenas.rbegin()->get() });
+	return **arenas.rbegin();
+}
+
+void re::FrameArena::reset(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int i = 0; i < arenas.size(); i++)
+		arenas[i]->reset();
+}
+
+size_t re::FrameArena::used(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t total = 0;
+	for (int i = 0; i < arenas.size(); i++)
+		total += arenas[i]->used();
+	return total;
+}
@@ -0,0 +1,155 @@
+#include "GpuCulling.hpp"
+#include <algorithm>
+
+static constexpr uint32_t groupSize = 64;
+
+re::GpuCulling::GpuCulling(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxInstances, uint32_t maxMeshes, uint32_t maxMaterials) : device(device), maxInstances(maxInstances), maxMaterials(maxMaterials)
+{
+	VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkBufferUsageFlags indirect = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	drawCount = device.enabledFeatures12.drawIndirectCount;
+
+	instanceBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuInstance_s) * maxInstances, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	meshBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuMesh_s) * maxMeshes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	materialBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuMaterialRange_s) * maxMaterials, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	commandBuffer = std::make_shared<re::Buffer>(device, sizeof(VkDrawIndexedIndirectCommand) * maxInstances, indirect, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	countBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t) * maxMaterials, indirect, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 } });
+	set = pool->allocate(*setLayout);
+
+	re::Buffer* buffers[5] = { instanceBuffer.get(), meshBuffer.get(), materialBuffer.get(), commandBuffer.get(), countBuffer.get() };
+	for (uint32_t i = 0; i < 5; i++)
+		re::writeDescriptor(device, set, i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *buffers[i]);
+
+	shader = pipelines.getShader(SHADER_PATH "cull.comp.spv");
+	pipeline = pipelines.getCompute(SHADER_PATH "cull.comp.spv", pipelines.getLayouts().getPipelineLayout({ setLayout },
+		std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } }));
+}
+
+re::GpuCulling::~GpuCulling(void)
+{
+	if (watcher)
+		watcher->remove(this);
+}
+
+void re::GpuCulling::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	watcher.watch(device, SHADER_PATH "cull.comp.spv", this, shader, pipeline);
+}
+
+void re::GpuCulling::setMeshes(std::vector<gpuMesh_s> const& meshes)
+{
+	if (meshes.size() * sizeof(gpuMesh_s) > meshBuffer->size)
+		throw std::runtime_error("too many meshes for GPU culling");
+	meshBuffer->upload(meshes.data(), meshes.size() * sizeof(gpuMesh_s));
+}
+
+// each material gets a slice of the command buffer as large as its instance count
+void re::GpuCulling::setInstances(std::vector<gpuInstance_s> const& instances)
+{
+	if (instances.size() > maxInstances)
+		throw std::runtime_error("too many instances for GPU culling");
+
+	ranges.assign(maxMaterials, {});
+	uint32_t materialCount = 0;
+	for (int i = 0; i < instances.size(); i++) {
+		if (instances[i].material >= maxMaterials)
+			throw std::runtime_error("instance material out of range");
+		ranges[instances[i].material].capacity++;
+		materialCount = std::max(materialCount, instances[i].material + 1);
+	}
+	ranges.resize(materialCount);
+
+	uint32_t offset = 0;
+	for (int i = 0; i < ranges.size(); i++) {
+		ranges[i].firstCommand = offset;
+		offset += ranges[i].capacity;
+	}
+
+	instanceCount = static_cast<uint32_t>(instances.size());
+	instanceBuffer->upload(instances.data(), instances.size() * sizeof(gpuInstance_s));
+	materialBuffer->upload(ranges.data(), ranges.size() * sizeof(gpuMaterialRange_s));
+}
+
+void re::GpuCulling::setLodView(glm::vec3 const& camera, float lodScale)
+{
+	lodCamera = glm::vec4(camera, lodScale);
+}
+
+// without a count buffer the whole slice is drawn, so culled slots must read as instanceCount 0
+void re::GpuCulling::clearDraws(VkCommandBuffer cmd)
+{
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+
+	barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(cmd, countBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+	if (!drawCount)
+		vkCmdFillBuffer(cmd, commandBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void re::GpuCulling::finishDraws(VkCommandBuffer cmd)
+{
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void re::GpuCulling::record(VkCommandBuffer cmd, re::Frustum const& frustum)
+{
+	pushConstants_s constants;
+
+	for (int i = 0; i < 6; i++)
+		constants.planes[i] = frustum.planes[i];
+	constants.lodCamera = lodCamera;
+	constants.instanceCount = instanceCount;
+
+	clearDraws(cmd);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->ptr);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set, 0, nullptr);
+	vkCmdPushConstants(cmd, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(cmd, (instanceCount + groupSize - 1) / groupSize, 1, 1);
+
+	finishDraws(cmd);
+}
+
+void re::GpuCulling::drawMaterial(VkCommandBuffer cmd, uint32_t material)
+{
+	gpuMaterialRange_s const& range = ranges[material];
+	VkDeviceSize stride = sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize offset = range.firstCommand * stride;
+
+	if (!range.capacity)
+		return;
+
+	if (drawCount)
+		vkCmdDrawIndexedIndirectCount(cmd, commandBuffer->ptr, offset, countBuffer->ptr, material * sizeof(uint32_t), range.capacity, static_cast<uint32_t>(stride));
+	else if (device.enabledFeatures.features.multiDrawIndirect)
+		vkCmdDrawIndexedIndirect(cmd, commandBuffer->ptr, offset, range.capacity, static_cast<uint32_t>(stride));
+	else
+		for (uint32_t i = 0; i < range.capacity; i++)
+			vkCmdDrawIndexedIndirect(cmd, commandBuffer->ptr, offset + i * stride, 1, static_cast<uint32_t>(stride));
+}
+
+void re::GpuCulling::draw(VkCommandBuffer cmd)
+{
+	for (uint32_t i = 0; i < ranges.size(); i++)
+		drawMaterial(cmd, i);
+}
@@ -0,0 +1,114 @@
+#include "HiZBuffer.hpp"
+#include <algorithm>
+
+static constexpr uint32_t groupSize = 8;
+
+static uint32_t previousPow2(uint32_t v)
+{
+	uint32_t r = 1;
+	while (r * 2 <= v)
+		r *= 2;
+	return r;
+}
+
+re::HiZBuffer::HiZBuffer(re::Device& device, re::PipelineLibrary& pipelines) : device(device)
+{
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+
+	setLayout = pipelines.getLayouts().getSetLayout(std::vector<VkDescriptorSetLayoutBinding>{
+		{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+	});
+	shader = pipelines.getShader(SHADER_PATH "hzb_reduce.comp.spv");
+	pipeline = pipelines.getCompute(SHADER_PATH "hzb_reduce.comp.spv", pipelines.getLayouts().getPipelineLayout({ setLayout },
+		std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } }));
+}
+
+re::HiZBuffer::~HiZBuffer(void)
+{
+	if (watcher)
+		watcher->remove(this);
+	pool.reset();
+	pyramid.reset();
+	vkDestroySampler(device.ptr, sampler, nullptr);
+}
+
+void re::HiZBuffer::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	watcher.watch(device, SHADER_PATH "hzb_reduce.comp.spv", this, shader, pipeline);
+}
+
+void re::HiZBuffer::resize(VkExtent2D extent, VkImageView depthView)
+{
+	VkExtent2D size = { previousPow2(extent.width), previousPow2(extent.height) };
+	uint32_t levels = 1;
+	while ((size.width >> levels) || (size.height >> levels))
+		levels++;
+
+	depthExtent = extent;
+	initialized = false;
+	built = false;
+	pyramid = std::make_shared<re::Image>(device, size, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, levels);
+	pool = std::make_shared<re::DescriptorPool>(device, levels, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levels },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels }
+	});
+
+	sets.resize(levels);
+	for (uint32_t i = 0; i < levels; i++) {
+		sets[i] = pool->allocate(*setLayout);
+		VkDescriptorImageInfo source = i == 0
+			? VkDescriptorImageInfo{ sampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+			: VkDescriptorImageInfo{ sampler, pyramid->mipViews[i - 1], VK_IMAGE_LAYOUT_GENERAL };
+		VkDescriptorImageInfo destination{ nullptr, levels > 1 ? pyramid->mipViews[i] : pyramid->view, VK_IMAGE_LAYOUT_GENERAL };
+		re::writeDescriptor(device, sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, source);
+		re::writeDescriptor(device, sets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, destination);
+	}
+}
+
+void re::HiZBuffer::build(VkCommandBuffer cmd)
+{
+	if (!pyramid)
+		throw std::runtime_error("HiZBuffer::build called before resize");
+
+	if (!initialized) {
+		pyramid->barrier(cmd, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		initialized = true;
+	}
+	else {
+		pyramid->barrier(cmd, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->ptr);
+
+	VkExtent2D source = depthExtent;
+	for (uint32_t i = 0; i < pyramid->mipLevels; i++) {
+		VkExtent2D destination = { std::max(pyramid->extent.width >> i, 1u), std::max(pyramid->extent.height >> i, 1u) };
+		pushConstants_s constants = {
+			{ static_cast<int32_t>(source.width), static_cast<int32_t>(source.height) },
+			{ static_cast<int32_t>(destination.width), static_cast<int32_t>(destination.height) }
+		};
+
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &sets[i], 0, nullptr);
+		vkCmdPushConstants(cmd, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(cmd, (destination.width + groupSize - 1) / groupSize, (destination.height + groupSize - 1) / groupSize, 1);
+
+		pyramid->barrier(cmd, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, i, 1);
+		source = destination;
+	}
+	built = true;
+}
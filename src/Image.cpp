@@ -0,0 +1,82 @@
+#include "Image.hpp"
+
+re::Image::Image(re::Device& device, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, uint32_t mipLevels, VkImageAspectFlags aspect)
+	: format(format), extent(extent), mipLevels(mipLevels), aspect(aspect), device(device)
+{
+	VkImageCreateInfo createInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = format;
+	createInfo.extent = { extent.width, extent.height, 1 };
+	createInfo.mipLevels = mipLevels;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create image");
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device.ptr, ptr, &requirements);
+
+	VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = device.physicalDevice.findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (vkAllocateMemory(device.ptr, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate image memory");
+	vkBindImageMemory(device.ptr, ptr, memory, 0);
+
+	view = createView(0, mipLevels);
+	if (mipLevels > 1)
+		for (uint32_t i = 0; i < mipLevels; i++)
+			mipViews.push_back(createView(i, 1));
+}
+
+re::Image::~Image(void)
+{
+	for (int i = 0; i < mipViews.size(); i++)
+		vkDestroyImageView(device.ptr, mipViews[i], nullptr);
+	vkDestroyImageView(device.ptr, view, nullptr);
+	vkDestroyImage(device.ptr, ptr, nullptr);
+	vkFreeMemory(device.ptr, memory, nullptr);
+}
+
+VkImageView re::Image::createView(uint32_t baseMip, uint32_t levelCount)
+{
+	VkImageViewCreateInfo info{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	VkImageView result = nullptr;
+
+	info.image = ptr;
+	info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	info.format = format;
+	info.subresourceRange.aspectMask = aspect;
+	info.subresourceRange.baseMipLevel = baseMip;
+	info.subresourceRange.levelCount = levelCount;
+	info.subresourceRange.baseArrayLayer = 0;
+	info.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(device.ptr, &info, nullptr, &result) != VK_SUCCESS)
+		throw std::runtime_error("failed to create ImageView");
+	return result;
+}
+
+void re::Image::barrier(VkCommandBuffer cmd, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess,
+	uint32_t baseMip, uint32_t levelCount)
+{
+	VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = ptr;
+	barrier.subresourceRange = { aspect, baseMip, levelCount, 0, 1 };
+
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
@@ -7,8 +7,14 @@ re::Instance::Instance(void)
 	std::vector<char const*> extensions = getExtensions();
 	std::vector<char const*> layers = getLayers();
 
+	VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
 	VkInstanceCreateInfo createInfo{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
 
+	appInfo.pApplicationName = "Rathalos Engine";
+	appInfo.pEngineName = "Rathalos Engine";
+	appInfo.apiVersion = apiVersion;
+
+	createInfo.pApplicationInfo = &appInfo;
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	createInfo.ppEnabledExtensionNames = extensions.data();
 	createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
@@ -0,0 +1,147 @@
+#include "JobSystem.hpp"
+#include <iostream>
+#include <algorithm>
+
+re::JobSystem::JobSystem(uint32_t threadCount)
+{
+	if (!threadCount)
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		workers.emplace_back(&JobSystem::workerLoop, this);
+}
+
+re::JobSystem::~JobSystem(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	for (int i = 0; i < queue.size(); i++)
+		jobs.destroy(queue[i]);
+}
+
+void re::JobSystem::submit(std::function<void(void)> function, jobCounter_t* counter)
+{
+	job_s* job = jobs.create();
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter)
+		counter->fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(job);
+	}
+	condition.notify_one();
+}
+
+void re::JobSystem::wait(jobCounter_t& counter)
+{
+	while (counter.load(std::memory_order_acquire) > 0)
+		if (!runOne())
+			std::this_thread::yield();
+
+	std::exception_ptr failure;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = failures.find(&counter);
+		if (it == failures.end())
+			return;
+		failure = it->second;
+		failures.erase(it);
+	}
+	std::rethrow_exception(failure);
+}
+
+void re::JobSystem::parallelFor(size_t count, size_t grain, std::function<void(size_t begin, size_t end)> const& function)
+{
+	if (!count)
+		return;
+
+	grain = std::max<size_t>(grain, 1);
+	if (count <= grain) {
+		function(0, count);
+		return;
+	}
+
+	jobCounter_t counter{ 0 };
+	for (size_t begin = grain; begin < count; begin += grain) {
+		size_t end = std::min(begin + grain, count);
+		submit([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+	// the jobs reference function and counter, they must be done before an exception leaves
+	std::exception_ptr failure;
+	try {
+		function(0, grain);
+	}
+	catch (...) {
+		failure = std::current_exception();
+	}
+	wait(counter);
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+void re::JobSystem::workerLoop(void)
+{
+	for (;;) {
+		job_s* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return !running || !queue.empty(); });
+			if (!running)
+				return;
+			job = queue.front();
+			queue.pop_front();
+		}
+		execute(job);
+	}
+}
+
+bool re::JobSystem::runOne(void)
+{
+	job_s* job = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queue.empty())
+			return false;
+		job = queue.front();
+		queue.pop_front();
+	}
+	execute(job);
+	return true;
+}
+
+// a throwing job still counts as done, wait rethrows the first exception of its counter
+void re::JobSystem::execute(job_s* job)
+{
+	jobCounter_t* counter = job->counter;
+
+	try {
+		job->function();
+	}
+	catch (std::exception& e) {
+		if (!counter)
+			std::cerr << TERMINAL_COLOR_RED << "job failed: " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+		else {
+			std::lock_guard<std::mutex> lock(mutex);
+			failures.emplace(counter, std::current_exception());
+		}
+	}
+	catch (...) {
+		if (counter) {
+			std::lock_guard<std::mutex> lock(mutex);
+			failures.emplace(counter, std::current_exception());
+		}
+	}
+
+	jobs.destroy(job);
+	if (counter)
+		counter->fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,212 @@
+#include "LayoutCache.hpp"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <cctype>
+
+// FNV-1a over the bytes of a word
+static uint64_t hashWord(uint64_t hash, uint64_t word)
+{
+	for (int i = 0; i < 8; i++) {
+		hash ^= (word >> (i * 8)) & 0xff;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static bool isSameBinding(VkDescriptorSetLayoutBinding const& a, VkDescriptorSetLayoutBinding const& b)
+{
+	return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount
+		&& a.stageFlags == b.stageFlags && a.pImmutableSamplers == b.pImmutableSamplers;
+}
+
+static bool isSameRange(VkPushConstantRange const& a, VkPushConstantRange const& b)
+{
+	return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+}
+
+re::LayoutCache::LayoutCache(re::Device& device) : device(device)
+{
+}
+
+uint64_t re::LayoutCache::hashBindings(std::vector<VkDescriptorSetLayoutBinding> const& bindings)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (int i = 0; i < bindings.size(); i++) {
+		hash = hashWord(hash, bindings[i].binding);
+		hash = hashWord(hash, bindings[i].descriptorType);
+		hash = hashWord(hash, bindings[i].descriptorCount);
+		hash = hashWord(hash, bindings[i].stageFlags);
+		hash = hashWord(hash, reinterpret_cast<uintptr_t>(bindings[i].pImmutableSamplers));
+	}
+	return hash;
+}
+
+uint64_t re::LayoutCache::hashPipelineLayout(std::vector<re::descriptorSetLayout_ptr> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (int i = 0; i < setLayouts.size(); i++)
+		hash = hashWord(hash, reinterpret_cast<uintptr_t>(setLayouts[i].get()));
+	for (int i = 0; i < pushConstants.size(); i++) {
+		hash = hashWord(hash, pushConstants[i].stageFlags);
+		hash = hashWord(hash, pushConstants[i].offset);
+		hash = hashWord(hash, pushConstants[i].size);
+	}
+	return hash;
+}
+
+re::descriptorSetLayout_ptr re::LayoutCache::getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings)
+{
+	// the order bindings are listed in does not change the layout
+	std::sort(bindings.begin(), bindings.end(), [](VkDescriptorSetLayoutBinding const& a, VkDescriptorSetLayoutBinding const& b) { return a.binding < b.binding; });
+
+	uint64_t hash = hashBindings(bindings);
+	auto range = setLayouts.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++) {
+		std::vector<VkDescriptorSetLayoutBinding> const& other = it->second->bindings;
+		if (other.size() == bindings.size() && std::equal(other.begin(), other.end(), bindings.begin(), isSameBinding))
+			return it->second;
+	}
+
+	re::descriptorSetLayout_ptr layout = std::make_shared<re::DescriptorSetLayout>(device, bindings);
+	setLayouts.emplace(hash, layout);
+	setLayoutCount++;
+	return layout;
+}
+
+re::pipelineLayout_ptr re::LayoutCache::getPipelineLayout(std::vector<re::descriptorSetLayout_ptr> const& layouts, std::vector<VkPushConstantRange> const& pushConstants)
+{
+	// set layouts are already deduplicated, so comparing them by pointer is enough
+	uint64_t hash = hashPipelineLayout(layouts, pushConstants);
+	auto range = pipelineLayouts.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++) {
+		re::PipelineLayout const& other = *it->second;
+		if (other.setLayouts == layouts && other.pushConstants.size() == pushConstants.size()
+			&& std::equal(other.pushConstants.begin(), other.pushConstants.end(), pushConstants.begin(), isSameRange))
+			return it->second;
+	}
+
+	re::pipelineLayout_ptr layout = std::make_shared<re::PipelineLayout>(device, layouts, pushConstants);
+	pipelineLayouts.emplace(hash, layout);
+	pipelineLayoutCount++;
+	return layout;
+}
+
+re::pipelineLayout_ptr re::LayoutCache::getPipelineLayout(std::vector<re::ShaderModule const*> const& shaders)
+{
+	std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+	VkPushConstantRange pushConstant{ 0, 0, 0 };
+
+	for (int i = 0; i < shaders.size(); i++) {
+		re::ShaderReflection const& reflection = shaders[i]->reflection;
+
+		for (int j = 0; j < reflection.bindings.size(); j++) {
+			re::shaderBinding_s const& binding = reflection.bindings[j];
+			auto it = sets[binding.set].find(binding.binding);
+
+			if (it == sets[binding.set].end()) {
+				sets[binding.set][binding.binding] = { binding.binding, binding.type, binding.count, binding.stages, nullptr };
+				continue;
+			}
+			if (it->second.descriptorType != binding.type)
+				throw std::runtime_error("shader stages disagree on the type of set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding));
+			it->second.descriptorCount = std::max(it->second.descriptorCount, binding.count);
+			it->second.stageFlags |= binding.stages;
+		}
+
+		if (reflection.pushConstantSize) {
+			pushConstant.stageFlags |= reflection.stage;
+			pushConstant.size = std::max(pushConstant.size, reflection.pushConstantSize);
+		}
+	}
+
+	// sets a stage skips still need a layout to keep the numbering, an empty one
+	uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+	std::vector<re::descriptorSetLayout_ptr> layouts(setCount);
+	for (uint32_t set = 0; set < setCount; set++) {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		auto it = sets.find(set);
+		if (it != sets.end())
+			for (auto const& binding : it->second)
+				bindings.push_back(binding.second);
+		layouts[set] = getSetLayout(bindings);
+	}
+
+	std::vector<VkPushConstantRange> pushConstants;
+	if (pushConstant.size)
+		pushConstants.push_back(pushConstant);
+	return getPipelineLayout(layouts, pushConstants);
+}
+
+std::string re::LayoutCache::describe(re::PipelineLayout const& layout)
+{
+	std::string description;
+
+	for (int i = 0; i < layout.setLayouts.size(); i++) {
+		std::vector<VkDescriptorSetLayoutBinding> const& bindings = layout.setLayouts[i]->bindings;
+		description += "[";
+		for (int j = 0; j < bindings.size(); j++)
+			description += (j ? "," : "") + std::to_string(bindings[j].binding) + ":" + std::to_string(bindings[j].descriptorType)
+				+ ":" + std::to_string(bindings[j].descriptorCount) + ":" + std::to_string(bindings[j].stageFlags);
+		description += "]";
+	}
+	description += "|";
+	for (int i = 0; i < layout.pushConstants.size(); i++)
+		description += (i ? "," : "") + std::to_string(layout.pushConstants[i].stageFlags) + ":" + std::to_string(layout.pushConstants[i].offset)
+			+ ":" + std::to_string(layout.pushConstants[i].size);
+	return description;
+}
+
+re::pipelineLayout_ptr re::LayoutCache::getPipelineLayout(std::string const& description)
+{
+	std::vector<re::descriptorSetLayout_ptr> layouts;
+	std::vector<VkPushConstantRange> pushConstants;
+	size_t i = 0;
+
+	auto expect = [&](char c) {
+		if (i >= description.size() || description[i] != c)
+			throw std::runtime_error("invalid pipeline layout: " + description);
+		i++;
+	};
+	auto number = [&](void) -> uint32_t {
+		if (i >= description.size() || !std::isdigit(static_cast<unsigned char>(description[i])))
+			throw std::runtime_error("invalid pipeline layout: " + description);
+		size_t length = 0;
+		uint32_t value = static_cast<uint32_t>(std::stoul(description.substr(i), &length));
+		i += length;
+		return value;
+	};
+
+	while (i < description.size() && description[i] == '[') {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		i++;
+		while (i < description.size() && description[i] != ']') {
+			VkDescriptorSetLayoutBinding binding{};
+			if (!bindings.empty())
+				expect(',');
+			binding.binding = number();
+			expect(':');
+			binding.descriptorType = static_cast<VkDescriptorType>(number());
+			expect(':');
+			binding.descriptorCount = number();
+			expect(':');
+			binding.stageFlags = number();
+			bindings.push_back(binding);
+		}
+		expect(']');
+		layouts.push_back(getSetLayout(bindings));
+	}
+	expect('|');
+	while (i < description.size()) {
+		VkPushConstantRange range{};
+		if (!pushConstants.empty())
+			expect(',');
+		range.stageFlags = number();
+		expect(':');
+		range.offset = number();
+		expect(':');
+		range.size = number();
+		pushConstants.push_back(range);
+	}
+	return getPipelineLayout(layouts, pushConstants);
+}
@@ -0,0 +1,102 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+re::MappedFile::MappedFile(std::string const& path)
+{
+	LARGE_INTEGER size;
+
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("failed to open file: " + path);
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw std::runtime_error("failed to read file size: " + path);
+	}
+
+	length = static_cast<size_t>(size.QuadPart);
+	if (!length)
+		return;
+
+	fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (fileMapping)
+		mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mapping) {
+		if (fileMapping)
+			CloseHandle(fileMapping);
+		CloseHandle(file);
+		throw std::runtime_error("failed to map file: " + path);
+	}
+}
+
+re::MappedFile::~MappedFile(void)
+{
+	if (mapping)
+		UnmapViewOfFile(mapping);
+	if (fileMapping)
+		CloseHandle(fileMapping);
+	CloseHandle(file);
+}
+
+void re::MappedFile::prefetch(size_t offset, size_t size) const
+{
+	WIN32_MEMORY_RANGE_ENTRY range{ const_cast<uint8_t*>(data()) + offset, size };
+
+	if (mapping && offset + size <= length)
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+re::MappedFile::MappedFile(std::string const& path)
+{
+	struct stat info;
+
+	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("failed to open file: " + path);
+	if (fstat(fd, &info) < 0) {
+		close(fd);
+		throw std::runtime_error("failed to read file size: " + path);
+	}
+
+	length = static_cast<size_t>(info.st_size);
+	if (!length)
+		return;
+
+	mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(fd);
+		throw std::runtime_error("failed to map file: " + path);
+	}
+}
+
+re::MappedFile::~MappedFile(void)
+{
+	if (mapping)
+		munmap(mapping, length);
+	close(fd);
+}
+
+void re::MappedFile::prefetch(size_t offset, size_t size) const
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t begin = offset / page * page;
+
+	if (mapping && offset + size <= length)
+		madvise(static_cast<uint8_t*>(mapping) + begin, size + offset - begin, MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "Mesh.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <map>
+#include <tuple>
+#include <cstdio>
+
+// obj indices are 1-based, negative ones count back from the end
+static int resolveIndex(int index, size_t count)
+{
+	if (index > 0)
+		return index - 1;
+	if (index < 0)
+		return static_cast<int>(count) + index;
+	return -1;
+}
+
+re::Mesh re::loadObj(std::string const& path)
+{
+	std::ifstream file(path);
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::map<std::tuple<int, int, int>, uint32_t> unique;
+	bool missingNormals = false;
+	Mesh mesh;
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + path);
+
+	for (std::string line; std::getline(file, line);) {
+		std::istringstream stream(line);
+		std::string type;
+		stream >> type;
+
+		if (type == "v") {
+			glm::vec3 p;
+			stream >> p.x >> p.y >> p.z;
+			positions.push_back(p);
+		}
+		else if (type == "vn") {
+			glm::vec3 n;
+			stream >> n.x >> n.y >> n.z;
+			normals.push_back(n);
+		}
+		else if (type == "vt") {
+			glm::vec2 uv;
+			stream >> uv.x >> uv.y;
+			uvs.push_back(glm::vec2(uv.x, 1.0f - uv.y));
+		}
+		else if (type == "f") {
+			std::vector<uint32_t> face;
+			for (std::string corner; stream >> corner;) {
+				int p = 0, t = 0, n = 0;
+				if (std::sscanf(corner.c_str(), "%d/%d/%d", &p, &t, &n) != 3 && std::sscanf(corner.c_str(), "%d//%d", &p, &n) != 2)
+					std::sscanf(corner.c_str(), "%d/%d", &p, &t);
+
+				p = resolveIndex(p, positions.size());
+				t = resolveIndex(t, uvs.size());
+				n = resolveIndex(n, normals.size());
+				if (p < 0 || p >= positions.size() || t >= static_cast<int>(uvs.size()) || n >= static_cast<int>(normals.size()))
+					throw std::runtime_error("invalid face in obj file: " + path);
+
+				auto key = std::make_tuple(p, t, n);
+				auto it = unique.find(key);
+				if (it == unique.end()) {
+					Vertex vertex{ positions[p], n >= 0 ? normals[n] : glm::vec3(0.0f), t >= 0 ? uvs[t] : glm::vec2(0.0f) };
+					missingNormals |= n < 0;
+					it = unique.emplace(key, static_cast<uint32_t>(mesh.vertices.size())).first;
+					mesh.vertices.push_back(vertex);
+				}
+				face.push_back(it->second);
+			}
+			for (int i = 2; i < face.size(); i++)
+				mesh.indices.insert(mesh.indices.end(), { face[0], face[i - 1], face[i] });
+		}
+	}
+
+	// area weighted face normals for files without vn
+	if (missingNormals) {
+		for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+			Vertex* v[3] = { &mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]], &mesh.vertices[mesh.indices[i + 2]] };
+			glm::vec3 n = glm::cross(v[1]->position - v[0]->position, v[2]->position - v[0]->position);
+			for (int k = 0; k < 3; k++)
+				v[k]->normal += n;
+		}
+		for (int i = 0; i < mesh.vertices.size(); i++)
+			if (glm::length(mesh.vertices[i].normal) > 0.0f)
+				mesh.vertices[i].normal = glm::normalize(mesh.vertices[i].normal);
+	}
+	return mesh;
+}
@@ -0,0 +1,256 @@
+#include "MeshOptimize.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace {
+
+	constexpr int cacheSize = 32;
+	constexpr float cacheDecayPower = 1.5f;
+	constexpr float lastTriangleScore = 0.75f;
+	constexpr float valenceBoostScale = 2.0f;
+	constexpr float valenceBoostPower = 0.5f;
+	constexpr uint32_t minimumClusterTriangles = 16;
+
+	float vertexScore(int cachePosition, uint32_t remaining)
+	{
+		float score = 0.0f;
+
+		if (!remaining)
+			return -1.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3)
+				score = lastTriangleScore;
+			else
+				score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (cacheSize - 3), cacheDecayPower);
+		}
+		return score + valenceBoostScale * std::pow(static_cast<float>(remaining), -valenceBoostPower);
+	}
+}
+
+re::vertexCacheStats_s re::analyzeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<uint8_t> referenced(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	size_t misses = 0;
+	size_t unique = 0;
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		uint32_t v = indices[i];
+		if (time - timestamps[v] > cacheSize) {
+			timestamps[v] = time++;
+			misses++;
+		}
+		if (!referenced[v]) {
+			referenced[v] = 1;
+			unique++;
+		}
+	}
+
+	vertexCacheStats_s stats{};
+	if (indices.size())
+		stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+	if (unique)
+		stats.atvr = static_cast<float>(misses) / unique;
+	return stats;
+}
+
+std::vector<uint32_t> re::optimizeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	std::vector<uint32_t> result;
+
+	result.reserve(triangleCount * 3);
+
+	// per vertex list of the triangles still to emit, emitted ones are swapped past the end
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		remaining[indices[i]]++;
+	for (size_t i = 0; i < vertexCount; i++)
+		offsets[i + 1] = offsets[i] + remaining[i];
+	std::fill(remaining.begin(), remaining.end(), 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[offsets[indices[i]] + remaining[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+
+	for (size_t i = 0; i < vertexCount; i++)
+		scores[i] = vertexScore(-1, remaining[i]);
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> next;
+	size_t cursor = 0;
+	uint32_t best = INVALID_UINT32;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		if (best == INVALID_UINT32) {
+			while (emitted[cursor])
+				cursor++;
+			best = static_cast<uint32_t>(cursor);
+		}
+
+		emitted[best] = 1;
+		next.clear();
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[best * 3 + k];
+			result.push_back(v);
+			next.push_back(v);
+
+			uint32_t* list = &adjacency[offsets[v]];
+			for (uint32_t j = 0; j < remaining[v]; j++) {
+				if (list[j] == best) {
+					std::swap(list[j], list[remaining[v] - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// the triangle's vertices move to the front, whatever falls past cacheSize is evicted
+		for (int i = 0; i < cache.size(); i++)
+			if (std::find(next.begin(), next.end(), cache[i]) == next.end())
+				next.push_back(cache[i]);
+		for (int i = cacheSize; i < next.size(); i++) {
+			cachePosition[next[i]] = -1;
+			scores[next[i]] = vertexScore(-1, remaining[next[i]]);
+		}
+		next.resize(std::min<size_t>(next.size(), cacheSize));
+		cache.swap(next);
+
+		for (int i = 0; i < cache.size(); i++) {
+			cachePosition[cache[i]] = i;
+			scores[cache[i]] = vertexScore(i, remaining[cache[i]]);
+		}
+
+		best = INVALID_UINT32;
+		float bestScore = -1.0f;
+		for (int i = 0; i < cache.size(); i++) {
+			uint32_t v = cache[i];
+			for (uint32_t j = 0; j < remaining[v]; j++) {
+				uint32_t t = adjacency[offsets[v] + j];
+				float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+				if (score > bestScore) {
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+// Sander, Nehab & Barczak 2007, clusters are cut where their own ACMR is close enough to the input's
+std::vector<uint32_t> re::optimizeOverdraw(re::Mesh const& mesh, std::vector<uint32_t> const& indices, float threshold)
+{
+	struct cluster_s {
+		size_t begin;
+		size_t end;
+		float sortKey;
+	};
+
+	size_t triangleCount = indices.size() / 3;
+	float targetAcmr = analyzeVertexCache(indices, mesh.vertices.size()).acmr * threshold;
+	std::vector<cluster_s> clusters;
+	std::vector<uint32_t> timestamps(mesh.vertices.size(), 0);
+	uint32_t time = 0;
+	size_t begin = 0;
+	size_t misses = 0;
+
+	for (size_t t = 0; t < triangleCount; t++) {
+		if (t == begin) {
+			time += 17;
+			misses = 0;
+		}
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			if (time - timestamps[v] > 16 || !timestamps[v]) {
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		size_t size = t + 1 - begin;
+		if (size >= minimumClusterTriangles && static_cast<float>(misses) / size <= targetAcmr) {
+			clusters.push_back({ begin * 3, (t + 1) * 3, 0.0f });
+			begin = t + 1;
+		}
+	}
+	if (begin < triangleCount)
+		clusters.push_back({ begin * 3, triangleCount * 3, 0.0f });
+
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> centers(clusters.size());
+	std::vector<glm::vec3> normals(clusters.size());
+
+	for (int c = 0; c < clusters.size(); c++) {
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t i = clusters[c].begin; i < clusters[c].end; i += 3) {
+			glm::vec3 const& a = mesh.vertices[indices[i]].position;
+			glm::vec3 const& b = mesh.vertices[indices[i + 1]].position;
+			glm::vec3 const& d = mesh.vertices[indices[i + 2]].position;
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(n);
+			center += (a + b + d) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+		centers[c] = area > 0.0f ? center / area : center;
+		normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+		meshCenter += center;
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	// clusters far out along their own normal are likely in front of the rest
+	for (int c = 0; c < clusters.size(); c++)
+		clusters[c].sortKey = glm::dot(centers[c] - meshCenter, normals[c]);
+	std::stable_sort(clusters.begin(), clusters.end(), [](cluster_s const& l, cluster_s const& r) { return l.sortKey > r.sortKey; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (int c = 0; c < clusters.size(); c++)
+		result.insert(result.end(), indices.begin() + clusters[c].begin, indices.begin() + clusters[c].end);
+	return result;
+}
+
+void re::optimizeVertexFetch(re::Mesh& mesh)
+{
+	std::vector<uint32_t> remap(mesh.vertices.size(), INVALID_UINT32);
+	std::vector<Vertex> vertices;
+
+	vertices.reserve(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.indices.size(); i++) {
+		uint32_t& v = mesh.indices[i];
+		if (remap[v] == INVALID_UINT32) {
+			remap[v] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[v]);
+		}
+		v = remap[v];
+	}
+	mesh.vertices.swap(vertices);
+}
+
+void re::optimizeMesh(re::Mesh& mesh, bool verbose)
+{
+	vertexCacheStats_s before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	mesh.indices = optimizeOverdraw(mesh, mesh.indices);
+	optimizeVertexFetch(mesh);
+
+	if (!verbose)
+		return;
+	vertexCacheStats_s after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	std::cout << TERMINAL_COLOR_YELLOW << "mesh optimized (" << mesh.indices.size() / 3 << " triangles):" << TERMINAL_COLOR_RESET << std::endl;
+	std::cout << TAB << "ACMR " << before.acmr << " -> " << after.acmr << std::endl;
+	std::cout << TAB << "ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
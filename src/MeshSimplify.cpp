@@ -0,0 +1,321 @@
+#include "MeshSimplify.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+	struct quadric_s {
+		double a00, a01, a02, a11, a12, a22, b0, b1, b2, c;
+		double totalWeight;
+
+		void add(quadric_s const& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+			totalWeight += q.totalWeight;
+		}
+
+		// weight * squared distance to the plane n.p + d = 0, n is unit length
+		void addPlane(glm::dvec3 n, double d, double weight)
+		{
+			totalWeight += weight;
+			a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+			a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+			b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+			c += weight * d * d;
+		}
+
+		// weighted mean of the squared distances, the area weights cancel out so the cost stays a squared length
+		double evaluate(glm::vec3 const& p) const
+		{
+			if (totalWeight <= 0.0)
+				return 0.0;
+			double x = p.x, y = p.y, z = p.z;
+			double r = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::max(r, 0.0) / totalWeight;
+		}
+	};
+
+	struct collapse_s {
+		uint32_t from;
+		uint32_t to;
+		uint32_t wedge;
+		double cost;
+	};
+
+	constexpr double borderWeight = 10.0;
+
+	inline uint64_t edgeKey(uint32_t a, uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; }
+
+	struct positionHash_s {
+		size_t operator()(glm::vec3 const& p) const
+		{
+			uint32_t h[3];
+			std::memcpy(h, &p, sizeof(h));
+			return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+		}
+	};
+}
+
+std::vector<uint32_t> re::simplifyMesh(re::Mesh const& mesh, std::vector<uint32_t> const& source, size_t targetIndexCount, float targetError, float* resultError)
+{
+	size_t vertexCount = mesh.vertices.size();
+	std::vector<uint32_t> indices = source;
+
+	// vertices sharing a position are one topological vertex, wedges with different attributes make a seam
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> wedgeNext(vertexCount);
+	std::vector<uint8_t> seam(vertexCount, 0);
+	std::unordered_map<glm::vec3, uint32_t, positionHash_s> unique;
+	glm::vec3 min(INFINITY), max(-INFINITY);
+
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		Vertex const& vertex = mesh.vertices[i];
+		auto it = unique.emplace(vertex.position, i).first;
+		uint32_t first = it->second;
+
+		remap[i] = first;
+		wedgeNext[i] = i;
+		if (first != i) {
+			wedgeNext[i] = wedgeNext[first];
+			wedgeNext[first] = i;
+			Vertex const& other = mesh.vertices[first];
+			if (other.normal != vertex.normal || other.uv != vertex.uv)
+				seam[first] = 1;
+		}
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+
+	float extent = vertexCount ? glm::length(max - min) : 0.0f;
+	double errorLimit = static_cast<double>(targetError) * extent;
+	double maxCost = 0.0;
+	errorLimit *= errorLimit;
+
+	std::vector<quadric_s> quadrics(vertexCount, quadric_s{});
+	std::vector<uint8_t> border(vertexCount, 0);
+	std::unordered_set<uint64_t> edges;
+	std::unordered_set<uint64_t> borderEdges;
+
+	auto position = [&](uint32_t v) -> glm::vec3 const& { return mesh.vertices[v].position; };
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+		for (int k = 0; k < 3; k++)
+			edges.insert(edgeKey(remap[indices[i + k]], remap[indices[i + (k + 1) % 3]]));
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		uint32_t v[3] = { remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] };
+		glm::dvec3 n = glm::cross(glm::dvec3(position(v[1]) - position(v[0])), glm::dvec3(position(v[2]) - position(v[0])));
+		double length = glm::length(n);
+		if (length <= 0.0)
+			continue;
+		n /= length;
+
+		for (int k = 0; k < 3; k++)
+			quadrics[v[k]].addPlane(n, -glm::dot(n, glm::dvec3(position(v[0]))), length * 0.5);
+
+		// open edges get a plane perpendicular to the face so the silhouette stays put
+		for (int k = 0; k < 3; k++) {
+			uint32_t a = v[k], b = v[(k + 1) % 3];
+			if (edges.count(edgeKey(b, a)))
+				continue;
+			glm::dvec3 edge = glm::dvec3(position(b) - position(a));
+			glm::dvec3 p = glm::cross(edge, n);
+			double pl = glm::length(p);
+			if (pl <= 0.0)
+				continue;
+			p /= pl;
+			double weight = glm::dot(edge, edge) * borderWeight;
+			quadrics[a].addPlane(p, -glm::dot(p, glm::dvec3(position(a))), weight);
+			quadrics[b].addPlane(p, -glm::dot(p, glm::dvec3(position(a))), weight);
+			border[a] = border[b] = 1;
+			borderEdges.insert(edgeKey(a, b));
+		}
+	}
+
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> triangles;
+	std::vector<uint8_t> touched(vertexCount);
+	std::vector<uint32_t> wedgeTarget(vertexCount, INVALID_UINT32);
+	std::vector<collapse_s> candidates;
+
+	// a pass picks the cheapest collapses whose neighbourhoods do not overlap, then rewrites the index buffer
+	while (indices.size() > targetIndexCount) {
+		size_t triangleCount = indices.size() / 3;
+
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (size_t i = 0; i < indices.size(); i++)
+			triangleOffsets[remap[indices[i]] + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			triangleOffsets[i + 1] += triangleOffsets[i];
+		triangles.resize(indices.size());
+		std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			triangles[fill[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+
+		auto allowed = [&](uint32_t from, uint32_t to) {
+			if (seam[from])
+				return false;
+			if (border[from])
+				return borderEdges.count(edgeKey(from, to)) || borderEdges.count(edgeKey(to, from));
+			return true;
+		};
+
+		candidates.clear();
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (int k = 0; k < 3; k++) {
+				uint32_t wa = indices[i + k], wb = indices[i + (k + 1) % 3];
+				uint32_t a = remap[wa], b = remap[wb];
+				if (a > b && edges.count(edgeKey(b, a)))
+					continue;
+
+				quadric_s q = quadrics[a];
+				q.add(quadrics[b]);
+				double costAB = allowed(a, b) ? q.evaluate(position(b)) : INFINITY;
+				double costBA = allowed(b, a) ? q.evaluate(position(a)) : INFINITY;
+				if (costAB == INFINITY && costBA == INFINITY)
+					continue;
+				if (costAB <= costBA)
+					candidates.push_back({ a, b, wb, costAB });
+				else
+					candidates.push_back({ b, a, wa, costBA });
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](collapse_s const& l, collapse_s const& r) { return l.cost < r.cost; });
+
+		auto flips = [&](uint32_t from, uint32_t to) {
+			for (uint32_t j = triangleOffsets[from]; j < triangleOffsets[from + 1]; j++) {
+				uint32_t const* tri = &indices[triangles[j] * 3];
+				uint32_t v[3] = { remap[tri[0]], remap[tri[1]], remap[tri[2]] };
+				if (v[0] == to || v[1] == to || v[2] == to)
+					continue;
+				glm::vec3 p[3] = { position(v[0]), position(v[1]), position(v[2]) };
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (int k = 0; k < 3; k++)
+					if (v[k] == from)
+						p[k] = position(to);
+				glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (glm::dot(before, after) <= 0.0f)
+					return true;
+			}
+			return false;
+		};
+
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t removed = 0;
+		size_t collapses = 0;
+
+		for (int i = 0; i < candidates.size(); i++) {
+			collapse_s const& c = candidates[i];
+			if (c.cost > errorLimit)
+				break;
+			if (touched[c.from] || touched[c.to] || flips(c.from, c.to))
+				continue;
+
+			for (uint32_t j = triangleOffsets[c.from]; j < triangleOffsets[c.from + 1]; j++) {
+				uint32_t const* tri = &indices[triangles[j] * 3];
+				bool shared = false;
+				for (int k = 0; k < 3; k++) {
+					touched[remap[tri[k]]] = 1;
+					shared |= remap[tri[k]] == c.to;
+				}
+				removed += shared;
+			}
+
+			uint32_t wedge = c.from;
+			do {
+				wedgeTarget[wedge] = c.wedge;
+				wedge = wedgeNext[wedge];
+			} while (wedge != c.from);
+
+			quadrics[c.to].add(quadrics[c.from]);
+			border[c.to] |= border[c.from];
+			maxCost = std::max(maxCost, c.cost);
+			collapses++;
+			if ((triangleCount - removed) * 3 <= targetIndexCount)
+				break;
+		}
+
+		if (!collapses)
+			break;
+
+		size_t write = 0;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			uint32_t tri[3];
+			for (int k = 0; k < 3; k++)
+				tri[k] = wedgeTarget[indices[i + k]] != INVALID_UINT32 ? wedgeTarget[indices[i + k]] : indices[i + k];
+			if (remap[tri[0]] == remap[tri[1]] || remap[tri[1]] == remap[tri[2]] || remap[tri[0]] == remap[tri[2]])
+				continue;
+			for (int k = 0; k < 3; k++)
+				indices[write++] = tri[k];
+		}
+		indices.resize(write);
+		std::fill(wedgeTarget.begin(), wedgeTarget.end(), INVALID_UINT32);
+
+		// border edges of collapsed vertices now end on their targets
+		edges.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+			for (int k = 0; k < 3; k++)
+				edges.insert(edgeKey(remap[indices[i + k]], remap[indices[i + (k + 1) % 3]]));
+		borderEdges.clear();
+		for (auto const& edge : edges)
+			if (!edges.count((edge << 32) | (edge >> 32)))
+				borderEdges.insert(edge);
+	}
+
+	if (resultError)
+		*resultError = extent > 0.0f ? static_cast<float>(std::sqrt(maxCost) / extent) : 0.0f;
+	return indices;
+}
+
+std::vector<re::MeshLod> re::buildLodChain(re::Mesh const& mesh, uint32_t maxLods, float reduction, float maxError)
+{
+	std::vector<MeshLod> lods;
+	glm::vec3 min(INFINITY), max(-INFINITY);
+
+	for (int i = 0; i < mesh.vertices.size(); i++) {
+		min = glm::min(min, mesh.vertices[i].position);
+		max = glm::max(max, mesh.vertices[i].position);
+	}
+	float extent = mesh.vertices.empty() ? 0.0f : glm::length(max - min);
+
+	lods.push_back({ mesh.indices, 0.0f });
+	while (lods.size() < maxLods) {
+		MeshLod const& previous = *lods.rbegin();
+		size_t target = static_cast<size_t>(previous.indices.size() / 3 * reduction) * 3;
+		float error = 0.0f;
+
+		std::vector<uint32_t> indices = simplifyMesh(mesh, previous.indices, target, maxError, &error);
+		// stop once a level no longer removes a meaningful part of the previous one
+		if (indices.empty() || indices.size() > previous.indices.size() * (1.0f + reduction) / 2.0f)
+			break;
+
+		// errors add up since every level is simplified from the previous one
+		lods.push_back({ std::move(indices), previous.error + error * extent });
+	}
+	return lods;
+}
+
+float re::getLodScale(glm::mat4 const& projection, float viewportHeight, float thresholdPixels)
+{
+	// vulkan projections usually flip y, the scale must stay positive
+	return std::abs(projection[1][1]) * viewportHeight * 0.5f / thresholdPixels;
+}
+
+uint32_t re::selectLod(std::vector<MeshLod> const& lods, float distance, float lodScale)
+{
+	uint32_t lod = 0;
+
+	distance = std::max(distance, 1e-4f);
+	for (uint32_t i = 1; i < lods.size(); i++) {
+		if (lods[i].error * lodScale > distance)
+			break;
+		lod = i;
+	}
+	return lod;
+}
@@ -0,0 +1,159 @@
+#include "Meshlet.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+// greedy clustering, the next triangle is the one sharing the most vertices with the meshlet being built
+re::MeshletData re::buildMeshlets(re::Mesh const& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	MeshletData data;
+	size_t triangleCount = mesh.indices.size() / 3;
+	size_t vertexCount = mesh.vertices.size();
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacencyOffsets[mesh.indices[i] + 1]++;
+	for (size_t i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[mesh.indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<uint8_t> used(triangleCount, 0);
+	std::vector<uint32_t> localIndex(vertexCount, INVALID_UINT32);
+	std::vector<uint32_t> candidates;
+	Meshlet current{};
+	size_t cursor = 0;
+
+	current.vertexOffset = 0;
+	current.triangleOffset = 0;
+
+	auto flush = [&]() {
+		if (!current.triangleCount)
+			return;
+		for (uint32_t i = 0; i < current.vertexCount; i++)
+			localIndex[data.vertices[current.vertexOffset + i]] = INVALID_UINT32;
+		data.meshlets.push_back(current);
+		current = {};
+		current.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+		current.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+		candidates.clear();
+	};
+
+	auto newVertices = [&](size_t triangle) {
+		uint32_t count = 0;
+		for (int k = 0; k < 3; k++)
+			count += localIndex[mesh.indices[triangle * 3 + k]] == INVALID_UINT32;
+		return count;
+	};
+
+	for (;;) {
+		size_t triangle = SIZE_MAX;
+		uint32_t best = 4;
+
+		for (size_t i = 0; i < candidates.size();) {
+			if (used[candidates[i]]) {
+				candidates[i] = *candidates.rbegin();
+				candidates.pop_back();
+				continue;
+			}
+			uint32_t score = newVertices(candidates[i]);
+			if (score < best) {
+				best = score;
+				triangle = candidates[i];
+			}
+			i++;
+		}
+
+		if (triangle == SIZE_MAX) {
+			while (cursor < triangleCount && used[cursor])
+				cursor++;
+			if (cursor == triangleCount)
+				break;
+			triangle = cursor;
+			best = newVertices(triangle);
+		}
+
+		if (current.vertexCount + best > maxVertices || current.triangleCount + 1 > maxTriangles) {
+			flush();
+			continue;
+		}
+
+		for (int k = 0; k < 3; k++) {
+			uint32_t vertex = mesh.indices[triangle * 3 + k];
+			if (localIndex[vertex] == INVALID_UINT32) {
+				localIndex[vertex] = current.vertexCount++;
+				data.vertices.push_back(vertex);
+			}
+			data.triangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+			for (uint32_t j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; j++)
+				if (!used[adjacency[j]])
+					candidates.push_back(adjacency[j]);
+		}
+		current.triangleCount++;
+		used[triangle] = 1;
+	}
+	flush();
+
+	computeMeshletBounds(mesh, data);
+	return data;
+}
+
+// the cone cutoff is the sine of the cone half-angle, a meshlet whose normals spread past 90 degrees gets a cutoff of 1 and is never cone culled
+void re::computeMeshletBounds(re::Mesh const& mesh, MeshletData& data)
+{
+	for (int m = 0; m < data.meshlets.size(); m++) {
+		Meshlet& meshlet = data.meshlets[m];
+		glm::vec3 min(INFINITY), max(-INFINITY);
+
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			glm::vec3 const& p = mesh.vertices[data.vertices[meshlet.vertexOffset + i]].position;
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+
+		glm::vec3 center = (min + max) * 0.5f;
+		float radius = 0.0f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+			radius = std::max(radius, glm::length(mesh.vertices[data.vertices[meshlet.vertexOffset + i]].position - center));
+		meshlet.sphere = glm::vec4(center, radius);
+
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+			uint8_t const* tri = &data.triangles[meshlet.triangleOffset + t * 3];
+			glm::vec3 a = mesh.vertices[data.vertices[meshlet.vertexOffset + tri[0]]].position;
+			glm::vec3 b = mesh.vertices[data.vertices[meshlet.vertexOffset + tri[1]]].position;
+			glm::vec3 c = mesh.vertices[data.vertices[meshlet.vertexOffset + tri[2]]].position;
+			glm::vec3 n = glm::cross(b - a, c - a);
+			float length = glm::length(n);
+			if (length <= 0.0f)
+				continue;
+			normals.push_back(n / length);
+			axis += *normals.rbegin();
+		}
+
+		float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 0.0f) {
+			meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+			continue;
+		}
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (int i = 0; i < normals.size(); i++)
+			minDot = std::min(minDot, glm::dot(axis, normals[i]));
+		meshlet.cone = glm::vec4(axis, minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot));
+	}
+}
+
+std::vector<uint32_t> re::MeshletData::getIndices(void) const
+{
+	std::vector<uint32_t> indices(triangles.size());
+
+	for (int m = 0; m < meshlets.size(); m++)
+		for (uint32_t i = 0; i < meshlets[m].triangleCount * 3; i++)
+			indices[meshlets[m].triangleOffset + i] = vertices[meshlets[m].vertexOffset + triangles[meshlets[m].triangleOffset + i]];
+	return indices;
+}
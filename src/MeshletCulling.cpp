@@ -0,0 +1,161 @@
+#include "MeshletCulling.hpp"
+#include "Culling.hpp"
+#include <algorithm>
+
+static constexpr uint32_t groupSize = 64;
+
+re::MeshletCulling::MeshletCulling(re::Device& device, re::PipelineLibrary& pipelines, re::HiZBuffer& hzb, uint32_t maxMeshlets, uint32_t maxInstances, uint32_t maxDraws)
+	: device(device), hzb(hzb), maxMeshlets(maxMeshlets), maxInstances(maxInstances), maxDraws(maxDraws)
+{
+	VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkBufferUsageFlags indirect = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	if (maxInstances > device.physicalDevice.properties.limits.maxComputeWorkGroupCount[1])
+		throw std::runtime_error("too many meshlet instances for one dispatch");
+	drawCount = device.enabledFeatures12.drawIndirectCount;
+
+	meshletBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuMeshlet_s) * maxMeshlets, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	instanceBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuMeshletInstance_s) * maxInstances, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+	commandBuffer = std::make_shared<re::Buffer>(device, sizeof(VkDrawIndexedIndirectCommand) * maxDraws, indirect, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	countBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t), indirect, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	viewBuffer = std::make_shared<re::Buffer>(device, sizeof(viewData_s), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible);
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(6);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+	bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 }
+	});
+	set = pool->allocate(*setLayout);
+
+	re::Buffer* buffers[5] = { meshletBuffer.get(), instanceBuffer.get(), commandBuffer.get(), countBuffer.get(), viewBuffer.get() };
+	for (uint32_t i = 0; i < 5; i++)
+		re::writeDescriptor(device, set, i, bindings[i].descriptorType, *buffers[i]);
+
+	shader = pipelines.getShader(SHADER_PATH "meshlet_cull.comp.spv");
+	pipeline = pipelines.getCompute(SHADER_PATH "meshlet_cull.comp.spv", pipelines.getLayouts().getPipelineLayout({ setLayout },
+		std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } }));
+}
+
+re::MeshletCulling::~MeshletCulling(void)
+{
+	if (watcher)
+		watcher->remove(this);
+}
+
+void re::MeshletCulling::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	watcher.watch(device, SHADER_PATH "meshlet_cull.comp.spv", this, shader, pipeline);
+}
+
+uint32_t re::MeshletCulling::addMeshlets(re::MeshletData const& data, uint32_t firstIndex, int32_t vertexOffset)
+{
+	uint32_t offset = static_cast<uint32_t>(meshlets.size());
+
+	if (offset + data.meshlets.size() > maxMeshlets)
+		throw std::runtime_error("too many meshlets for meshlet culling");
+
+	for (int i = 0; i < data.meshlets.size(); i++) {
+		Meshlet const& meshlet = data.meshlets[i];
+		meshlets.push_back({ meshlet.sphere, meshlet.cone, firstIndex + meshlet.triangleOffset, meshlet.triangleCount * 3, vertexOffset, 0 });
+	}
+	meshletBuffer->upload(meshlets.data() + offset, data.meshlets.size() * sizeof(gpuMeshlet_s), offset * sizeof(gpuMeshlet_s));
+	return offset;
+}
+
+void re::MeshletCulling::setInstances(std::vector<gpuMeshletInstance_s> const& instances)
+{
+	if (instances.size() > maxInstances)
+		throw std::runtime_error("too many instances for meshlet culling");
+
+	maxMeshletsPerInstance = 0;
+	drawCapacity = 0;
+	for (int i = 0; i < instances.size(); i++) {
+		if (instances[i].meshletOffset + instances[i].meshletCount > meshlets.size())
+			throw std::runtime_error("instance meshlets out of range");
+		maxMeshletsPerInstance = std::max(maxMeshletsPerInstance, instances[i].meshletCount);
+		drawCapacity += instances[i].meshletCount;
+	}
+	drawCapacity = std::min(drawCapacity, maxDraws);
+
+	instanceCount = static_cast<uint32_t>(instances.size());
+	instanceBuffer->upload(instances.data(), instances.size() * sizeof(gpuMeshletInstance_s));
+}
+
+void re::MeshletCulling::setView(glm::mat4 const& view, glm::mat4 const& projection, float znear)
+{
+	re::Frustum frustum = re::Frustum::fromMatrix(projection * view);
+	viewData_s data;
+
+	data.view = view;
+	data.projection = projection;
+	for (int i = 0; i < 6; i++)
+		data.planes[i] = frustum.planes[i];
+	data.camera = glm::inverse(view)[3];
+	data.pyramidSize = hzb.pyramid ? glm::vec2(hzb.pyramid->extent.width, hzb.pyramid->extent.height) : glm::vec2(1.0f);
+	data.znear = znear;
+	data.pad = 0.0f;
+	viewBuffer->upload(&data, sizeof(data));
+}
+
+// one workgroup row per instance, the x dimension walks the instance's meshlets
+void re::MeshletCulling::record(VkCommandBuffer cmd)
+{
+	if (!hzb.pyramid)
+		throw std::runtime_error("MeshletCulling needs a sized HiZBuffer");
+
+	if (boundPyramid != hzb.pyramid.get()) {
+		re::writeDescriptor(device, set, 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, hzb.getDescriptorInfo());
+		boundPyramid = hzb.pyramid.get();
+	}
+
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	pushConstants_s constants = { instanceCount, drawCapacity, hzb.valid() ? 1u : 0u };
+
+	barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(cmd, countBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+	if (!drawCount)
+		vkCmdFillBuffer(cmd, commandBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	if (instanceCount && maxMeshletsPerInstance) {
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->ptr);
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(cmd, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(cmd, (maxMeshletsPerInstance + groupSize - 1) / groupSize, instanceCount, 1);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// without a count buffer every slot is drawn, the zero-filled ones are empty draws
+void re::MeshletCulling::draw(VkCommandBuffer cmd)
+{
+	uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (!drawCapacity)
+		return;
+
+	if (drawCount)
+		vkCmdDrawIndexedIndirectCount(cmd, commandBuffer->ptr, 0, countBuffer->ptr, 0, drawCapacity, stride);
+	else if (device.enabledFeatures.features.multiDrawIndirect)
+		vkCmdDrawIndexedIndirect(cmd, commandBuffer->ptr, 0, drawCapacity, stride);
+	else
+		for (uint32_t i = 0; i < drawCapacity; i++)
+			vkCmdDrawIndexedIndirect(cmd, commandBuffer->ptr, i * stride, 1, stride);
+}
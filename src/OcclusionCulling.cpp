@@ -0,0 +1,106 @@
+#include "OcclusionCulling.hpp"
+#include "Culling.hpp"
+
+static constexpr uint32_t groupSize = 64;
+
+re::OcclusionCulling::OcclusionCulling(re::Device& device, re::PipelineLibrary& pipelines, re::GpuCulling& culling, re::HiZBuffer& hzb) : device(device), culling(culling), hzb(hzb)
+{
+	uint32_t maxInstances = static_cast<uint32_t>(culling.instanceBuffer->size / sizeof(gpuInstance_s));
+
+	viewBuffer = std::make_shared<re::Buffer>(device, sizeof(viewData_s), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	visibilityBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t) * maxInstances,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(8);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 }
+	});
+	set = pool->allocate(*setLayout);
+
+	re::Buffer* buffers[7] = {
+		culling.instanceBuffer.get(), culling.meshBuffer.get(), culling.materialBuffer.get(),
+		culling.commandBuffer.get(), culling.countBuffer.get(), viewBuffer.get(), visibilityBuffer.get()
+	};
+	for (uint32_t i = 0; i < 7; i++)
+		re::writeDescriptor(device, set, i, bindings[i].descriptorType, *buffers[i]);
+
+	shader = pipelines.getShader(SHADER_PATH "cull_occlusion.comp.spv");
+	pipeline = pipelines.getCompute(SHADER_PATH "cull_occlusion.comp.spv", pipelines.getLayouts().getPipelineLayout({ setLayout },
+		std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } }));
+}
+
+re::OcclusionCulling::~OcclusionCulling(void)
+{
+	if (watcher)
+		watcher->remove(this);
+}
+
+void re::OcclusionCulling::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	watcher.watch(device, SHADER_PATH "cull_occlusion.comp.spv", this, shader, pipeline);
+}
+
+void re::OcclusionCulling::setView(glm::mat4 const& view, glm::mat4 const& projection, float znear)
+{
+	re::Frustum frustum = re::Frustum::fromMatrix(projection * view);
+	viewData_s data;
+
+	data.view = view;
+	data.projection = projection;
+	for (int i = 0; i < 6; i++)
+		data.planes[i] = frustum.planes[i];
+	data.pyramidSize = hzb.pyramid ? glm::vec2(hzb.pyramid->extent.width, hzb.pyramid->extent.height) : glm::vec2(1.0f);
+	data.znear = znear;
+	data.instanceCount = culling.getInstanceCount();
+	data.lodCamera = culling.getLodCamera();
+	viewBuffer->upload(&data, sizeof(data));
+}
+
+void re::OcclusionCulling::recordEarly(VkCommandBuffer cmd)
+{
+	if (!visibilityCleared) {
+		vkCmdFillBuffer(cmd, visibilityBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+		visibilityCleared = true;
+	}
+	recordPhase(cmd, 0);
+}
+
+void re::OcclusionCulling::recordLate(VkCommandBuffer cmd)
+{
+	if (!hzb.valid())
+		throw std::runtime_error("OcclusionCulling::recordLate needs a built HiZBuffer");
+	recordPhase(cmd, 1);
+}
+
+void re::OcclusionCulling::recordPhase(VkCommandBuffer cmd, uint32_t phase)
+{
+	if (!hzb.pyramid)
+		throw std::runtime_error("OcclusionCulling needs a sized HiZBuffer");
+
+	if (boundPyramid != hzb.pyramid.get()) {
+		re::writeDescriptor(device, set, 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, hzb.getDescriptorInfo());
+		boundPyramid = hzb.pyramid.get();
+	}
+
+	pushConstants_s constants = { phase, hzb.valid() ? 1u : 0u };
+	uint32_t instanceCount = culling.getInstanceCount();
+
+	culling.clearDraws(cmd);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->ptr);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set, 0, nullptr);
+	vkCmdPushConstants(cmd, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(cmd, (instanceCount + groupSize - 1) / groupSize, 1, 1);
+
+	culling.finishDraws(cmd);
+}
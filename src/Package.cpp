@@ -0,0 +1,384 @@
+#include "Package.hpp"
+#include "MeshOptimize.hpp"
+#include "MeshSimplify.hpp"
+#include "QuantizedMesh.hpp"
+#include "TextureCompression.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cctype>
+
+static constexpr size_t blobFieldAlignment = 16;
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static void append(std::vector<uint8_t>& blob, void const* data, size_t size, size_t alignment = 1)
+{
+	blob.resize(alignUp(blob.size(), alignment), 0);
+	blob.insert(blob.end(), static_cast<uint8_t const*>(data), static_cast<uint8_t const*>(data) + size);
+}
+
+// FNV-1a
+uint64_t re::hashName(std::string_view name)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (char c : name)
+		hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+	return hash;
+}
+
+std::vector<uint8_t> re::serializeTexture(re::TextureData const& texture)
+{
+	packageTexture_s header{ texture.width, texture.height, static_cast<uint32_t>(texture.mips.size()), texture.format };
+	std::vector<packageMip_s> mips(texture.mips.size());
+	std::vector<uint8_t> blob(sizeof(packageTexture_s) + mips.size() * sizeof(packageMip_s));
+
+	for (uint32_t i = 0; i < mips.size(); i++) {
+		mips[i] = { getMipSize(texture.width, i), getMipSize(texture.height, i), alignUp(blob.size(), blobFieldAlignment), texture.mips[i].size() };
+		append(blob, texture.mips[i].data(), texture.mips[i].size(), blobFieldAlignment);
+	}
+	std::memcpy(blob.data(), &header, sizeof(header));
+	std::memcpy(blob.data() + sizeof(header), mips.data(), mips.size() * sizeof(packageMip_s));
+	return blob;
+}
+
+re::textureView_s re::parseTexture(uint8_t const* blob, size_t size)
+{
+	textureView_s view;
+
+	if (size < sizeof(packageTexture_s))
+		throw std::runtime_error("corrupt package texture");
+	view.data = blob;
+	view.header = reinterpret_cast<packageTexture_s const*>(blob);
+	view.mips = reinterpret_cast<packageMip_s const*>(blob + sizeof(packageTexture_s));
+
+	if (sizeof(packageTexture_s) + view.header->mipLevels * sizeof(packageMip_s) > size)
+		throw std::runtime_error("corrupt package texture");
+	for (uint32_t i = 0; i < view.header->mipLevels; i++)
+		if (view.mips[i].offset + view.mips[i].size > size)
+			throw std::runtime_error("corrupt package texture");
+	return view;
+}
+
+re::TextureData re::loadTexture(re::textureView_s const& view)
+{
+	TextureData texture;
+
+	texture.width = view.header->width;
+	texture.height = view.header->height;
+	texture.format = view.header->format;
+	for (uint32_t i = 0; i < view.header->mipLevels; i++)
+		texture.mips.emplace_back(view.data + view.mips[i].offset, view.data + view.mips[i].offset + view.mips[i].size);
+	return texture;
+}
+
+static std::string getStem(std::string name)
+{
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+	std::string stem = name.substr(0, name.find_last_of('.'));
+	return stem.substr(stem.find_last_of('/') + 1);
+}
+
+static bool hasStemSuffix(std::string const& name, std::string const& suffix)
+{
+	std::string stem = getStem(name);
+	return stem.size() > suffix.size() && stem.compare(stem.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// the packer has no metadata beside the file name, "_n" / "normal" suffixes mark tangent space normal maps
+static bool isNormalMapName(std::string const& name)
+{
+	return getStem(name).find("normal") != std::string::npos || hasStemSuffix(name, "_n");
+}
+
+// roughness, metalness, occlusion, height and mask maps hold linear data, every other texture is colour and sRGB
+static bool isDataMapName(std::string const& name)
+{
+	char const* suffixes[] = { "_r", "_rough", "_roughness", "_m", "_metal", "_metallic", "_ao", "_orm", "_h", "_height", "_mask" };
+
+	for (char const* suffix : suffixes)
+		if (hasStemSuffix(name, suffix) || hasStemSuffix(name, std::string(suffix) + "_vt"))
+			return true;
+	return false;
+}
+
+re::Package::Package(std::string const& path) : path(path), file(path)
+{
+	if (file.size() < sizeof(packageHeader_s))
+		throw std::runtime_error("invalid package: " + path);
+
+	header = reinterpret_cast<packageHeader_s const*>(file.data());
+	if (header->magic != PACKAGE_MAGIC || header->version != PACKAGE_VERSION)
+		throw std::runtime_error("invalid package: " + path);
+	if (header->fileSize != file.size() || header->tocOffset + header->entryCount * sizeof(packageEntry_s) > file.size() || header->namesOffset > file.size())
+		throw std::runtime_error("corrupt package: " + path);
+
+	entries = reinterpret_cast<packageEntry_s const*>(file.data() + header->tocOffset);
+	for (uint32_t i = 0; i < header->entryCount; i++) {
+		packageEntry_s const& entry = entries[i];
+		if (entry.offset + entry.size > file.size() || header->namesOffset + entry.nameOffset + entry.nameLength > file.size())
+			throw std::runtime_error("corrupt package: " + path);
+	}
+}
+
+re::packageEntry_s const* re::Package::find(std::string_view name) const
+{
+	uint64_t hash = hashName(name);
+	packageEntry_s const* end = entries + header->entryCount;
+	packageEntry_s const* it = std::lower_bound(entries, end, hash, [](packageEntry_s const& entry, uint64_t h) { return entry.nameHash < h; });
+
+	for (; it != end && it->nameHash == hash; it++)
+		if (getName(*it) == name)
+			return it;
+	return nullptr;
+}
+
+std::string_view re::Package::getName(packageEntry_s const& entry) const
+{
+	return std::string_view(reinterpret_cast<char const*>(file.data() + header->namesOffset + entry.nameOffset), entry.nameLength);
+}
+
+re::meshView_s re::Package::getMesh(packageEntry_s const& entry) const
+{
+	if (entry.type != ASSET_TYPE_MESH || entry.size < sizeof(packageMesh_s))
+		throw std::runtime_error("package entry is not a mesh");
+
+	uint8_t const* blob = getData(entry);
+	meshView_s view;
+	view.header = reinterpret_cast<packageMesh_s const*>(blob);
+
+	size_t stride = view.header->vertexFormat == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+	if (view.header->verticesOffset + view.header->vertexCount * stride > entry.size
+		|| view.header->indicesOffset + view.header->indexCount * sizeof(uint32_t) > entry.size
+		|| view.header->lodsOffset + view.header->lodCount * sizeof(packageLod_s) > entry.size)
+		throw std::runtime_error("corrupt package mesh");
+
+	view.vertices = blob + view.header->verticesOffset;
+	view.indices = reinterpret_cast<uint32_t const*>(blob + view.header->indicesOffset);
+	view.lods = reinterpret_cast<packageLod_s const*>(blob + view.header->lodsOffset);
+	return view;
+}
+
+re::textureView_s re::Package::getTexture(packageEntry_s const& entry) const
+{
+	if (entry.type != ASSET_TYPE_TEXTURE)
+		throw std::runtime_error("package entry is not a texture");
+	return parseTexture(getData(entry), entry.size);
+}
+
+re::virtualTextureView_s re::Package::getVirtualTexture(packageEntry_s const& entry) const
+{
+	if (entry.type != ASSET_TYPE_VIRTUAL_TEXTURE || entry.size < sizeof(packageVirtualTexture_s))
+		throw std::runtime_error("package entry is not a virtual texture");
+
+	virtualTextureView_s view;
+	view.data = getData(entry);
+	view.header = reinterpret_cast<packageVirtualTexture_s const*>(view.data);
+	view.mips = reinterpret_cast<packageVirtualMip_s const*>(view.data + sizeof(packageVirtualTexture_s));
+	view.tiles = reinterpret_cast<packageTile_s const*>(view.mips + view.header->mipLevels);
+
+	if (reinterpret_cast<uint8_t const*>(view.tiles + view.header->tileCount) > view.data + entry.size)
+		throw std::runtime_error("corrupt package virtual texture");
+	for (uint32_t i = 0; i < view.header->tileCount; i++)
+		if (view.tiles[i].offset + view.tiles[i].size > entry.size)
+			throw std::runtime_error("corrupt package virtual texture");
+	return view;
+}
+
+void re::Package::prefetch(packageEntry_s const& entry) const
+{
+	file.prefetch(entry.offset, entry.size);
+}
+
+void re::Package::copyTo(packageEntry_s const& entry, re::Buffer& staging, VkDeviceSize offset) const
+{
+	if (offset + entry.size > staging.size)
+		throw std::runtime_error("staging buffer too small for package entry");
+	staging.upload(getData(entry), entry.size, offset);
+}
+
+void re::PackageWriter::addBlob(std::string const& name, assetType_e type, std::vector<uint8_t> blob)
+{
+	pending.push_back({ name, type, std::move(blob) });
+}
+
+void re::PackageWriter::addMesh(std::string const& name, re::Mesh const& source, bool quantize, uint32_t maxLods, bool verbose)
+{
+	Mesh mesh = source;
+	optimizeMesh(mesh, verbose);
+
+	std::vector<MeshLod> lods = buildLodChain(mesh, maxLods);
+	std::vector<packageLod_s> lodTable;
+	std::vector<uint32_t> indices;
+	for (int i = 0; i < lods.size(); i++) {
+		std::vector<uint32_t> lodIndices = i ? optimizeVertexCache(lods[i].indices, mesh.vertices.size()) : lods[i].indices;
+		lodTable.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), lods[i].error, 0 });
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+
+	packageMesh_s header{};
+	std::vector<uint8_t> blob(sizeof(packageMesh_s));
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	header.indexCount = static_cast<uint32_t>(indices.size());
+	header.lodCount = static_cast<uint32_t>(lodTable.size());
+
+	header.verticesOffset = static_cast<uint32_t>(alignUp(blob.size(), blobFieldAlignment));
+	if (quantize) {
+		QuantizedMesh quantized = quantizeMesh(mesh);
+		header.vertexFormat = VERTEX_FORMAT_PACKED;
+		std::memcpy(header.positionOffset, &quantized.positionOffset, sizeof(header.positionOffset));
+		std::memcpy(header.positionScale, &quantized.positionScale, sizeof(header.positionScale));
+		append(blob, quantized.vertices.data(), quantized.vertices.size() * sizeof(PackedVertex), blobFieldAlignment);
+	}
+	else {
+		header.vertexFormat = VERTEX_FORMAT_FLOAT;
+		append(blob, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex), blobFieldAlignment);
+	}
+	header.indicesOffset = static_cast<uint32_t>(alignUp(blob.size(), blobFieldAlignment));
+	append(blob, indices.data(), indices.size() * sizeof(uint32_t), blobFieldAlignment);
+	header.lodsOffset = static_cast<uint32_t>(alignUp(blob.size(), blobFieldAlignment));
+	append(blob, lodTable.data(), lodTable.size() * sizeof(packageLod_s), blobFieldAlignment);
+
+	std::memcpy(blob.data(), &header, sizeof(header));
+	addBlob(name, ASSET_TYPE_MESH, std::move(blob));
+}
+
+void re::PackageWriter::addTexture(std::string const& name, re::TextureData const& texture)
+{
+	addBlob(name, ASSET_TYPE_TEXTURE, serializeTexture(texture));
+}
+
+// edge texels are repeated where a tile border falls outside the mip
+void re::PackageWriter::addVirtualTexture(std::string const& name, re::TextureData const& texture, VkFormat format, uint32_t tileSize, uint32_t border)
+{
+	uint32_t content = tileSize - 2 * border;
+	std::vector<packageVirtualMip_s> mips;
+	std::vector<packageTile_s> tiles;
+	std::vector<std::vector<uint8_t>> payloads;
+
+	if (tileSize % 4 || border % 4 || tileSize <= 2 * border)
+		throw std::runtime_error("virtual texture tiles must be a multiple of 4 texels and larger than their border");
+
+	for (uint32_t level = 0; level < texture.mips.size(); level++) {
+		uint32_t width = getMipSize(texture.width, level), height = getMipSize(texture.height, level);
+		packageVirtualMip_s mip{ width, height, (width + content - 1) / content, (height + content - 1) / content, static_cast<uint32_t>(payloads.size()), 0 };
+		std::vector<uint8_t> const& src = texture.mips[level];
+
+		for (uint32_t py = 0; py < mip.pagesY; py++) {
+			for (uint32_t px = 0; px < mip.pagesX; px++) {
+				TextureData tile{ tileSize, tileSize, texture.format };
+				tile.mips.emplace_back(tileSize * tileSize * 4);
+				for (uint32_t y = 0; y < tileSize; y++) {
+					for (uint32_t x = 0; x < tileSize; x++) {
+						int sx = std::clamp(static_cast<int>(px * content + x) - static_cast<int>(border), 0, static_cast<int>(width) - 1);
+						int sy = std::clamp(static_cast<int>(py * content + y) - static_cast<int>(border), 0, static_cast<int>(height) - 1);
+						std::memcpy(&tile.mips[0][(y * tileSize + x) * 4], &src[(sy * width + sx) * 4], 4);
+					}
+				}
+				payloads.push_back(isBlockCompressed(format) ? compressTexture(tile, format).mips[0] : std::move(tile.mips[0]));
+			}
+		}
+		mips.push_back(mip);
+		if (mip.pagesX == 1 && mip.pagesY == 1)
+			break;
+	}
+
+	packageVirtualTexture_s header{ texture.width, texture.height, static_cast<uint32_t>(mips.size()), format, tileSize, border, static_cast<uint32_t>(payloads.size()), 0 };
+	std::vector<uint8_t> blob(sizeof(header) + mips.size() * sizeof(packageVirtualMip_s) + payloads.size() * sizeof(packageTile_s));
+	tiles.resize(payloads.size());
+	for (int i = 0; i < payloads.size(); i++) {
+		tiles[i] = { alignUp(blob.size(), blobFieldAlignment), payloads[i].size() };
+		append(blob, payloads[i].data(), payloads[i].size(), blobFieldAlignment);
+	}
+	std::memcpy(blob.data(), &header, sizeof(header));
+	std::memcpy(blob.data() + sizeof(header), mips.data(), mips.size() * sizeof(packageVirtualMip_s));
+	std::memcpy(blob.data() + sizeof(header) + mips.size() * sizeof(packageVirtualMip_s), tiles.data(), tiles.size() * sizeof(packageTile_s));
+	addBlob(name, ASSET_TYPE_VIRTUAL_TEXTURE, std::move(blob));
+}
+
+void re::PackageWriter::write(std::string const& path) const
+{
+	std::vector<uint32_t> order(pending.size());
+	std::vector<packageEntry_s> entries(pending.size());
+	std::string names;
+	packageHeader_s header{ PACKAGE_MAGIC, PACKAGE_VERSION, static_cast<uint32_t>(pending.size()), PACKAGE_ALIGNMENT, 0, 0, 0 };
+
+	for (uint32_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+		uint64_t hl = hashName(pending[l].name), hr = hashName(pending[r].name);
+		return hl != hr ? hl < hr : pending[l].name < pending[r].name;
+	});
+
+	header.tocOffset = sizeof(packageHeader_s);
+	header.namesOffset = header.tocOffset + entries.size() * sizeof(packageEntry_s);
+	for (int i = 0; i < order.size(); i++) {
+		pending_s const& asset = pending[order[i]];
+		if (i && hashName(asset.name) == entries[i - 1].nameHash && asset.name == pending[order[i - 1]].name)
+			throw std::runtime_error("duplicate package entry: " + asset.name);
+		entries[i] = { hashName(asset.name), static_cast<uint32_t>(names.size()), static_cast<uint32_t>(asset.name.size()), asset.type, 0, 0, asset.blob.size() };
+		names += asset.name;
+	}
+
+	uint64_t offset = alignUp(header.namesOffset + names.size(), PACKAGE_ALIGNMENT);
+	for (int i = 0; i < entries.size(); i++) {
+		entries[i].offset = offset;
+		offset = alignUp(offset + entries[i].size, PACKAGE_ALIGNMENT);
+	}
+	header.fileSize = entries.empty() ? header.namesOffset + names.size() : entries.rbegin()->offset + entries.rbegin()->size;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + path);
+
+	std::vector<char> padding(PACKAGE_ALIGNMENT, 0);
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(reinterpret_cast<char const*>(entries.data()), entries.size() * sizeof(packageEntry_s));
+	file.write(names.data(), names.size());
+	for (int i = 0; i < entries.size(); i++) {
+		file.write(padding.data(), entries[i].offset - static_cast<uint64_t>(file.tellp()));
+		file.write(reinterpret_cast<char const*>(pending[order[i]].blob.data()), entries[i].size);
+	}
+	if (!file)
+		throw std::runtime_error("failed to write package: " + path);
+}
+
+void re::packAssets(std::string const& output, std::vector<std::string> const& inputs)
+{
+	PackageWriter writer;
+
+	for (int i = 0; i < inputs.size(); i++) {
+		std::string name = inputs[i];
+		std::replace(name.begin(), name.end(), '\\', '/');
+		std::string extension = name.substr(std::min(name.size(), name.find_last_of('.')));
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+		std::cout << TAB << name << std::endl;
+
+		if (extension == ".obj")
+			writer.addMesh(name, loadObj(inputs[i]), true, 4, true);
+		else if (extension == ".tga") {
+			TextureData texture = loadTga(inputs[i]);
+			generateMips(texture);
+			// tga has no colour space, it follows from what the texture is used for
+			textureClass_e textureClass = classifyTexture(texture, isNormalMapName(name));
+			bool srgb = textureClass != TEXTURE_CLASS_NORMAL && !isDataMapName(name);
+			VkFormat format = getCompressedFormat(textureClass, srgb);
+			if (hasStemSuffix(name, "_vt"))
+				writer.addVirtualTexture(name, texture, format);
+			else
+				writer.addTexture(name, compressTexture(texture, format));
+		}
+		else {
+			MappedFile source(inputs[i]);
+			writer.addBlob(name, ASSET_TYPE_RAW, std::vector<uint8_t>(source.data(), source.data() + source.size()));
+		}
+	}
+	writer.write(output);
+	std::cout << TERMINAL_COLOR_GREEN << "packed " << inputs.size() << " assets into " << output << TERMINAL_COLOR_RESET << std::endl;
+}
@@ -0,0 +1,201 @@
+#include "ParticleSystem.hpp"
+#include <algorithm>
+
+static constexpr uint32_t emitGroupSize = 64;
+static constexpr uint32_t simulateGroupSize = 256;
+// elements a sort workgroup orders in shared memory, two per thread
+static constexpr uint32_t sortBlock = 1024;
+
+static void computeBarrier(VkCommandBuffer cmd)
+{
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+re::ParticleSystem::ParticleSystem(re::Device& device, re::PipelineLibrary& pipelines, uint32_t maxParticles) : device(device), maxParticles(maxParticles)
+{
+	if (!maxParticles)
+		throw std::runtime_error("particle system needs at least one particle");
+
+	capacity = sortBlock;
+	while (capacity < maxParticles)
+		capacity *= 2;
+
+	// a local sort, then per stage past the shared block the global steps and a local merge
+	sortSteps.push_back({ 0, sortBlock, 0 });
+	for (uint32_t k = sortBlock * 2; k <= capacity; k *= 2) {
+		for (uint32_t j = k / 2; j >= sortBlock; j /= 2)
+			sortSteps.push_back({ 1, k, j });
+		sortSteps.push_back({ 2, k, sortBlock / 2 });
+	}
+
+	particleBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuParticle_s) * maxParticles,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	deadBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t) * maxParticles,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	listBuffer = std::make_shared<re::Buffer>(device, sizeof(glm::uvec2) * capacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// dead count, live count
+	counterBuffer = std::make_shared<re::Buffer>(device, sizeof(glm::uvec4),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	argsBuffer = std::make_shared<re::Buffer>(device, sizeof(VkDrawIndirectCommand) + sizeof(VkDispatchIndirectCommand) * sortSteps.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// particles, dead list, sort list, counters, arguments; the draw reads the particles and the sorted list
+	std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+	bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+	bindings[2].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 }
+	});
+	set = pool->allocate(*setLayout);
+
+	re::writeDescriptor(device, set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *particleBuffer);
+	re::writeDescriptor(device, set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *deadBuffer);
+	re::writeDescriptor(device, set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *listBuffer);
+	re::writeDescriptor(device, set, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *counterBuffer);
+	re::writeDescriptor(device, set, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *argsBuffer);
+
+	passes[PASS_EMIT].path = SHADER_PATH "particle_emit.comp.spv";
+	passes[PASS_SIMULATE].path = SHADER_PATH "particle_simulate.comp.spv";
+	passes[PASS_SORT_ARGS].path = SHADER_PATH "particle_sort_args.comp.spv";
+	passes[PASS_SORT].path = SHADER_PATH "particle_sort.comp.spv";
+
+	// one layout for every pass, the set stays bound between them
+	re::pipelineLayout_ptr layout = pipelines.getLayouts().getPipelineLayout({ setLayout },
+		std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } });
+	for (int i = 0; i < PASS_COUNT; i++) {
+		passes[i].shader = pipelines.getShader(passes[i].path);
+		passes[i].pipeline = pipelines.getCompute(passes[i].path, layout);
+	}
+
+	constants.maxParticles = maxParticles;
+	constants.capacity = capacity;
+	constants.gravity = glm::vec4(0.0f, -9.81f, 0.0f, 0.0f);
+}
+
+re::ParticleSystem::~ParticleSystem(void)
+{
+	if (watcher)
+		watcher->remove(this);
+}
+
+void re::ParticleSystem::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	for (int i = 0; i < PASS_COUNT; i++)
+		watcher.watch(device, passes[i].path, this, passes[i].shader, passes[i].pipeline);
+}
+
+void re::ParticleSystem::emit(particleEmitter_s const& emitter, uint32_t count)
+{
+	if (count)
+		emissions.push_back({ emitter, std::min(count, maxParticles) });
+}
+
+void re::ParticleSystem::setGravity(glm::vec3 const& gravity)
+{
+	constants.gravity = glm::vec4(gravity, 0.0f);
+}
+
+void re::ParticleSystem::setCamera(glm::vec3 const& position)
+{
+	constants.camera = glm::vec4(position, constants.camera.w);
+}
+
+void re::ParticleSystem::record(VkCommandBuffer cmd, float deltaTime)
+{
+	VkPipelineLayout layout = passes[PASS_SIMULATE].pipeline->layout;
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+
+	constants.camera.w = deltaTime;
+
+	// the previous frame's draw is done with the list and its arguments
+	barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// every slot starts on the dead list
+	if (!initialized)
+		vkCmdFillBuffer(cmd, counterBuffer->ptr, 0, sizeof(uint32_t), maxParticles);
+	vkCmdFillBuffer(cmd, counterBuffer->ptr, sizeof(uint32_t), sizeof(uint32_t), 0);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// the passes share the layout, the set stays bound across their pipelines
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+
+	if (!initialized) {
+		constants.phase = 1;
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, passes[PASS_SIMULATE].pipeline->ptr);
+		vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(cmd, (maxParticles + simulateGroupSize - 1) / simulateGroupSize, 1, 1);
+		computeBarrier(cmd);
+		initialized = true;
+	}
+
+	// the emissions only pop the dead list, they run back to back
+	if (!emissions.empty()) {
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, passes[PASS_EMIT].pipeline->ptr);
+		for (int i = 0; i < emissions.size(); i++) {
+			particleEmitter_s const& emitter = emissions[i].emitter;
+			constants.position = glm::vec4(emitter.position, emitter.radius);
+			constants.velocity = glm::vec4(emitter.velocity, emitter.spread);
+			constants.color = emitter.color;
+			constants.size = emitter.size;
+			constants.drag = emitter.drag;
+			constants.minLifetime = emitter.minLifetime;
+			constants.maxLifetime = std::max(emitter.minLifetime, emitter.maxLifetime);
+			constants.emitCount = emissions[i].count;
+			constants.seed = seed++;
+			vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+			vkCmdDispatch(cmd, (emissions[i].count + emitGroupSize - 1) / emitGroupSize, 1, 1);
+		}
+		emissions.clear();
+		computeBarrier(cmd);
+	}
+
+	constants.phase = 0;
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, passes[PASS_SIMULATE].pipeline->ptr);
+	vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(cmd, (maxParticles + simulateGroupSize - 1) / simulateGroupSize, 1, 1);
+	computeBarrier(cmd);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, passes[PASS_SORT_ARGS].pipeline->ptr);
+	vkCmdDispatch(cmd, 1, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// every step is recorded for the full capacity, the ones past the live count dispatch no workgroups
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, passes[PASS_SORT].pipeline->ptr);
+	for (int i = 0; i < sortSteps.size(); i++) {
+		constants.phase = sortSteps[i].x;
+		constants.k = sortSteps[i].y;
+		constants.j = sortSteps[i].z;
+		vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatchIndirect(cmd, argsBuffer->ptr, sizeof(VkDrawIndirectCommand) + sizeof(VkDispatchIndirectCommand) * i);
+		if (i + 1 < sortSteps.size())
+			computeBarrier(cmd);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void re::ParticleSystem::draw(VkCommandBuffer cmd)
+{
+	vkCmdDrawIndirect(cmd, argsBuffer->ptr, 0, 1, sizeof(VkDrawIndirectCommand));
+}
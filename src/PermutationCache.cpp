@@ -0,0 +1,237 @@
+#include "PermutationCache.hpp"
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+re::PermutationCache::PermutationCache(re::Device& device, re::shaderModule_ptr const& shader, re::pipelineLayout_ptr const& layout, VkPipelineCache cache)
+	: device(device), shader(shader), layout(layout), cache(cache)
+{
+	for (int i = 0; i < shader->reflection.specConstants.size(); i++)
+		if (shader->reflection.specConstants[i].size != sizeof(uint32_t))
+			throw std::runtime_error("64 bit specialization constants are not supported");
+}
+
+std::vector<re::specializationConstant_s> re::PermutationCache::resolve(permutation_t const& permutation) const
+{
+	std::vector<re::shaderSpecConstant_s> const& declared = shader->reflection.specConstants;
+	std::vector<re::specializationConstant_s> constants(declared.size());
+
+	// every declared constant is set, an explicit default and a left out switch are the same permutation
+	for (int i = 0; i < declared.size(); i++)
+		constants[i] = { declared[i].id, declared[i].defaultValue };
+	for (auto const& [id, value] : permutation) {
+		auto it = std::find_if(constants.begin(), constants.end(), [id](re::specializationConstant_s const& constant) { return constant.id == id; });
+		if (it == constants.end())
+			throw std::runtime_error("shader has no specialization constant " + std::to_string(id));
+		it->value = value;
+	}
+	return constants;
+}
+
+uint64_t re::PermutationCache::hashConstants(std::vector<re::specializationConstant_s> const& constants)
+{
+	std::vector<uint32_t> words;
+	words.reserve(constants.size() * 2);
+	for (int i = 0; i < constants.size(); i++) {
+		words.push_back(constants[i].id);
+		words.push_back(constants[i].value);
+	}
+	return re::hashCode(words);
+}
+
+re::computePipeline_ptr re::PermutationCache::find(uint64_t hash, std::vector<re::specializationConstant_s> const& constants) const
+{
+	auto range = pipelines.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++) {
+		std::vector<re::specializationConstant_s> const& other = it->second->constants;
+		if (other.size() == constants.size() && std::equal(other.begin(), other.end(), constants.begin(),
+			[](re::specializationConstant_s const& a, re::specializationConstant_s const& b) { return a.id == b.id && a.value == b.value; }))
+			return it->second;
+	}
+	return nullptr;
+}
+
+// the expensive part, run outside the lock and in parallel by the prewarm jobs
+re::computePipeline_ptr re::PermutationCache::build(uint64_t hash, std::vector<re::specializationConstant_s> const& constants)
+{
+	re::computePipeline_ptr pipeline;
+
+	try {
+		pipeline = std::make_shared<re::ComputePipeline>(device, *shader, layout, constants, cache);
+	}
+	catch (...) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			building.erase(hash);
+		}
+		condition.notify_all();
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		building.erase(hash);
+		pipelines.emplace(hash, pipeline);
+	}
+	condition.notify_all();
+	return pipeline;
+}
+
+// prewarming builds without counting a hitch or logging a use, only get does
+re::computePipeline_ptr re::PermutationCache::acquire(std::vector<re::specializationConstant_s> const& constants, bool use)
+{
+	uint64_t hash = hashConstants(constants);
+	re::computePipeline_ptr pipeline;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this, hash]() { return !building.count(hash); });
+
+		pipeline = find(hash, constants);
+		if (!pipeline) {
+			building.insert(hash);
+			if (use)
+				compiledOnUse++;
+		}
+	}
+	if (!pipeline)
+		pipeline = build(hash, constants);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (use && usedPipelines.insert(pipeline.get()).second)
+		used.push_back(pipeline);
+	return pipeline;
+}
+
+re::computePipeline_ptr re::PermutationCache::get(permutation_t const& permutation)
+{
+	return acquire(resolve(permutation), true);
+}
+
+bool re::PermutationCache::contains(permutation_t const& permutation) const
+{
+	std::vector<re::specializationConstant_s> constants = resolve(permutation);
+	std::lock_guard<std::mutex> lock(mutex);
+	return find(hashConstants(constants), constants) != nullptr;
+}
+
+size_t re::PermutationCache::size(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pipelines.size();
+}
+
+size_t re::PermutationCache::getCompiledOnUse(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return compiledOnUse;
+}
+
+void re::PermutationCache::prewarm(std::vector<permutation_t> const& permutations)
+{
+	for (int i = 0; i < permutations.size(); i++)
+		acquire(resolve(permutations[i]), false);
+}
+
+// a permutation recorded before the shader lost a constant is skipped, the others still warm
+size_t re::PermutationCache::prewarm(re::JobSystem& jobs, re::jobCounter_t& counter, std::vector<permutation_t> const& permutations)
+{
+	size_t submitted = 0;
+
+	for (int i = 0; i < permutations.size(); i++) {
+		std::vector<re::specializationConstant_s> constants;
+		try {
+			constants = resolve(permutations[i]);
+		}
+		catch (std::exception& e) {
+			std::cerr << TERMINAL_COLOR_YELLOW << "skipped permutation " << i << ": " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+			continue;
+		}
+		uint64_t hash = hashConstants(constants);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (building.count(hash) || find(hash, constants))
+				continue;
+			building.insert(hash);
+		}
+
+		jobs.submit([this, hash, constants]() {
+			try {
+				build(hash, constants);
+			}
+			catch (std::exception& e) {
+				std::cerr << TERMINAL_COLOR_YELLOW << "failed to prewarm permutation: " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+			}
+		}, &counter);
+		submitted++;
+	}
+	return submitted;
+}
+
+re::permutation_t re::PermutationCache::parse(std::string const& pairs)
+{
+	std::istringstream stream(pairs);
+	std::string pair;
+	permutation_t permutation;
+
+	while (stream >> pair) {
+		size_t separator = pair.find('=');
+		if (separator == std::string::npos)
+			throw std::runtime_error("invalid permutation: " + pairs);
+		permutation[std::stoul(pair.substr(0, separator))] = static_cast<uint32_t>(std::stoul(pair.substr(separator + 1)));
+	}
+	return permutation;
+}
+
+size_t re::PermutationCache::prewarm(std::string const& path)
+{
+	std::ifstream file(path);
+	std::vector<permutation_t> permutations;
+	std::string line;
+
+	if (!file.is_open())
+		return 0;
+
+	while (std::getline(file, line))
+		permutations.push_back(parse(line));
+
+	// a list recorded before the shader lost a constant still warms what it can
+	size_t built = 0;
+	for (int i = 0; i < permutations.size(); i++) {
+		try {
+			acquire(resolve(permutations[i]), false);
+			built++;
+		}
+		catch (std::exception& e) {
+			std::cerr << TERMINAL_COLOR_YELLOW << "skipped permutation " << i << " of " << path << ": " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+		}
+	}
+	return built;
+}
+
+std::vector<std::string> re::PermutationCache::getRecord(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::string> lines(used.size());
+
+	for (int i = 0; i < used.size(); i++) {
+		std::vector<re::specializationConstant_s> const& constants = used[i]->constants;
+		for (int j = 0; j < constants.size(); j++)
+			lines[i] += (j ? " " : "") + std::to_string(constants[j].id) + "=" + std::to_string(constants[j].value);
+	}
+	return lines;
+}
+
+void re::PermutationCache::record(std::string const& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + path);
+
+	std::vector<std::string> lines = getRecord();
+	for (int i = 0; i < lines.size(); i++)
+		file << lines[i] << "\n";
+}
@@ -0,0 +1,82 @@
+#include "Pipeline.hpp"
+#include <cstddef>
+
+re::PipelineLayout::PipelineLayout(re::Device& device, std::vector<re::descriptorSetLayout_ptr> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants)
+	: setLayouts(setLayouts), pushConstants(pushConstants), device(device)
+{
+	std::vector<VkDescriptorSetLayout> layouts(setLayouts.size());
+	for (int i = 0; i < setLayouts.size(); i++)
+		layouts[i] = setLayouts[i]->ptr;
+
+	VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	layoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+	layoutInfo.pSetLayouts = layouts.data();
+	layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+	layoutInfo.pPushConstantRanges = pushConstants.data();
+
+	if (vkCreatePipelineLayout(device.ptr, &layoutInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline layout");
+}
+
+re::PipelineLayout::~PipelineLayout(void)
+{
+	vkDestroyPipelineLayout(device.ptr, ptr, nullptr);
+}
+
+re::ComputePipeline::ComputePipeline(re::Device& device, re::ShaderModule& shader, std::vector<VkDescriptorSetLayout> const& setLayouts, std::vector<VkPushConstantRange> const& pushConstants) : device(device)
+{
+	VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	layoutInfo.pSetLayouts = setLayouts.data();
+	layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+	layoutInfo.pPushConstantRanges = pushConstants.data();
+
+	if (vkCreatePipelineLayout(device.ptr, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline layout");
+	ownsLayout = true;
+
+	create(shader);
+}
+
+re::ComputePipeline::ComputePipeline(re::Device& device, re::ShaderModule& shader, re::pipelineLayout_ptr const& sharedLayout, std::vector<re::specializationConstant_s> const& constants, VkPipelineCache cache)
+	: layout(sharedLayout->ptr), sharedLayout(sharedLayout), constants(constants), device(device)
+{
+	create(shader, cache);
+}
+
+re::ComputePipeline::ComputePipeline(re::Device& device, re::ShaderModule& shader, re::ComputePipeline const& previous)
+	: layout(previous.layout), sharedLayout(previous.sharedLayout), constants(previous.constants), device(device)
+{
+	create(shader);
+}
+
+re::ComputePipeline::~ComputePipeline(void)
+{
+	vkDestroyPipeline(device.ptr, ptr, nullptr);
+	if (ownsLayout)
+		vkDestroyPipelineLayout(device.ptr, layout, nullptr);
+}
+
+void re::ComputePipeline::create(re::ShaderModule& shader, VkPipelineCache cache)
+{
+	std::vector<VkSpecializationMapEntry> entries(constants.size());
+	for (int i = 0; i < constants.size(); i++)
+		entries[i] = { constants[i].id, static_cast<uint32_t>(i * sizeof(re::specializationConstant_s) + offsetof(re::specializationConstant_s, value)), sizeof(uint32_t) };
+
+	VkSpecializationInfo specialization{};
+	specialization.mapEntryCount = static_cast<uint32_t>(entries.size());
+	specialization.pMapEntries = entries.data();
+	specialization.dataSize = constants.size() * sizeof(re::specializationConstant_s);
+	specialization.pData = constants.data();
+
+	VkComputePipelineCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+	createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	createInfo.stage.module = shader.ptr;
+	createInfo.stage.pName = "main";
+	createInfo.stage.pSpecializationInfo = constants.empty() ? nullptr : &specialization;
+	createInfo.layout = layout;
+
+	if (vkCreateComputePipelines(device.ptr, cache, 1, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create compute pipeline");
+}
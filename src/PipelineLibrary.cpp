@@ -0,0 +1,200 @@
+#include "PipelineLibrary.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+re::PipelineLibrary::PipelineLibrary(re::Device& device, re::LayoutCache& layouts, std::string const& cachePath, std::string const& logPath)
+	: device(device), layouts(layouts), cachePath(cachePath), logPath(logPath)
+{
+	std::vector<char> data = readCache();
+
+	VkPipelineCacheCreateInfo createInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.data();
+
+	if (vkCreatePipelineCache(device.ptr, &createInfo, nullptr, &cache) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline cache");
+	readLog();
+}
+
+re::PipelineLibrary::~PipelineLibrary(void)
+{
+	try {
+		save();
+	}
+	catch (std::exception& e) {
+		std::cerr << TERMINAL_COLOR_RED << e.what() << TERMINAL_COLOR_RESET << std::endl;
+	}
+	permutations.clear();
+	shaders.clear();
+	vkDestroyPipelineCache(device.ptr, cache, nullptr);
+}
+
+std::vector<char> re::PipelineLibrary::readCache(void)
+{
+	std::ifstream file(cachePath, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+		return {};
+
+	std::vector<char> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(data.data(), data.size());
+
+	// drivers should reject foreign data themselves, not all of them do
+	VkPipelineCacheHeaderVersionOne header{};
+	VkPhysicalDeviceProperties const& properties = device.physicalDevice.properties;
+	if (data.size() >= sizeof(header))
+		std::memcpy(&header, data.data(), sizeof(header));
+	if (data.size() < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		|| header.vendorID != properties.vendorID || header.deviceID != properties.deviceID
+		|| std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE)) {
+		std::cerr << TERMINAL_COLOR_YELLOW << "ignored " << cachePath << ", written by another device or driver" << TERMINAL_COLOR_RESET << std::endl;
+		return {};
+	}
+	return data;
+}
+
+// one permutation per line: shader path, LayoutCache::describe of its layout, then the id=value pairs of PermutationCache::record
+void re::PipelineLibrary::readLog(void)
+{
+	std::ifstream file(logPath);
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string shader;
+		std::string layout;
+		std::string pairs;
+
+		if (!(stream >> shader >> layout))
+			continue;
+		std::getline(stream >> std::ws, pairs);
+		logged[shader + " " + layout].push_back(pairs);
+	}
+}
+
+void re::PipelineLibrary::writeLog(void)
+{
+	std::ofstream file(logPath, std::ios::trunc);
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + logPath);
+
+	for (auto const& [key, lines] : logged) {
+		auto it = permutations.find(key);
+		std::vector<std::string> const& record = it != permutations.end() ? it->second->getRecord() : lines;
+		for (int i = 0; i < record.size(); i++)
+			file << key << (record[i].empty() ? "" : " ") << record[i] << "\n";
+	}
+	for (auto const& [key, cache] : permutations) {
+		if (logged.count(key))
+			continue;
+		std::vector<std::string> record = cache->getRecord();
+		for (int i = 0; i < record.size(); i++)
+			file << key << (record[i].empty() ? "" : " ") << record[i] << "\n";
+	}
+}
+
+void re::PipelineLibrary::save(void)
+{
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device.ptr, cache, &size, nullptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to get pipeline cache data");
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device.ptr, cache, &size, data.data()) != VK_SUCCESS)
+		throw std::runtime_error("failed to get pipeline cache data");
+
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + cachePath);
+	file.write(data.data(), size);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	writeLog();
+}
+
+re::shaderModule_ptr re::PipelineLibrary::getShader(std::string const& shaderPath)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = shaders.find(shaderPath);
+		if (it != shaders.end())
+			return it->second;
+	}
+
+	// loaded outside the lock, two threads racing for the same module keep the first one
+	re::shaderModule_ptr shader = std::make_shared<re::ShaderModule>(device, shaderPath);
+	std::lock_guard<std::mutex> lock(mutex);
+	return shaders.emplace(shaderPath, shader).first->second;
+}
+
+re::PermutationCache& re::PipelineLibrary::getPermutations(std::string const& shaderPath, re::pipelineLayout_ptr const& layout)
+{
+	re::shaderModule_ptr shader = getShader(shaderPath);
+	std::lock_guard<std::mutex> lock(mutex);
+	re::pipelineLayout_ptr pipelineLayout = layout ? layout : layouts.getPipelineLayout(std::vector<re::ShaderModule const*>{ shader.get() });
+	std::string key = shaderPath + " " + re::LayoutCache::describe(*pipelineLayout);
+
+	auto it = permutations.find(key);
+	if (it != permutations.end())
+		return *it->second;
+	return *permutations.emplace(key, std::make_unique<re::PermutationCache>(device, shader, pipelineLayout, cache)).first->second;
+}
+
+re::computePipeline_ptr re::PipelineLibrary::getCompute(std::string const& shaderPath, re::pipelineLayout_ptr const& layout, re::permutation_t const& permutation)
+{
+	return getPermutations(shaderPath, layout).get(permutation);
+}
+
+size_t re::PipelineLibrary::getLoggedCount(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for (auto const& [shader, lines] : logged)
+		count += lines.size();
+	return count;
+}
+
+size_t re::PipelineLibrary::getCompiledOnUse(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for (auto const& [shader, cache] : permutations)
+		count += cache->getCompiledOnUse();
+	return count;
+}
+
+// the modules load here, the pipelines on the jobs
+size_t re::PipelineLibrary::prewarm(re::JobSystem& jobs, re::jobCounter_t& counter)
+{
+	std::map<std::string, std::vector<std::string>> states;
+	size_t submitted = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		states = logged;
+	}
+
+	for (auto const& [key, lines] : states) {
+		std::string shader = key.substr(0, key.find(' '));
+		try {
+			std::vector<re::permutation_t> list(lines.size());
+			for (int i = 0; i < lines.size(); i++)
+				list[i] = re::PermutationCache::parse(lines[i]);
+			re::pipelineLayout_ptr layout;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				layout = layouts.getPipelineLayout(key.substr(shader.size() + 1));
+			}
+			submitted += getPermutations(shader, layout).prewarm(jobs, counter, list);
+		}
+		catch (std::exception& e) {
+			// a shader that is gone or broken leaves the log, a later use logs it again
+			std::cerr << TERMINAL_COLOR_YELLOW << "failed to prewarm " << shader << ": " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+			std::lock_guard<std::mutex> lock(mutex);
+			logged.erase(key);
+		}
+	}
+	return submitted;
+}
@@ -0,0 +1,235 @@
+#include "PostProcess.hpp"
+#include <cmath>
+#include <algorithm>
+
+static constexpr uint32_t groupSize = 8;
+static constexpr uint32_t histogramBins = 256;
+static constexpr uint32_t maxBloomLevels = 6;
+
+re::PostProcess::PostProcess(re::Device& device, re::PipelineLibrary& pipelines, re::AsyncCompute& async) : device(device), async(async)
+{
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &linearSampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+	// depth formats do not all support linear filtering
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &pointSampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+
+	histogramBuffer = std::make_shared<re::Buffer>(device, sizeof(uint32_t) * histogramBins,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	exposureBuffer = std::make_shared<re::Buffer>(device, sizeof(float),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	// hdr, depth, bloom, occlusion, output, histogram, exposure
+	std::vector<VkDescriptorSetLayoutBinding> bindings(7);
+	for (uint32_t i = 0; i < bindings.size(); i++)
+		bindings[i] = { i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+	bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+	setLayout = pipelines.getLayouts().getSetLayout(bindings);
+	bloomSetLayout = pipelines.getLayouts().getSetLayout(std::vector<VkDescriptorSetLayoutBinding>{
+		{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+	});
+
+	passes[PASS_SSAO].path = SHADER_PATH "post_ssao.comp.spv";
+	passes[PASS_HISTOGRAM].path = SHADER_PATH "post_histogram.comp.spv";
+	passes[PASS_EXPOSURE].path = SHADER_PATH "post_exposure.comp.spv";
+	passes[PASS_BLOOM_DOWN].path = SHADER_PATH "post_bloom_down.comp.spv";
+	passes[PASS_BLOOM_UP].path = SHADER_PATH "post_bloom_up.comp.spv";
+	passes[PASS_TONE_MAP].path = SHADER_PATH "post_tonemap.comp.spv";
+
+	std::vector<VkPushConstantRange> pushConstants = { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants_s) } };
+	re::pipelineLayout_ptr layout = pipelines.getLayouts().getPipelineLayout({ setLayout }, pushConstants);
+	re::pipelineLayout_ptr bloomLayout = pipelines.getLayouts().getPipelineLayout({ bloomSetLayout }, pushConstants);
+	for (int i = 0; i < PASS_COUNT; i++) {
+		bool bloomPass = i == PASS_BLOOM_DOWN || i == PASS_BLOOM_UP;
+		passes[i].shader = pipelines.getShader(passes[i].path);
+		passes[i].pipeline = pipelines.getCompute(passes[i].path, bloomPass ? bloomLayout : layout);
+	}
+}
+
+re::PostProcess::~PostProcess(void)
+{
+	if (watcher)
+		watcher->remove(this);
+	pool.reset();
+	vkDestroySampler(device.ptr, linearSampler, nullptr);
+	vkDestroySampler(device.ptr, pointSampler, nullptr);
+}
+
+void re::PostProcess::watchShaders(re::ShaderWatcher& watcher)
+{
+	this->watcher = &watcher;
+	for (int i = 0; i < PASS_COUNT; i++)
+		watcher.watch(device, passes[i].path, this, passes[i].shader, passes[i].pipeline);
+}
+
+void re::PostProcess::resize(re::Image& hdr, re::Image& depth)
+{
+	if (this->hdr) {
+		async.unshare(*this->hdr);
+		async.unshare(*this->depth);
+		async.unshare(*output);
+	}
+	this->hdr = &hdr;
+	this->depth = &depth;
+	initialized = false;
+
+	// the bloom chain starts at half resolution and stops before its mips get too small to matter
+	VkExtent2D bloomExtent = { std::max(hdr.extent.width / 2, 1u), std::max(hdr.extent.height / 2, 1u) };
+	uint32_t levels = 1;
+	while (levels < maxBloomLevels && (std::min(bloomExtent.width, bloomExtent.height) >> levels) >= 4)
+		levels++;
+
+	output = std::make_shared<re::Image>(device, hdr.extent, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	occlusion = std::make_shared<re::Image>(device, hdr.extent, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
+	bloom = std::make_shared<re::Image>(device, bloomExtent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, levels);
+
+	async.share(hdr,
+		{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT },
+		{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT });
+	async.share(depth,
+		{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT },
+		{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT });
+	async.share(*output,
+		{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT },
+		{ VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT }, true);
+
+	pool = std::make_shared<re::DescriptorPool>(device, levels * 2, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 + levels * 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 + levels * 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 }
+	});
+
+	set = pool->allocate(*setLayout);
+	re::writeDescriptor(device, set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VkDescriptorImageInfo{ linearSampler, hdr.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+	re::writeDescriptor(device, set, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VkDescriptorImageInfo{ pointSampler, depth.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+	re::writeDescriptor(device, set, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VkDescriptorImageInfo{ linearSampler, bloom->view, VK_IMAGE_LAYOUT_GENERAL });
+	re::writeDescriptor(device, set, 3, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VkDescriptorImageInfo{ nullptr, occlusion->view, VK_IMAGE_LAYOUT_GENERAL });
+	re::writeDescriptor(device, set, 4, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VkDescriptorImageInfo{ nullptr, output->view, VK_IMAGE_LAYOUT_GENERAL });
+	re::writeDescriptor(device, set, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *histogramBuffer);
+	re::writeDescriptor(device, set, 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *exposureBuffer);
+
+	// down i reads the level above it, the hdr image for the first, up i adds level i + 1 into level i
+	downSets.resize(levels);
+	upSets.resize(levels - 1);
+	for (uint32_t i = 0; i < levels; i++) {
+		VkImageView level = levels > 1 ? bloom->mipViews[i] : bloom->view;
+		downSets[i] = pool->allocate(*bloomSetLayout);
+		VkDescriptorImageInfo source = i == 0
+			? VkDescriptorImageInfo{ linearSampler, hdr.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+			: VkDescriptorImageInfo{ linearSampler, bloom->mipViews[i - 1], VK_IMAGE_LAYOUT_GENERAL };
+		re::writeDescriptor(device, downSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, source);
+		re::writeDescriptor(device, downSets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VkDescriptorImageInfo{ nullptr, level, VK_IMAGE_LAYOUT_GENERAL });
+
+		if (i + 1 < levels) {
+			upSets[i] = pool->allocate(*bloomSetLayout);
+			re::writeDescriptor(device, upSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VkDescriptorImageInfo{ linearSampler, bloom->mipViews[i + 1], VK_IMAGE_LAYOUT_GENERAL });
+			re::writeDescriptor(device, upSets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VkDescriptorImageInfo{ nullptr, level, VK_IMAGE_LAYOUT_GENERAL });
+		}
+	}
+}
+
+void re::PostProcess::setProjection(glm::mat4 const& projection)
+{
+	this->projection = glm::vec4(projection[0][0], projection[1][1], projection[2][2], projection[3][2]);
+}
+
+void re::PostProcess::dispatch(VkCommandBuffer cmd, pass_e pass, VkDescriptorSet set, pushConstants_s const& constants, uint32_t x, uint32_t y)
+{
+	re::ComputePipeline& pipeline = *passes[pass].pipeline;
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.ptr);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &set, 0, nullptr);
+	vkCmdPushConstants(cmd, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(cmd, x, y, 1);
+}
+
+void re::PostProcess::barrier(VkCommandBuffer cmd)
+{
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void re::PostProcess::record(VkCommandBuffer cmd, float deltaTime)
+{
+	if (!hdr)
+		throw std::runtime_error("PostProcess::record called before resize");
+
+	// the intermediates never leave the compute queue, the exposure buffer keeps the adapted luminance across frames
+	if (!initialized) {
+		bloom->barrier(cmd, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		occlusion->barrier(cmd, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		vkCmdFillBuffer(cmd, histogramBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(cmd, exposureBuffer->ptr, 0, VK_WHOLE_SIZE, 0);
+
+		VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		initialized = true;
+	}
+	else {
+		// last frame reset the histogram and its tone map read the bloom chain and the occlusion
+		barrier(cmd);
+	}
+
+	VkExtent2D extent = hdr->extent;
+	pushConstants_s constants{};
+	constants.projection = projection;
+	constants.size = glm::vec2(extent.width, extent.height);
+	constants.minLogLuminance = settings.minLogLuminance;
+	constants.logLuminanceRange = settings.logLuminanceRange;
+	constants.adaptation = 1.0f - std::exp(-deltaTime * settings.adaptationRate);
+	constants.bloomThreshold = settings.bloomThreshold;
+	constants.bloomIntensity = settings.bloomIntensity;
+	constants.aoRadius = settings.aoRadius;
+	constants.aoIntensity = settings.aoIntensity;
+	constants.exposureCompensation = settings.exposureCompensation;
+
+	uint32_t groupsX = (extent.width + groupSize - 1) / groupSize;
+	uint32_t groupsY = (extent.height + groupSize - 1) / groupSize;
+
+	// both only read the frame, the histogram is reset by the exposure pass after it is read
+	dispatch(cmd, PASS_SSAO, set, constants, groupsX, groupsY);
+	dispatch(cmd, PASS_HISTOGRAM, set, constants, groupsX, groupsY);
+	barrier(cmd);
+	dispatch(cmd, PASS_EXPOSURE, set, constants, 1, 1);
+
+	for (uint32_t i = 0; i < bloom->mipLevels; i++) {
+		VkExtent2D level = { std::max(bloom->extent.width >> i, 1u), std::max(bloom->extent.height >> i, 1u) };
+		constants.size = glm::vec2(level.width, level.height);
+		constants.mip = i;
+		dispatch(cmd, PASS_BLOOM_DOWN, downSets[i], constants, (level.width + groupSize - 1) / groupSize, (level.height + groupSize - 1) / groupSize);
+		barrier(cmd);
+	}
+	for (uint32_t i = bloom->mipLevels - 1; i > 0; i--) {
+		VkExtent2D level = { std::max(bloom->extent.width >> (i - 1), 1u), std::max(bloom->extent.height >> (i - 1), 1u) };
+		constants.size = glm::vec2(level.width, level.height);
+		constants.mip = i - 1;
+		dispatch(cmd, PASS_BLOOM_UP, upSets[i - 1], constants, (level.width + groupSize - 1) / groupSize, (level.height + groupSize - 1) / groupSize);
+		barrier(cmd);
+	}
+
+	constants.size = glm::vec2(extent.width, extent.height);
+	dispatch(cmd, PASS_TONE_MAP, set, constants, groupsX, groupsY);
+}
@@ -0,0 +1,115 @@
+#include "QuantizedMesh.hpp"
+#include "Shader.hpp"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+static float signNotZero(float v)
+{
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+glm::i16vec2 re::encodeOctahedral(glm::vec3 n)
+{
+	float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	glm::vec2 p = length > 0.0f ? glm::vec2(n.x, n.y) / length : glm::vec2(0.0f);
+
+	if (n.z < 0.0f)
+		p = glm::vec2((1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y));
+	return glm::i16vec2(glm::round(glm::clamp(p, -1.0f, 1.0f) * 32767.0f));
+}
+
+glm::vec3 re::decodeOctahedral(glm::i16vec2 encoded)
+{
+	glm::vec2 p = glm::max(glm::vec2(encoded) / 32767.0f, -1.0f);
+	glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+
+	if (n.z < 0.0f) {
+		n.x = (1.0f - std::abs(p.y)) * signNotZero(p.x);
+		n.y = (1.0f - std::abs(p.x)) * signNotZero(p.y);
+	}
+	return glm::normalize(n);
+}
+
+re::QuantizedMesh re::quantizeMesh(re::Mesh const& mesh)
+{
+	QuantizedMesh result;
+	glm::vec3 min(INFINITY), max(-INFINITY);
+
+	for (int i = 0; i < mesh.vertices.size(); i++) {
+		min = glm::min(min, mesh.vertices[i].position);
+		max = glm::max(max, mesh.vertices[i].position);
+	}
+	if (mesh.vertices.empty())
+		min = max = glm::vec3(0.0f);
+
+	result.positionOffset = min;
+	result.positionScale = max - min;
+	result.indices = mesh.indices;
+	result.vertices.resize(mesh.vertices.size());
+
+	// flat axes keep a scale of 0 and quantize to 0
+	glm::vec3 inverseScale(0.0f);
+	for (int k = 0; k < 3; k++)
+		if (result.positionScale[k] > 0.0f)
+			inverseScale[k] = 65535.0f / result.positionScale[k];
+
+	for (int i = 0; i < mesh.vertices.size(); i++) {
+		Vertex const& vertex = mesh.vertices[i];
+		PackedVertex& packed = result.vertices[i];
+		glm::vec3 q = glm::round(glm::clamp((vertex.position - min) * inverseScale, 0.0f, 65535.0f));
+		glm::i16vec2 normal = encodeOctahedral(vertex.normal);
+
+		packed.position[0] = static_cast<uint16_t>(q.x);
+		packed.position[1] = static_cast<uint16_t>(q.y);
+		packed.position[2] = static_cast<uint16_t>(q.z);
+		packed.position[3] = 0;
+		packed.normal[0] = normal.x;
+		packed.normal[1] = normal.y;
+		packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+		packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
+	}
+	return result;
+}
+
+re::Mesh re::dequantizeMesh(QuantizedMesh const& mesh)
+{
+	Mesh result;
+
+	result.indices = mesh.indices;
+	result.vertices.resize(mesh.vertices.size());
+	for (int i = 0; i < mesh.vertices.size(); i++) {
+		PackedVertex const& packed = mesh.vertices[i];
+		glm::vec3 unorm = glm::vec3(packed.position[0], packed.position[1], packed.position[2]) / 65535.0f;
+
+		result.vertices[i].position = mesh.positionOffset + unorm * mesh.positionScale;
+		result.vertices[i].normal = decodeOctahedral(glm::i16vec2(packed.normal[0], packed.normal[1]));
+		result.vertices[i].uv = glm::vec2(glm::unpackHalf1x16(packed.uv[0]), glm::unpackHalf1x16(packed.uv[1]));
+	}
+	return result;
+}
+
+// R32G32B32A32_UINT vertex fetch is mandatory, the other three formats are checked
+re::vertexInputLayout_s re::getQuantizedVertexLayout(re::PhysicalDevice& physicalDevice, uint32_t binding)
+{
+	vertexInputLayout_s layout{};
+	VkFormat formats[3] = { VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16_SFLOAT };
+	uint32_t offsets[3] = { offsetof(PackedVertex, position), offsetof(PackedVertex, normal), offsetof(PackedVertex, uv) };
+
+	layout.binding = { binding, sizeof(PackedVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+	layout.packed = !std::all_of(formats, formats + 3, [&](VkFormat format) {
+		return physicalDevice.supportsBufferFormat(format, VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT);
+	});
+
+	if (layout.packed) {
+		layout.attributes.push_back({ 0, binding, VK_FORMAT_R32G32B32A32_UINT, 0 });
+		layout.shaderPath = SHADER_PATH "mesh_packed.vert.spv";
+		return layout;
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+		layout.attributes.push_back({ i, binding, formats[i], offsets[i] });
+	layout.shaderPath = SHADER_PATH "mesh_quantized.vert.spv";
+	return layout;
+}
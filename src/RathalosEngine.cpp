@@ -2,6 +2,13 @@
 
 re::RathalosEngine::RathalosEngine(void)
 {
+	// the pipelines used by previous runs are built while loading instead of on first use
+	re::jobCounter_t counter{ 0 };
+	size_t prewarmed = pipelines.prewarm(jobs, counter);
+	jobs.wait(counter);
+	if (prewarmed)
+		std::cout << "prewarmed " << prewarmed << " pipelines" << std::endl;
+
 	std::cout << "RathalosEngine created" << std::endl;
 }
 
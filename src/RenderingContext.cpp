@@ -0,0 +1,213 @@
+#include "RenderingContext.hpp"
+#include <algorithm>
+
+// a framebuffer unused this long is destroyed, passes that skip frames keep theirs
+static constexpr uint64_t framebufferIdleFrames = 120;
+
+static bool hasStencil(VkFormat format)
+{
+	return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT
+		|| format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+static VkRenderingAttachmentInfoKHR getAttachmentInfo(re::attachment_s const& attachment)
+{
+	VkRenderingAttachmentInfoKHR info{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR };
+	info.imageView = attachment.view;
+	info.imageLayout = attachment.layout;
+	info.loadOp = attachment.loadOp;
+	info.storeOp = attachment.storeOp;
+	info.clearValue = attachment.clear;
+	return info;
+}
+
+re::RenderingContext::RenderingContext(re::Device& device) : device(device)
+{
+}
+
+re::RenderingContext::~RenderingContext(void)
+{
+	for (auto const& framebuffer : framebuffers)
+		vkDestroyFramebuffer(device.ptr, framebuffer.second.ptr, nullptr);
+	for (int i = 0; i < graveyard.size(); i++)
+		vkDestroyFramebuffer(device.ptr, graveyard[i].second, nullptr);
+	for (auto const& renderPass : renderPasses)
+		vkDestroyRenderPass(device.ptr, renderPass.second, nullptr);
+}
+
+void re::RenderingContext::begin(VkCommandBuffer cmd, re::renderingInfo_s const& info)
+{
+	if (device.dynamicRendering)
+		beginDynamic(cmd, info);
+	else
+		beginRenderPass(cmd, info);
+}
+
+void re::RenderingContext::end(VkCommandBuffer cmd)
+{
+	if (device.dynamicRendering)
+		device.cmdEndRendering(cmd);
+	else
+		vkCmdEndRenderPass(cmd);
+}
+
+void re::RenderingContext::beginDynamic(VkCommandBuffer cmd, re::renderingInfo_s const& info)
+{
+	std::vector<VkRenderingAttachmentInfoKHR> colors(info.colors.size());
+	for (int i = 0; i < info.colors.size(); i++)
+		colors[i] = getAttachmentInfo(info.colors[i]);
+	VkRenderingAttachmentInfoKHR depth = getAttachmentInfo(info.depth);
+
+	VkRenderingInfoKHR renderingInfo{ VK_STRUCTURE_TYPE_RENDERING_INFO_KHR };
+	renderingInfo.renderArea = { { 0, 0 }, info.extent };
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colors.size());
+	renderingInfo.pColorAttachments = colors.data();
+	if (info.depth.view) {
+		renderingInfo.pDepthAttachment = &depth;
+		if (hasStencil(info.depth.format))
+			renderingInfo.pStencilAttachment = &depth;
+	}
+	device.cmdBeginRendering(cmd, &renderingInfo);
+}
+
+void re::RenderingContext::beginRenderPass(VkCommandBuffer cmd, re::renderingInfo_s const& info)
+{
+	VkRenderPass renderPass = getRenderPass(info);
+	std::vector<VkClearValue> clears;
+
+	for (int i = 0; i < info.colors.size(); i++)
+		clears.push_back(info.colors[i].clear);
+	if (info.depth.view)
+		clears.push_back(info.depth.clear);
+
+	VkRenderPassBeginInfo beginInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+	beginInfo.renderPass = renderPass;
+	beginInfo.framebuffer = getFramebuffer(renderPass, info);
+	beginInfo.renderArea = { { 0, 0 }, info.extent };
+	beginInfo.clearValueCount = static_cast<uint32_t>(clears.size());
+	beginInfo.pClearValues = clears.data();
+	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+VkRenderPass re::RenderingContext::getRenderPass(re::renderingInfo_s const& info)
+{
+	if (device.dynamicRendering)
+		return nullptr;
+
+	std::vector<uint32_t> key;
+	for (int i = 0; i < info.colors.size(); i++)
+		key.insert(key.end(), { static_cast<uint32_t>(info.colors[i].format), static_cast<uint32_t>(info.colors[i].layout),
+			static_cast<uint32_t>(info.colors[i].loadOp), static_cast<uint32_t>(info.colors[i].storeOp) });
+	if (info.depth.view)
+		key.insert(key.end(), { static_cast<uint32_t>(info.depth.format), static_cast<uint32_t>(info.depth.layout),
+			static_cast<uint32_t>(info.depth.loadOp), static_cast<uint32_t>(info.depth.storeOp) });
+
+	auto it = renderPasses.find(key);
+	if (it != renderPasses.end())
+		return it->second;
+
+	// initial and final layouts are the pass layout so the render pass transitions nothing, like dynamic rendering
+	std::vector<VkAttachmentDescription> descriptions;
+	std::vector<VkAttachmentReference> colorReferences;
+	VkAttachmentReference depthReference{};
+
+	for (int i = 0; i < info.colors.size(); i++) {
+		re::attachment_s const& color = info.colors[i];
+		descriptions.push_back({ 0, color.format, VK_SAMPLE_COUNT_1_BIT, color.loadOp, color.storeOp,
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, color.layout, color.layout });
+		colorReferences.push_back({ static_cast<uint32_t>(i), color.layout });
+	}
+	if (info.depth.view) {
+		re::attachment_s const& depth = info.depth;
+		bool stencil = hasStencil(depth.format);
+		descriptions.push_back({ 0, depth.format, VK_SAMPLE_COUNT_1_BIT, depth.loadOp, depth.storeOp,
+			stencil ? depth.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE, stencil ? depth.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE, depth.layout, depth.layout });
+		depthReference = { static_cast<uint32_t>(info.colors.size()), depth.layout };
+	}
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+	subpass.pColorAttachments = colorReferences.data();
+	subpass.pDepthStencilAttachment = info.depth.view ? &depthReference : nullptr;
+
+	VkRenderPassCreateInfo createInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+	createInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+	createInfo.pAttachments = descriptions.data();
+	createInfo.subpassCount = 1;
+	createInfo.pSubpasses = &subpass;
+
+	VkRenderPass renderPass;
+	if (vkCreateRenderPass(device.ptr, &createInfo, nullptr, &renderPass) != VK_SUCCESS)
+		throw std::runtime_error("failed to create render pass");
+	renderPasses[key] = renderPass;
+	return renderPass;
+}
+
+VkFramebuffer re::RenderingContext::getFramebuffer(VkRenderPass renderPass, re::renderingInfo_s const& info)
+{
+	std::vector<VkImageView> views;
+	for (int i = 0; i < info.colors.size(); i++)
+		views.push_back(info.colors[i].view);
+	if (info.depth.view)
+		views.push_back(info.depth.view);
+
+	std::vector<uint64_t> key{ reinterpret_cast<uint64_t>(renderPass), info.extent.width, info.extent.height };
+	for (int i = 0; i < views.size(); i++)
+		key.push_back(reinterpret_cast<uint64_t>(views[i]));
+
+	auto it = framebuffers.find(key);
+	if (it != framebuffers.end()) {
+		it->second.lastUsedFrame = frame;
+		return it->second.ptr;
+	}
+
+	VkFramebufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+	createInfo.renderPass = renderPass;
+	createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	createInfo.pAttachments = views.data();
+	createInfo.width = info.extent.width;
+	createInfo.height = info.extent.height;
+	createInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	if (vkCreateFramebuffer(device.ptr, &createInfo, nullptr, &framebuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to create framebuffer");
+	framebuffers[key] = { framebuffer, frame };
+	return framebuffer;
+}
+
+void re::RenderingContext::releaseViews(std::vector<VkImageView> const& views)
+{
+	for (auto it = framebuffers.begin(); it != framebuffers.end();) {
+		bool uses = false;
+		for (int i = 3; i < it->first.size(); i++)
+			uses |= std::find(views.begin(), views.end(), reinterpret_cast<VkImageView>(it->first[i])) != views.end();
+
+		if (uses) {
+			graveyard.push_back({ frame, it->second.ptr });
+			it = framebuffers.erase(it);
+		}
+		else
+			it++;
+	}
+}
+
+void re::RenderingContext::nextFrame(void)
+{
+	frame++;
+	while (!graveyard.empty() && graveyard.front().first + FRAMES_IN_FLIGHT <= frame) {
+		vkDestroyFramebuffer(device.ptr, graveyard.front().second, nullptr);
+		graveyard.pop_front();
+	}
+
+	for (auto it = framebuffers.begin(); it != framebuffers.end();) {
+		if (it->second.lastUsedFrame + framebufferIdleFrames <= frame) {
+			vkDestroyFramebuffer(device.ptr, it->second.ptr, nullptr);
+			it = framebuffers.erase(it);
+		}
+		else
+			it++;
+	}
+}
@@ -0,0 +1,214 @@
+#include "Scene.hpp"
+#include <mutex>
+#include <algorithm>
+
+static std::mutex componentMutex;
+
+std::vector<re::componentInfo_s>& re::ComponentRegistry::infos(void)
+{
+	static std::vector<componentInfo_s> vec = []() {
+		std::vector<componentInfo_s> v;
+		v.reserve(MAX_COMPONENTS);
+		return v;
+	}();
+	return vec;
+}
+
+uint32_t re::ComponentRegistry::add(componentInfo_s const& info)
+{
+	std::lock_guard<std::mutex> lock(componentMutex);
+	std::vector<componentInfo_s>& vec = infos();
+
+	if (vec.size() >= MAX_COMPONENTS)
+		throw std::runtime_error("too many component types");
+
+	vec.push_back(info);
+	return static_cast<uint32_t>(vec.size() - 1);
+}
+
+re::componentInfo_s const& re::ComponentRegistry::get(uint32_t id)
+{
+	return infos()[id];
+}
+
+static size_t alignOffset(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+re::Archetype::Archetype(signature_t signature) : signature(signature)
+{
+	size_t rowSize = sizeof(Entity);
+
+	for (uint32_t i = 0; i < MAX_COMPONENTS; i++) {
+		if (!signature.test(i))
+			continue;
+		components.push_back(i);
+		rowSize += ComponentRegistry::get(i).size;
+	}
+
+	capacity = std::max<uint32_t>(1, static_cast<uint32_t>(CHUNK_SIZE / rowSize));
+	for (;;) {
+		size_t offset = sizeof(Entity) * capacity;
+		for (int i = 0; i < components.size(); i++) {
+			componentInfo_s const& info = ComponentRegistry::get(components[i]);
+			offset = alignOffset(offset, info.alignment);
+			offsets[components[i]] = offset;
+			offset += info.size * capacity;
+		}
+		if (offset <= CHUNK_SIZE || capacity == 1) {
+			chunkSize = std::max(CHUNK_SIZE, offset);
+			break;
+		}
+		capacity--;
+	}
+}
+
+re::Archetype::~Archetype(void)
+{
+	for (int i = 0; i < chunks.size(); i++) {
+		for (uint32_t row = 0; row < chunks[i].count; row++)
+			for (int j = 0; j < components.size(); j++)
+				ComponentRegistry::get(components[j]).destroy(at(i, row, components[j]));
+		::operator delete(chunks[i].data, std::align_val_t(64));
+	}
+}
+
+void re::Archetype::allocateRow(Entity entity, uint32_t& chunk, uint32_t& row)
+{
+	if (chunks.empty() || chunks.rbegin()->count == capacity)
+		chunks.push_back({ static_cast<std::byte*>(::operator new(chunkSize, std::align_val_t(64))), 0 });
+
+	chunk = static_cast<uint32_t>(chunks.size() - 1);
+	row = chunks[chunk].count++;
+	entities(chunks[chunk])[row] = entity;
+	entityCount++;
+}
+
+// destroys the row and fills the hole with the archetype's last row so chunks stay dense,
+// returns the entity that was moved into the hole (or an invalid one)
+re::Entity re::Archetype::removeRow(uint32_t chunk, uint32_t row)
+{
+	uint32_t lastChunk = static_cast<uint32_t>(chunks.size() - 1);
+	uint32_t lastRow = chunks[lastChunk].count - 1;
+	Entity moved{};
+
+	for (int i = 0; i < components.size(); i++) {
+		componentInfo_s const& info = ComponentRegistry::get(components[i]);
+		info.destroy(at(chunk, row, components[i]));
+		if (chunk != lastChunk || row != lastRow) {
+			info.moveConstruct(at(chunk, row, components[i]), at(lastChunk, lastRow, components[i]));
+			info.destroy(at(lastChunk, lastRow, components[i]));
+		}
+	}
+
+	if (chunk != lastChunk || row != lastRow) {
+		moved = entities(chunks[lastChunk])[lastRow];
+		entities(chunks[chunk])[row] = moved;
+	}
+
+	chunks[lastChunk].count--;
+	entityCount--;
+	if (!chunks[lastChunk].count) {
+		::operator delete(chunks[lastChunk].data, std::align_val_t(64));
+		chunks.pop_back();
+	}
+	return moved;
+}
+
+re::Scene::~Scene(void)
+{
+	archetypes.clear();
+	archetypeMap.clear();
+}
+
+re::Entity re::Scene::allocate(void)
+{
+	uint32_t index;
+
+	if (!freeIndices.empty()) {
+		index = *freeIndices.rbegin();
+		freeIndices.pop_back();
+	}
+	else {
+		index = static_cast<uint32_t>(records.size());
+		records.push_back({});
+	}
+	return { index, records[index].generation };
+}
+
+re::Entity re::Scene::create(void)
+{
+	Entity entity = allocate();
+	record_s& record = records[entity.index];
+	Archetype& archetype = getArchetype(signature_t());
+
+	archetype.allocateRow(entity, record.chunk, record.row);
+	record.archetype = &archetype;
+	return entity;
+}
+
+void re::Scene::destroy(Entity entity)
+{
+	record_s& record = getRecord(entity);
+
+	detach(record);
+	record.archetype = nullptr;
+	record.generation++;
+	freeIndices.push_back(entity.index);
+}
+
+bool re::Scene::alive(Entity entity) const
+{
+	return entity.index < records.size() && records[entity.index].archetype && records[entity.index].generation == entity.generation;
+}
+
+re::Scene::record_s& re::Scene::getRecord(Entity entity)
+{
+	if (!alive(entity))
+		throw std::runtime_error("invalid entity");
+	return records[entity.index];
+}
+
+re::Archetype& re::Scene::getArchetype(signature_t signature)
+{
+	auto it = archetypeMap.find(signature);
+	if (it != archetypeMap.end())
+		return *it->second;
+
+	std::unique_ptr<Archetype>& archetype = archetypeMap[signature];
+	archetype = std::make_unique<Archetype>(signature);
+	archetypes.push_back(archetype.get());
+	return *archetype;
+}
+
+void re::Scene::detach(record_s& record)
+{
+	Entity moved = record.archetype->removeRow(record.chunk, record.row);
+
+	if (moved.index != INVALID_UINT32) {
+		records[moved.index].chunk = record.chunk;
+		records[moved.index].row = record.row;
+	}
+}
+
+// components present in both archetypes are moved over, the ones missing in the destination are dropped,
+// the ones missing in the source are left for the caller to construct
+void re::Scene::move(Entity entity, Archetype& destination)
+{
+	record_s& record = records[entity.index];
+	Archetype& source = *record.archetype;
+	uint32_t chunk, row;
+
+	destination.allocateRow(entity, chunk, row);
+	for (int i = 0; i < source.components.size(); i++) {
+		uint32_t id = source.components[i];
+		if (destination.has(id))
+			ComponentRegistry::get(id).moveConstruct(destination.at(chunk, row, id), source.at(record.chunk, record.row, id));
+	}
+
+	detach(record);
+	record.archetype = &destination;
+	record.chunk = chunk;
+	record.row = row;
+}
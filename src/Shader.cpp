@@ -0,0 +1,41 @@
+#include "Shader.hpp"
+#include <fstream>
+
+re::ShaderModule::ShaderModule(re::Device& device, std::string const& path) : device(device)
+{
+	code = readFile(path);
+	hash = hashCode(code);
+	if (!ShaderReflection::loadCache(path + ".refl", hash, reflection)) {
+		reflection = ShaderReflection::reflect(code);
+		ShaderReflection::saveCache(path + ".refl", hash, reflection);
+	}
+
+	VkShaderModuleCreateInfo createInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+	createInfo.codeSize = code.size() * sizeof(uint32_t);
+	createInfo.pCode = code.data();
+
+	if (vkCreateShaderModule(device.ptr, &createInfo, nullptr, &ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to create shader module: " + path);
+}
+
+re::ShaderModule::~ShaderModule(void)
+{
+	vkDestroyShaderModule(device.ptr, ptr, nullptr);
+}
+
+std::vector<uint32_t> re::ShaderModule::readFile(std::string const& path)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + path);
+
+	size_t size = static_cast<size_t>(file.tellg());
+	if (size % sizeof(uint32_t))
+		throw std::runtime_error("invalid SPIR-V file: " + path);
+
+	std::vector<uint32_t> buffer(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(buffer.data()), size);
+	return buffer;
+}
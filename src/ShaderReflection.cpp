@@ -0,0 +1,381 @@
+#include "ShaderReflection.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+
+namespace {
+
+	enum spvOp_e : uint32_t {
+		OP_ENTRY_POINT = 15,
+		OP_EXECUTION_MODE = 16,
+		OP_TYPE_BOOL = 20,
+		OP_TYPE_INT = 21,
+		OP_TYPE_FLOAT = 22,
+		OP_TYPE_VECTOR = 23,
+		OP_TYPE_MATRIX = 24,
+		OP_TYPE_IMAGE = 25,
+		OP_TYPE_SAMPLER = 26,
+		OP_TYPE_SAMPLED_IMAGE = 27,
+		OP_TYPE_ARRAY = 28,
+		OP_TYPE_RUNTIME_ARRAY = 29,
+		OP_TYPE_STRUCT = 30,
+		OP_TYPE_POINTER = 32,
+		OP_CONSTANT = 43,
+		OP_SPEC_CONSTANT_TRUE = 48,
+		OP_SPEC_CONSTANT_FALSE = 49,
+		OP_SPEC_CONSTANT = 50,
+		OP_VARIABLE = 59,
+		OP_DECORATE = 71,
+		OP_MEMBER_DECORATE = 72,
+		OP_EXECUTION_MODE_ID = 331,
+		OP_TYPE_ACCELERATION_STRUCTURE = 5341
+	};
+
+	enum spvDecoration_e : uint32_t {
+		DECORATION_SPEC_ID = 1,
+		DECORATION_BLOCK = 2,
+		DECORATION_BUFFER_BLOCK = 3,
+		DECORATION_ARRAY_STRIDE = 6,
+		DECORATION_MATRIX_STRIDE = 7,
+		DECORATION_BUILT_IN = 11,
+		DECORATION_LOCATION = 30,
+		DECORATION_BINDING = 33,
+		DECORATION_DESCRIPTOR_SET = 34,
+		DECORATION_OFFSET = 35
+	};
+
+	enum spvStorageClass_e : uint32_t {
+		STORAGE_UNIFORM_CONSTANT = 0,
+		STORAGE_INPUT = 1,
+		STORAGE_UNIFORM = 2,
+		STORAGE_PUSH_CONSTANT = 9,
+		STORAGE_STORAGE_BUFFER = 12
+	};
+
+	struct spvId_s {
+		uint32_t op = 0;
+		std::vector<uint32_t> operands;
+		uint32_t set = 0;
+		uint32_t binding = INVALID;
+		uint32_t location = INVALID;
+		uint32_t specId = INVALID;
+		uint32_t arrayStride = 0;
+		bool block = false;
+		bool bufferBlock = false;
+		bool builtIn = false;
+		std::vector<uint32_t> memberOffsets;
+		std::vector<uint32_t> memberMatrixStrides;
+
+		static constexpr uint32_t INVALID = static_cast<uint32_t>(-1);
+	};
+
+	// byte size of a type inside a block, only what push constants need
+	uint32_t getTypeSize(std::vector<spvId_s> const& ids, uint32_t typeId, uint32_t matrixStride = 0)
+	{
+		spvId_s const& type = ids[typeId];
+
+		switch (type.op) {
+		case OP_TYPE_BOOL:
+			return 4;
+		case OP_TYPE_INT:
+		case OP_TYPE_FLOAT:
+			return type.operands[0] / 8;
+		case OP_TYPE_VECTOR:
+			return getTypeSize(ids, type.operands[0]) * type.operands[1];
+		case OP_TYPE_MATRIX:
+			return (matrixStride ? matrixStride : getTypeSize(ids, type.operands[0])) * type.operands[1];
+		case OP_TYPE_ARRAY: {
+			spvId_s const& length = ids[type.operands[1]];
+			uint32_t count = length.op == OP_CONSTANT ? length.operands[2] : 1;
+			return (type.arrayStride ? type.arrayStride : getTypeSize(ids, type.operands[0])) * count;
+		}
+		case OP_TYPE_STRUCT: {
+			uint32_t size = 0;
+			for (uint32_t i = 0; i < type.operands.size(); i++) {
+				uint32_t offset = i < type.memberOffsets.size() ? type.memberOffsets[i] : size;
+				uint32_t stride = i < type.memberMatrixStrides.size() ? type.memberMatrixStrides[i] : 0;
+				size = std::max(size, offset + getTypeSize(ids, type.operands[i], stride));
+			}
+			return size;
+		}
+		default:
+			return 0;
+		}
+	}
+
+	VkFormat getVertexFormat(std::vector<spvId_s> const& ids, uint32_t typeId)
+	{
+		static constexpr VkFormat floats[4] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static constexpr VkFormat sints[4] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static constexpr VkFormat uints[4] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+		spvId_s const& type = ids[typeId];
+		uint32_t components = 1;
+		spvId_s const* scalar = &type;
+
+		if (type.op == OP_TYPE_VECTOR) {
+			components = std::clamp(type.operands[1], 1u, 4u);
+			scalar = &ids[type.operands[0]];
+		}
+		if (scalar->op == OP_TYPE_FLOAT && scalar->operands[0] == 32)
+			return floats[components - 1];
+		if (scalar->op == OP_TYPE_INT && scalar->operands[0] == 32)
+			return scalar->operands[1] ? sints[components - 1] : uints[components - 1];
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	// 0 for the execution models reflection does not cover, mesh, task and ray tracing
+	VkShaderStageFlags getStage(uint32_t executionModel)
+	{
+		switch (executionModel) {
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default: return 0;
+		}
+	}
+
+	struct cacheHeader_s {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t codeHash;
+		uint32_t stage;
+		uint32_t pushConstantSize;
+		uint32_t localSize[3];
+		uint32_t bindingCount;
+		uint32_t vertexInputCount;
+		uint32_t specConstantCount;
+	};
+}
+
+// FNV-1a over the words
+uint64_t re::hashCode(std::vector<uint32_t> const& code)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (int i = 0; i < code.size(); i++)
+		hash = (hash ^ code[i]) * 0x100000001b3ull;
+	return hash;
+}
+
+// one pass collecting types and decorations, resources are resolved once every id is known
+// the module is expected to have a single entry point, a stage reflection does not cover is left empty
+re::ShaderReflection re::ShaderReflection::reflect(std::vector<uint32_t> const& code)
+{
+	ShaderReflection reflection;
+
+	if (code.size() < 5 || code[0] != 0x07230203)
+		throw std::runtime_error("invalid SPIR-V module");
+
+	std::vector<spvId_s> ids(code[3]);
+	std::vector<uint32_t> variables;
+	std::vector<uint32_t> specConstants;
+	uint32_t const* localSizeIds = nullptr;
+
+	for (size_t i = 5; i < code.size();) {
+		uint32_t op = code[i] & 0xffff;
+		uint32_t count = code[i] >> 16;
+		uint32_t const* words = &code[i + 1];
+
+		if (!count || i + count > code.size())
+			throw std::runtime_error("truncated SPIR-V module");
+
+		switch (op) {
+		case OP_ENTRY_POINT: {
+			VkShaderStageFlags stage = getStage(words[0]);
+			if (!stage)
+				return ShaderReflection();
+			reflection.stage = static_cast<VkShaderStageFlagBits>(stage);
+			break;
+		}
+		case OP_EXECUTION_MODE:
+		case OP_EXECUTION_MODE_ID:
+			// LocalSize, LocalSizeId refers to constants declared later
+			if (words[1] == 17 && count >= 6)
+				std::memcpy(reflection.localSize, &words[2], sizeof(reflection.localSize));
+			else if (words[1] == 38 && count >= 6)
+				localSizeIds = &words[2];
+			break;
+		case OP_TYPE_BOOL:
+		case OP_TYPE_INT:
+		case OP_TYPE_FLOAT:
+		case OP_TYPE_VECTOR:
+		case OP_TYPE_MATRIX:
+		case OP_TYPE_IMAGE:
+		case OP_TYPE_SAMPLER:
+		case OP_TYPE_SAMPLED_IMAGE:
+		case OP_TYPE_ARRAY:
+		case OP_TYPE_RUNTIME_ARRAY:
+		case OP_TYPE_STRUCT:
+		case OP_TYPE_POINTER:
+		case OP_TYPE_ACCELERATION_STRUCTURE:
+			ids[words[0]].op = op;
+			ids[words[0]].operands.assign(words + 1, words + count - 1);
+			break;
+		case OP_CONSTANT:
+		case OP_SPEC_CONSTANT_TRUE:
+		case OP_SPEC_CONSTANT_FALSE:
+		case OP_SPEC_CONSTANT:
+		case OP_VARIABLE:
+			// result type, result id, then the value or the storage class
+			ids[words[1]].op = op;
+			ids[words[1]].operands.assign(words, words + count - 1);
+			if (op == OP_VARIABLE)
+				variables.push_back(words[1]);
+			else if (op != OP_CONSTANT)
+				specConstants.push_back(words[1]);
+			break;
+		case OP_DECORATE: {
+			spvId_s& target = ids[words[0]];
+			switch (words[1]) {
+			case DECORATION_SPEC_ID: target.specId = words[2]; break;
+			case DECORATION_BLOCK: target.block = true; break;
+			case DECORATION_BUFFER_BLOCK: target.bufferBlock = true; break;
+			case DECORATION_ARRAY_STRIDE: target.arrayStride = words[2]; break;
+			case DECORATION_BUILT_IN: target.builtIn = true; break;
+			case DECORATION_LOCATION: target.location = words[2]; break;
+			case DECORATION_BINDING: target.binding = words[2]; break;
+			case DECORATION_DESCRIPTOR_SET: target.set = words[2]; break;
+			}
+			break;
+		}
+		case OP_MEMBER_DECORATE: {
+			spvId_s& target = ids[words[0]];
+			uint32_t member = words[1];
+			if (words[2] == DECORATION_OFFSET) {
+				target.memberOffsets.resize(std::max<size_t>(target.memberOffsets.size(), member + 1), 0);
+				target.memberOffsets[member] = words[3];
+			}
+			else if (words[2] == DECORATION_MATRIX_STRIDE) {
+				target.memberMatrixStrides.resize(std::max<size_t>(target.memberMatrixStrides.size(), member + 1), 0);
+				target.memberMatrixStrides[member] = words[3];
+			}
+			else if (words[2] == DECORATION_BUILT_IN)
+				target.builtIn = true;
+			break;
+		}
+		}
+		i += count;
+	}
+
+	// the default value of a specialization constant, the pipeline may still override it
+	for (int i = 0; localSizeIds && i < 3; i++) {
+		spvId_s const& constant = ids[localSizeIds[i]];
+		if ((constant.op == OP_CONSTANT || constant.op == OP_SPEC_CONSTANT) && constant.operands.size() > 2)
+			reflection.localSize[i] = constant.operands[2];
+	}
+
+	for (int i = 0; i < variables.size(); i++) {
+		spvId_s const& variable = ids[variables[i]];
+		uint32_t storage = variable.operands[2];
+		uint32_t typeId = ids[variable.operands[0]].operands[1];
+
+		if (storage == STORAGE_PUSH_CONSTANT) {
+			reflection.pushConstantSize = std::max(reflection.pushConstantSize, getTypeSize(ids, typeId));
+			continue;
+		}
+		if (storage == STORAGE_INPUT) {
+			if (reflection.stage == VK_SHADER_STAGE_VERTEX_BIT && !variable.builtIn && !ids[typeId].builtIn && variable.location != spvId_s::INVALID)
+				reflection.vertexInputs.push_back({ variable.location, getVertexFormat(ids, typeId) });
+			continue;
+		}
+		if (storage != STORAGE_UNIFORM_CONSTANT && storage != STORAGE_UNIFORM && storage != STORAGE_STORAGE_BUFFER)
+			continue;
+		if (variable.binding == spvId_s::INVALID)
+			continue;
+
+		// arrays of resources become the descriptor count, runtime arrays are left to the caller as 1
+		uint32_t descriptorCount = 1;
+		while (ids[typeId].op == OP_TYPE_ARRAY || ids[typeId].op == OP_TYPE_RUNTIME_ARRAY) {
+			if (ids[typeId].op == OP_TYPE_ARRAY && ids[ids[typeId].operands[1]].op == OP_CONSTANT)
+				descriptorCount *= ids[ids[typeId].operands[1]].operands[2];
+			typeId = ids[typeId].operands[0];
+		}
+
+		spvId_s const& type = ids[typeId];
+		VkDescriptorType descriptorType;
+		switch (type.op) {
+		case OP_TYPE_STRUCT:
+			descriptorType = storage == STORAGE_STORAGE_BUFFER || type.bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			break;
+		case OP_TYPE_SAMPLED_IMAGE:
+			descriptorType = ids[type.operands[0]].operands[1] == 5 ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			break;
+		case OP_TYPE_IMAGE:
+			// dim, depth, arrayed, ms, sampled after the sampled type
+			if (type.operands[1] == 6)
+				descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else if (type.operands[1] == 5)
+				descriptorType = type.operands[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			else
+				descriptorType = type.operands[5] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			break;
+		case OP_TYPE_SAMPLER:
+			descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			break;
+		case OP_TYPE_ACCELERATION_STRUCTURE:
+			descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			break;
+		default:
+			continue;
+		}
+		reflection.bindings.push_back({ variable.set, variable.binding, descriptorType, descriptorCount, static_cast<VkShaderStageFlags>(reflection.stage) });
+	}
+
+	for (int i = 0; i < specConstants.size(); i++) {
+		spvId_s const& constant = ids[specConstants[i]];
+		if (constant.specId == spvId_s::INVALID)
+			continue;
+		uint32_t value = constant.op == OP_SPEC_CONSTANT_TRUE ? 1 : constant.op == OP_SPEC_CONSTANT && constant.operands.size() > 2 ? constant.operands[2] : 0;
+		uint32_t size = ids[constant.operands[0]].op == OP_TYPE_BOOL ? 4 : getTypeSize(ids, constant.operands[0]);
+		reflection.specConstants.push_back({ constant.specId, size, value });
+	}
+
+	std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](shaderBinding_s const& l, shaderBinding_s const& r) {
+		return l.set != r.set ? l.set < r.set : l.binding < r.binding;
+	});
+	std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](shaderVertexInput_s const& l, shaderVertexInput_s const& r) { return l.location < r.location; });
+	std::sort(reflection.specConstants.begin(), reflection.specConstants.end(), [](shaderSpecConstant_s const& l, shaderSpecConstant_s const& r) { return l.id < r.id; });
+	return reflection;
+}
+
+bool re::ShaderReflection::loadCache(std::string const& path, uint64_t codeHash, ShaderReflection& reflection)
+{
+	std::ifstream file(path, std::ios::binary);
+	cacheHeader_s header;
+
+	if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+	if (header.magic != REFLECTION_MAGIC || header.version != REFLECTION_VERSION || header.codeHash != codeHash)
+		return false;
+
+	reflection.stage = static_cast<VkShaderStageFlagBits>(header.stage);
+	reflection.pushConstantSize = header.pushConstantSize;
+	std::memcpy(reflection.localSize, header.localSize, sizeof(header.localSize));
+	reflection.bindings.resize(header.bindingCount);
+	reflection.vertexInputs.resize(header.vertexInputCount);
+	reflection.specConstants.resize(header.specConstantCount);
+	file.read(reinterpret_cast<char*>(reflection.bindings.data()), reflection.bindings.size() * sizeof(shaderBinding_s));
+	file.read(reinterpret_cast<char*>(reflection.vertexInputs.data()), reflection.vertexInputs.size() * sizeof(shaderVertexInput_s));
+	file.read(reinterpret_cast<char*>(reflection.specConstants.data()), reflection.specConstants.size() * sizeof(shaderSpecConstant_s));
+	return static_cast<bool>(file);
+}
+
+// a cache that cannot be written only costs the reflection on the next start
+void re::ShaderReflection::saveCache(std::string const& path, uint64_t codeHash, ShaderReflection const& reflection)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	cacheHeader_s header{ REFLECTION_MAGIC, REFLECTION_VERSION, codeHash, static_cast<uint32_t>(reflection.stage), reflection.pushConstantSize,
+		{ reflection.localSize[0], reflection.localSize[1], reflection.localSize[2] },
+		static_cast<uint32_t>(reflection.bindings.size()), static_cast<uint32_t>(reflection.vertexInputs.size()), static_cast<uint32_t>(reflection.specConstants.size()) };
+
+	if (!file.is_open())
+		return;
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(reinterpret_cast<char const*>(reflection.bindings.data()), reflection.bindings.size() * sizeof(shaderBinding_s));
+	file.write(reinterpret_cast<char const*>(reflection.vertexInputs.data()), reflection.vertexInputs.size() * sizeof(shaderVertexInput_s));
+	file.write(reinterpret_cast<char const*>(reflection.specConstants.data()), reflection.specConstants.size() * sizeof(shaderSpecConstant_s));
+}
@@ -0,0 +1,329 @@
+#include "ShaderWatcher.hpp"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(RE_SHADER_WATCH_INOTIFY)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+static constexpr auto pollInterval = std::chrono::milliseconds(250);
+// editors save in several writes, changes are gathered this long before compiling
+static constexpr auto settleTime = std::chrono::milliseconds(50);
+
+static bool isSource(std::filesystem::path const& path)
+{
+	std::string extension = path.extension().string();
+	return extension == ".vert" || extension == ".frag" || extension == ".comp" || extension == ".geom"
+		|| extension == ".tesc" || extension == ".tese" || extension == ".task" || extension == ".mesh";
+}
+
+static bool isInclude(std::filesystem::path const& path)
+{
+	return path.extension() == ".glsl";
+}
+
+static bool includes(std::filesystem::path const& path, std::string const& name)
+{
+	std::ifstream file(path);
+	std::string line;
+
+	while (std::getline(file, line))
+		if (line.find("#include") != std::string::npos && line.find("\"" + name + "\"") != std::string::npos)
+			return true;
+	return false;
+}
+
+// a different interface would need a new pipeline layout and descriptor sets
+static bool isSameInterface(re::ShaderReflection const& a, re::ShaderReflection const& b)
+{
+	if (a.pushConstantSize != b.pushConstantSize || a.bindings.size() != b.bindings.size())
+		return false;
+	for (int i = 0; i < a.bindings.size(); i++)
+		if (a.bindings[i].set != b.bindings[i].set || a.bindings[i].binding != b.bindings[i].binding
+			|| a.bindings[i].type != b.bindings[i].type || a.bindings[i].count != b.bindings[i].count)
+			return false;
+	return true;
+}
+
+re::ShaderWatcher::ShaderWatcher(std::string const& directory, std::string const& compiler) : directory(directory), compiler(compiler)
+{
+#if defined(RE_SHADER_WATCH_INOTIFY)
+	notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notify >= 0 && inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		close(notify);
+		notify = -1;
+	}
+	if (notify < 0)
+		std::cerr << TERMINAL_COLOR_YELLOW << "inotify unavailable, polling " << directory << TERMINAL_COLOR_RESET << std::endl;
+#endif
+	thread = std::thread(&re::ShaderWatcher::watchLoop, this);
+}
+
+re::ShaderWatcher::~ShaderWatcher(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	thread.join();
+#if defined(RE_SHADER_WATCH_INOTIFY)
+	if (notify >= 0)
+		close(notify);
+#endif
+}
+
+std::string re::ShaderWatcher::normalize(std::string const& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void re::ShaderWatcher::add(std::string const& path, void const* owner, reloadCallback_t callback)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	watches.push_back(std::make_shared<watch_s>(watch_s{ normalize(path), owner, callback }));
+}
+
+// a build running for the owner finishes on the watcher thread, its swap is dropped
+void re::ShaderWatcher::remove(void const* owner)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (int i = 0; i < watches.size(); i++) {
+		if (watches[i]->owner != owner)
+			continue;
+		watches[i]->active = false;
+		// the watch holds the latest shader and pipeline, the GPU may still use them
+		graveyard.push_back({ frame, watches[i] });
+	}
+	std::erase_if(watches, [owner](std::shared_ptr<watch_s> const& watch) { return watch->owner == owner; });
+	std::erase_if(swaps, [owner](swap_s const& swap) { return swap.watch->owner == owner; });
+}
+
+void re::ShaderWatcher::watch(re::Device& device, std::string const& path, void const* owner, re::shaderModule_ptr& shader, re::computePipeline_ptr& pipeline)
+{
+	// the watcher thread builds from its own copies, the owner's pointers change only in the swap
+	auto latest = std::make_shared<std::pair<re::shaderModule_ptr, re::computePipeline_ptr>>(shader, pipeline);
+
+	add(path, owner, [this, &device, path, latest, &shader, &pipeline]() -> reloadSwap_t {
+		re::shaderModule_ptr reloaded = std::make_shared<re::ShaderModule>(device, path);
+		if (reloaded->hash == latest->first->hash)
+			return nullptr;
+		if (!isSameInterface(reloaded->reflection, latest->first->reflection))
+			throw std::runtime_error("the shader interface changed, restart to apply it");
+
+		re::computePipeline_ptr rebuilt = std::make_shared<re::ComputePipeline>(device, *reloaded, *latest->second);
+		*latest = { reloaded, rebuilt };
+
+		return [this, reloaded, rebuilt, &shader, &pipeline]() {
+			// an owned layout goes to the new pipeline, the retired one may still be in flight and is destroyed first
+			rebuilt->ownsLayout = pipeline->ownsLayout;
+			pipeline->ownsLayout = false;
+			retire(shader);
+			retire(pipeline);
+			shader = reloaded;
+			pipeline = rebuilt;
+		};
+	});
+}
+
+void re::ShaderWatcher::retire(std::shared_ptr<void> resource)
+{
+	graveyard.push_back({ frame, resource });
+}
+
+size_t re::ShaderWatcher::update(void)
+{
+	frame++;
+	while (!graveyard.empty() && graveyard.front().first + FRAMES_IN_FLIGHT <= frame)
+		graveyard.pop_front();
+
+	std::vector<swap_s> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.swap(swaps);
+	}
+
+	for (int i = 0; i < ready.size(); i++)
+		ready[i].apply();
+	if (!ready.empty())
+		std::cout << TERMINAL_COLOR_GREEN << "reloaded " << ready.size() << " pipelines" << TERMINAL_COLOR_RESET << std::endl;
+	return ready.size();
+}
+
+void re::ShaderWatcher::watchLoop(void)
+{
+	std::map<std::string, std::filesystem::file_time_type> times;
+	std::set<std::string> changed;
+
+	scan(times, changed);
+	changed.clear();
+
+	while (true) {
+		bool notified = false;
+
+#if defined(RE_SHADER_WATCH_INOTIFY)
+		if (notify >= 0) {
+			pollfd fd{ notify, POLLIN, 0 };
+			if (::poll(&fd, 1, static_cast<int>(pollInterval.count())) > 0) {
+				alignas(inotify_event) char buffer[4096];
+				ssize_t size;
+
+				while ((size = read(notify, buffer, sizeof(buffer))) > 0) {
+					for (char* p = buffer; p < buffer + size;) {
+						inotify_event const* event = reinterpret_cast<inotify_event const*>(p);
+						if (event->len)
+							changed.insert(event->name);
+						p += sizeof(inotify_event) + event->len;
+					}
+				}
+			}
+			notified = true;
+		}
+#endif
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (!notified)
+				condition.wait_for(lock, pollInterval, [this]() { return !running; });
+			if (!running)
+				return;
+		}
+		if (!notified)
+			scan(times, changed);
+
+		if (changed.empty())
+			continue;
+		std::this_thread::sleep_for(settleTime);
+		process(changed);
+		changed.clear();
+	}
+}
+
+void re::ShaderWatcher::scan(std::map<std::string, std::filesystem::file_time_type>& times, std::set<std::string>& changed)
+{
+	std::error_code error;
+
+	for (auto const& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (!entry.is_regular_file(error))
+			continue;
+		std::string name = entry.path().filename().string();
+		std::filesystem::file_time_type time = entry.last_write_time(error);
+		auto it = times.find(name);
+
+		if (it == times.end() || it->second != time)
+			changed.insert(name);
+		times[name] = time;
+	}
+}
+
+void re::ShaderWatcher::process(std::set<std::string> const& changed)
+{
+	std::set<std::filesystem::path> sources;
+	std::vector<std::string> reloaded;
+
+	for (std::string const& name : changed) {
+		std::filesystem::path path = directory / name;
+
+		// written by the build, the modules compiled here were reloaded already
+		if (path.extension() == ".spv") {
+			std::error_code error;
+			auto it = written.find(name);
+			bool own = it != written.end() && it->second == std::filesystem::last_write_time(path, error);
+			if (it != written.end())
+				written.erase(it);
+			if (!own)
+				reloaded.push_back(normalize(path.string()));
+		}
+		else if (isSource(path))
+			sources.insert(path);
+		else if (isInclude(path))
+			for (std::filesystem::path const& dependent : getDependents(name))
+				sources.insert(dependent);
+	}
+
+	for (std::filesystem::path const& source : sources)
+		if (compile(source))
+			reloaded.push_back(normalize(source.string() + ".spv"));
+
+	for (int i = 0; i < reloaded.size(); i++)
+		reload(reloaded[i]);
+}
+
+// the modules and pipelines are built here, off the frame thread, update only swaps them in
+void re::ShaderWatcher::reload(std::string const& path)
+{
+	std::vector<std::shared_ptr<watch_s>> matches;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int i = 0; i < watches.size(); i++)
+			if (watches[i]->path == path)
+				matches.push_back(watches[i]);
+	}
+
+	for (int i = 0; i < matches.size(); i++) {
+		reloadSwap_t apply;
+		try {
+			apply = matches[i]->callback();
+		}
+		catch (std::exception& e) {
+			std::cerr << TERMINAL_COLOR_RED << "failed to reload " << path << ": " << e.what() << TERMINAL_COLOR_RESET << std::endl;
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (apply && matches[i]->active)
+			swaps.push_back({ matches[i], std::move(apply) });
+	}
+}
+
+bool re::ShaderWatcher::compile(std::filesystem::path const& source)
+{
+	// compiled aside and renamed, a half written module is never loaded
+	std::string output = source.string() + ".spv";
+	std::string temporary = output + ".tmp";
+	std::string command = compiler + " \"" + source.string() + "\" -o \"" + temporary + "\"";
+	std::error_code error;
+
+	if (std::system(command.c_str()) != 0) {
+		std::filesystem::remove(temporary, error);
+		std::cerr << TERMINAL_COLOR_RED << "failed to compile " << source.generic_string() << TERMINAL_COLOR_RESET << std::endl;
+		return false;
+	}
+	std::filesystem::rename(temporary, output, error);
+	if (error) {
+		std::cerr << TERMINAL_COLOR_RED << "failed to replace " << output << ": " << error.message() << TERMINAL_COLOR_RESET << std::endl;
+		return false;
+	}
+	written[std::filesystem::path(output).filename().string()] = std::filesystem::last_write_time(output, error);
+	std::cout << "recompiled " << source.generic_string() << std::endl;
+	return true;
+}
+
+std::vector<std::filesystem::path> re::ShaderWatcher::getDependents(std::string const& name)
+{
+	std::vector<std::filesystem::path> dependents;
+	std::set<std::string> visited{ name };
+	std::vector<std::string> includeQueue{ name };
+	std::error_code error;
+
+	// includes of includes are followed too
+	while (!includeQueue.empty()) {
+		std::string include = includeQueue.back();
+		includeQueue.pop_back();
+
+		for (auto const& entry : std::filesystem::directory_iterator(directory, error)) {
+			std::filesystem::path const& path = entry.path();
+			if ((!isSource(path) && !isInclude(path)) || !includes(path, include))
+				continue;
+			if (isSource(path))
+				dependents.push_back(path);
+			else if (visited.insert(path.filename().string()).second)
+				includeQueue.push_back(path.filename().string());
+		}
+	}
+	return dependents;
+}
@@ -0,0 +1,364 @@
+#include "ShadowAtlas.hpp"
+#include "Culling.hpp"
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+re::ShadowAtlas::ShadowAtlas(re::Device& device, re::RenderingContext& rendering, uint32_t size, uint32_t maxShadows, uint32_t minTileSize, VkFormat format)
+	: device(device), rendering(rendering), size(size), shadows(maxShadows)
+{
+	if (!std::has_single_bit(size) || !std::has_single_bit(minTileSize) || minTileSize > size)
+		throw std::runtime_error("shadow atlas and tile sizes must be powers of two");
+
+	levelCount = std::countr_zero(size / minTileSize) + 1;
+	freeTiles.resize(levelCount);
+	freeTiles[0].insert({ 0, 0 });
+	for (uint32_t i = maxShadows; i > 0; i--)
+		freeShadows.push_back(i - 1);
+
+	atlas = std::make_shared<re::Image>(device, VkExtent2D{ size, size }, format,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 1, VK_IMAGE_ASPECT_DEPTH_BIT);
+	cache = std::make_shared<re::Image>(device, VkExtent2D{ size, size }, format,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 1, VK_IMAGE_ASPECT_DEPTH_BIT);
+	shadowBuffer = std::make_shared<re::Buffer>(device, sizeof(gpuShadow_s) * maxShadows, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings = {
+		{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr }
+	};
+	setLayout = std::make_shared<re::DescriptorSetLayout>(device, bindings);
+	pool = std::make_shared<re::DescriptorPool>(device, 1, std::vector<VkDescriptorPoolSize>{
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }
+	});
+	set = pool->allocate(*setLayout);
+
+	re::writeDescriptor(device, set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VkDescriptorImageInfo{ sampler, atlas->view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+	re::writeDescriptor(device, set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, *shadowBuffer);
+}
+
+re::ShadowAtlas::~ShadowAtlas(void)
+{
+	rendering.releaseViews({ atlas->view, cache->view });
+	vkDestroySampler(device.ptr, sampler, nullptr);
+}
+
+bool re::ShadowAtlas::allocateTile(uint32_t level, glm::uvec2& offset)
+{
+	if (!freeTiles[level].empty()) {
+		auto tile = *freeTiles[level].begin();
+		freeTiles[level].erase(freeTiles[level].begin());
+		offset = { tile.first, tile.second };
+		return true;
+	}
+
+	// split a tile of the level above in four
+	glm::uvec2 parent;
+	if (level == 0 || !allocateTile(level - 1, parent))
+		return false;
+
+	uint32_t tileSize = size >> level;
+	freeTiles[level].insert({ parent.x + tileSize, parent.y });
+	freeTiles[level].insert({ parent.x, parent.y + tileSize });
+	freeTiles[level].insert({ parent.x + tileSize, parent.y + tileSize });
+	offset = parent;
+	return true;
+}
+
+// merges back with its three buddies when they are all free
+void re::ShadowAtlas::freeTile(uint32_t level, glm::uvec2 offset)
+{
+	if (level > 0) {
+		uint32_t tileSize = size >> level;
+		glm::uvec2 parent = offset - offset % (tileSize * 2);
+		std::pair<uint32_t, uint32_t> buddies[4] = {
+			{ parent.x, parent.y }, { parent.x + tileSize, parent.y },
+			{ parent.x, parent.y + tileSize }, { parent.x + tileSize, parent.y + tileSize }
+		};
+
+		int freeBuddies = 0;
+		for (int i = 0; i < 4; i++)
+			if (buddies[i] != std::make_pair(offset.x, offset.y) && freeTiles[level].count(buddies[i]))
+				freeBuddies++;
+
+		if (freeBuddies == 3) {
+			for (int i = 0; i < 4; i++)
+				freeTiles[level].erase(buddies[i]);
+			freeTile(level - 1, parent);
+			return;
+		}
+	}
+	freeTiles[level].insert({ offset.x, offset.y });
+}
+
+uint32_t re::ShadowAtlas::add(uint32_t resolution)
+{
+	if (freeShadows.empty())
+		throw std::runtime_error("too many shadows for the shadow atlas");
+
+	resolution = std::clamp(std::bit_ceil(resolution), size >> (levelCount - 1), size);
+	uint32_t level = std::countr_zero(size / resolution);
+	glm::uvec2 offset;
+
+	while (level < levelCount && !allocateTile(level, offset))
+		level++;
+	if (level == levelCount)
+		throw std::runtime_error("shadow atlas is full");
+
+	uint32_t id = freeShadows.back();
+	freeShadows.pop_back();
+	shadows[id] = {};
+	shadows[id].used = true;
+	shadows[id].level = level;
+	shadows[id].offset = offset;
+	return id;
+}
+
+void re::ShadowAtlas::remove(uint32_t shadow)
+{
+	if (shadow >= shadows.size() || !shadows[shadow].used)
+		throw std::runtime_error("invalid shadow");
+
+	freeTile(shadows[shadow].level, shadows[shadow].offset);
+	shadows[shadow].used = false;
+	freeShadows.push_back(shadow);
+}
+
+// a host write would race the frames in flight still reading the buffer, the update is ordered with them instead
+void re::ShadowAtlas::upload(VkCommandBuffer cmd)
+{
+	std::vector<uint32_t> pending;
+	for (uint32_t i = 0; i < shadows.size(); i++)
+		if (shadows[i].used && shadows[i].uploadPending)
+			pending.push_back(i);
+	if (pending.empty())
+		return;
+
+	VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	for (int i = 0; i < pending.size(); i++) {
+		shadow_s& data = shadows[pending[i]];
+		gpuShadow_s gpuShadow;
+
+		gpuShadow.viewProjection = data.viewProjection;
+		gpuShadow.rect = glm::vec4(glm::vec2(data.offset), glm::vec2(static_cast<float>(size >> data.level))) / static_cast<float>(size);
+		vkCmdUpdateBuffer(cmd, shadowBuffer->ptr, sizeof(gpuShadow_s) * pending[i], sizeof(gpuShadow), &gpuShadow);
+		data.uploadPending = false;
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void re::ShadowAtlas::setView(uint32_t shadow, glm::mat4 const& viewProjection)
+{
+	if (shadows[shadow].viewProjection == viewProjection)
+		return;
+	shadows[shadow].viewProjection = viewProjection;
+	shadows[shadow].staticDirty = true;
+	shadows[shadow].uploadPending = true;
+}
+
+void re::ShadowAtlas::setDynamicCasters(uint32_t shadow, bool any)
+{
+	shadows[shadow].dynamicCasters = any;
+}
+
+void re::ShadowAtlas::invalidate(uint32_t shadow)
+{
+	shadows[shadow].staticDirty = true;
+}
+
+void re::ShadowAtlas::invalidateStatic(glm::vec3 const& min, glm::vec3 const& max)
+{
+	re::AabbArray box;
+	box.push_back(min, max);
+
+	for (int i = 0; i < shadows.size(); i++) {
+		uint32_t visible;
+		if (shadows[i].used && re::cullAabbs(re::Frustum::fromMatrix(shadows[i].viewProjection), box, 0, 1, &visible))
+			shadows[i].staticDirty = true;
+	}
+}
+
+void re::ShadowAtlas::invalidateStatic(void)
+{
+	for (int i = 0; i < shadows.size(); i++)
+		shadows[i].staticDirty = true;
+}
+
+re::renderingInfo_s re::ShadowAtlas::getRenderingInfo(void) const
+{
+	re::renderingInfo_s info;
+
+	info.extent = atlas->extent;
+	info.depth.view = atlas->view;
+	info.depth.format = atlas->format;
+	info.depth.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	info.depth.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	return info;
+}
+
+// loads the atlas, a static render clears its tile only
+void re::ShadowAtlas::render(VkCommandBuffer cmd, re::Image& target, std::vector<uint32_t> const& list, shadowDraw_t const& draw, bool clear)
+{
+	re::renderingInfo_s info = getRenderingInfo();
+	info.depth.view = target.view;
+	rendering.begin(cmd, info);
+
+	for (int i = 0; i < list.size(); i++) {
+		shadow_s const& shadow = shadows[list[i]];
+		uint32_t tileSize = size >> shadow.level;
+		VkRect2D rect{ { static_cast<int32_t>(shadow.offset.x), static_cast<int32_t>(shadow.offset.y) }, { tileSize, tileSize } };
+		VkViewport viewport{ static_cast<float>(shadow.offset.x), static_cast<float>(shadow.offset.y),
+			static_cast<float>(tileSize), static_cast<float>(tileSize), 0.0f, 1.0f };
+
+		vkCmdSetViewport(cmd, 0, 1, &viewport);
+		vkCmdSetScissor(cmd, 0, 1, &rect);
+		if (clear) {
+			VkClearAttachment attachment{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, {} };
+			VkClearRect clearRect{ rect, 0, 1 };
+			attachment.clearValue.depthStencil = { 1.0f, 0 };
+			vkCmdClearAttachments(cmd, 1, &attachment, 1, &clearRect);
+		}
+		draw(cmd, list[i], shadow.viewProjection);
+	}
+	rendering.end(cmd);
+}
+
+void re::ShadowAtlas::record(VkCommandBuffer cmd, shadowDraw_t const& drawStatic, shadowDraw_t const& drawDynamic)
+{
+	std::vector<uint32_t> dirty, composited, dynamic;
+
+	upload(cmd);
+	for (uint32_t i = 0; i < shadows.size(); i++) {
+		if (!shadows[i].used)
+			continue;
+		if (shadows[i].staticDirty)
+			dirty.push_back(i);
+		if (shadows[i].staticDirty || shadows[i].dynamicDrawn || shadows[i].dynamicCasters)
+			composited.push_back(i);
+		if (shadows[i].dynamicCasters)
+			dynamic.push_back(i);
+	}
+	staticRenders = dirty.size();
+	dynamicRenders = dynamic.size();
+
+	// the cache rests in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, the first pass renders every shadow so its old content can be dropped
+	if (!dirty.empty()) {
+		cache->barrier(cmd, cacheInitialized ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+		render(cmd, *cache, dirty, drawStatic, true);
+		cache->barrier(cmd, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+		cacheInitialized = true;
+		for (int i = 0; i < dirty.size(); i++)
+			shadows[dirty[i]].staticDirty = false;
+	}
+
+	if (composited.empty())
+		return;
+
+	atlas->barrier(cmd, atlasInitialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	atlasInitialized = true;
+
+	std::vector<VkImageCopy> regions(composited.size());
+	for (int i = 0; i < composited.size(); i++) {
+		shadow_s const& shadow = shadows[composited[i]];
+		VkOffset3D offset{ static_cast<int32_t>(shadow.offset.x), static_cast<int32_t>(shadow.offset.y), 0 };
+		regions[i] = { { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 }, offset, { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 }, offset, { size >> shadow.level, size >> shadow.level, 1 } };
+	}
+	vkCmdCopyImage(cmd, cache->ptr, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, atlas->ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data());
+
+	if (!dynamic.empty()) {
+		atlas->barrier(cmd, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+		render(cmd, *atlas, dynamic, drawDynamic, false);
+		atlas->barrier(cmd, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+	else
+		atlas->barrier(cmd, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	for (int i = 0; i < composited.size(); i++)
+		shadows[composited[i]].dynamicDrawn = shadows[composited[i]].dynamicCasters;
+}
+
+std::vector<float> re::ShadowAtlas::cascadeSplits(float znear, float zfar, uint32_t count, float lambda)
+{
+	std::vector<float> splits(count + 1);
+
+	for (uint32_t i = 0; i <= count; i++) {
+		float t = static_cast<float>(i) / count;
+		splits[i] = lambda * znear * std::pow(zfar / znear, t) + (1.0f - lambda) * (znear + (zfar - znear) * t);
+	}
+	return splits;
+}
+
+glm::mat4 re::ShadowAtlas::stableCascade(glm::mat4 const& view, float fovY, float aspect, float splitNear, float splitFar,
+	glm::vec3 const& lightDirection, uint32_t resolution, float casterDistance)
+{
+	glm::mat4 inverseView = glm::inverse(view);
+	float tanY = std::tan(fovY * 0.5f);
+	float tanX = tanY * aspect;
+	glm::vec3 corners[8];
+	glm::vec3 center(0.0f);
+
+	for (int i = 0; i < 8; i++) {
+		float depth = i < 4 ? splitNear : splitFar;
+		glm::vec4 corner((i & 1 ? tanX : -tanX) * depth, (i & 2 ? tanY : -tanY) * depth, -depth, 1.0f);
+		corners[i] = glm::vec3(inverseView * corner);
+		center += corners[i] / 8.0f;
+	}
+
+	// the sphere around the slice does not change with the camera's rotation, rounding keeps float noise out of its size
+	float radius = 0.0f;
+	for (int i = 0; i < 8; i++)
+		radius = std::max(radius, glm::length(corners[i] - center));
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAtRH(glm::vec3(0.0f), lightDirection, up);
+	glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+
+	// whole texels in light space, the depth too so an unmoved cascade keeps the exact same matrix and its cache
+	float texel = 2.0f * radius / resolution;
+	lightCenter = glm::floor(lightCenter / texel) * texel;
+
+	// the light looks down -z, casters up to casterDistance before the slice still land in the map
+	return glm::orthoRH_ZO(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius,
+		-lightCenter.z - radius - casterDistance, -lightCenter.z + radius) * lightView;
+}
@@ -0,0 +1,103 @@
+#include "Texture.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <algorithm>
+
+re::TextureData re::loadTga(std::string const& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file: " + path);
+
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (bytes.size() < 18)
+		throw std::runtime_error("invalid tga file: " + path);
+
+	uint8_t idLength = bytes[0];
+	uint8_t colorMapType = bytes[1];
+	uint8_t imageType = bytes[2];
+	uint32_t width = bytes[12] | bytes[13] << 8;
+	uint32_t height = bytes[14] | bytes[15] << 8;
+	uint32_t channels = bytes[16] / 8;
+	bool topDown = bytes[17] & 0x20;
+
+	if (colorMapType || (imageType != 2 && imageType != 10) || (channels != 3 && channels != 4) || !width || !height)
+		throw std::runtime_error("unsupported tga file: " + path);
+
+	TextureData texture;
+	texture.width = width;
+	texture.height = height;
+	texture.mips.emplace_back(width * height * 4);
+
+	std::vector<uint8_t>& pixels = texture.mips[0];
+	size_t cursor = 18 + idLength;
+	size_t pixelCount = static_cast<size_t>(width) * height;
+
+	auto read = [&](size_t count) {
+		if (cursor + count > bytes.size())
+			throw std::runtime_error("truncated tga file: " + path);
+		uint8_t const* p = &bytes[cursor];
+		cursor += count;
+		return p;
+	};
+	auto store = [&](size_t i, uint8_t const* bgra) {
+		size_t y = i / width;
+		size_t row = topDown ? y : height - 1 - y;
+		uint8_t* out = &pixels[(row * width + i % width) * 4];
+		out[0] = bgra[2];
+		out[1] = bgra[1];
+		out[2] = bgra[0];
+		out[3] = channels == 4 ? bgra[3] : 255;
+	};
+
+	for (size_t i = 0; i < pixelCount;) {
+		if (imageType == 2) {
+			store(i++, read(channels));
+			continue;
+		}
+		uint8_t header = *read(1);
+		size_t count = (header & 0x7f) + 1;
+		if (i + count > pixelCount)
+			throw std::runtime_error("invalid tga file: " + path);
+		if (header & 0x80) {
+			uint8_t const* pixel = read(channels);
+			for (size_t k = 0; k < count; k++)
+				store(i++, pixel);
+		}
+		else
+			for (size_t k = 0; k < count; k++)
+				store(i++, read(channels));
+	}
+	return texture;
+}
+
+void re::generateMips(re::TextureData& texture)
+{
+	if (texture.format != VK_FORMAT_R8G8B8A8_UNORM && texture.format != VK_FORMAT_R8G8B8A8_SRGB)
+		throw std::runtime_error("mip generation needs an RGBA8 texture");
+
+	texture.mips.resize(1);
+	for (uint32_t level = 1; getMipSize(texture.width, level - 1) > 1 || getMipSize(texture.height, level - 1) > 1; level++) {
+		uint32_t srcWidth = getMipSize(texture.width, level - 1);
+		uint32_t srcHeight = getMipSize(texture.height, level - 1);
+		uint32_t width = getMipSize(texture.width, level);
+		uint32_t height = getMipSize(texture.height, level);
+		std::vector<uint8_t> mip(width * height * 4);
+		std::vector<uint8_t> const& src = texture.mips[level - 1];
+
+		for (uint32_t y = 0; y < height; y++) {
+			for (uint32_t x = 0; x < width; x++) {
+				uint32_t x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+				uint32_t y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+				for (int c = 0; c < 4; c++) {
+					uint32_t sum = src[(y0 * srcWidth + x0) * 4 + c] + src[(y0 * srcWidth + x1) * 4 + c]
+						+ src[(y1 * srcWidth + x0) * 4 + c] + src[(y1 * srcWidth + x1) * 4 + c];
+					mip[(y * width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		texture.mips.push_back(std::move(mip));
+	}
+}
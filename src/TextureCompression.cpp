@@ -0,0 +1,553 @@
+#include "TextureCompression.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace {
+
+	constexpr uint8_t bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint16_t packRgb565(glm::vec3 c)
+	{
+		int r = static_cast<int>(std::round(glm::clamp(c.r, 0.0f, 255.0f) * 31.0f / 255.0f));
+		int g = static_cast<int>(std::round(glm::clamp(c.g, 0.0f, 255.0f) * 63.0f / 255.0f));
+		int b = static_cast<int>(std::round(glm::clamp(c.b, 0.0f, 255.0f) * 31.0f / 255.0f));
+		return static_cast<uint16_t>(r << 11 | g << 5 | b);
+	}
+
+	glm::ivec3 unpackRgb565(uint16_t c)
+	{
+		int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+		return glm::ivec3(r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2);
+	}
+
+	// principal axis of the covariance by power iteration, falls back to the luminance axis
+	template<int N>
+	glm::vec<N, float> principalAxis(glm::vec<N, float> const* points, int count, glm::vec<N, float> const& mean)
+	{
+		glm::mat<N, N, float> covariance(0.0f);
+
+		for (int i = 0; i < count; i++) {
+			glm::vec<N, float> d = points[i] - mean;
+			for (int r = 0; r < N; r++)
+				for (int c = 0; c < N; c++)
+					covariance[c][r] += d[r] * d[c];
+		}
+
+		glm::vec<N, float> axis(1.0f);
+		for (int i = 0; i < 8; i++) {
+			glm::vec<N, float> next = covariance * axis;
+			float length = glm::length(next);
+			if (length < 1e-6f)
+				return glm::vec<N, float>(1.0f) / std::sqrt(static_cast<float>(N));
+			axis = next / length;
+		}
+		return axis;
+	}
+
+	struct bitWriter_s {
+		uint8_t* data;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t bits)
+		{
+			for (uint32_t i = 0; i < bits; i++, position++)
+				data[position >> 3] |= ((value >> i) & 1) << (position & 7);
+		}
+	};
+
+	struct bitReader_s {
+		uint8_t const* data;
+		uint32_t position = 0;
+
+		uint32_t read(uint32_t bits)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bits; i++, position++)
+				value |= ((data[position >> 3] >> (position & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	void buildBC4Palette(int a0, int a1, int palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+		else {
+			for (int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// 7 bit endpoint and p-bit pair closest to an 8 bit value for every channel
+	void quantizeBC7Endpoint(glm::vec4 const& value, glm::ivec4& quantized, int& pbit)
+	{
+		float bestError = INFINITY;
+
+		for (int p = 0; p < 2; p++) {
+			glm::ivec4 q;
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				q[c] = glm::clamp(static_cast<int>(std::round((value[c] - p) / 2.0f)), 0, 127);
+				float d = static_cast<float>(q[c] << 1 | p) - value[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				quantized = q;
+				pbit = p;
+			}
+		}
+	}
+}
+
+void re::encodeBC1(uint8_t const pixels[64], uint8_t block[8])
+{
+	glm::vec3 points[16];
+	glm::vec3 mean(0.0f);
+
+	for (int i = 0; i < 16; i++) {
+		points[i] = glm::vec3(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2]);
+		mean += points[i] / 16.0f;
+	}
+
+	glm::vec3 axis = principalAxis<3>(points, 16, mean);
+	float minT = INFINITY, maxT = -INFINITY;
+	for (int i = 0; i < 16; i++) {
+		float t = glm::dot(points[i] - mean, axis);
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	uint16_t c0 = packRgb565(mean + axis * maxT);
+	uint16_t c1 = packRgb565(mean + axis * minT);
+	std::memset(block, 0, 8);
+
+	// c0 > c1 selects the 4 color mode, which is also the only mode inside BC3
+	if (c0 < c1)
+		std::swap(c0, c1);
+	block[0] = c0 & 0xff;
+	block[1] = c0 >> 8;
+	block[2] = c1 & 0xff;
+	block[3] = c1 >> 8;
+	if (c0 == c1)
+		return;
+
+	glm::ivec3 e0 = unpackRgb565(c0), e1 = unpackRgb565(c1);
+	glm::ivec3 palette[4] = { e0, e1, (2 * e0 + e1) / 3, (e0 + 2 * e1) / 3 };
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0, bestError = INT32_MAX;
+		for (int j = 0; j < 4; j++) {
+			glm::ivec3 d = glm::ivec3(points[i]) - palette[j];
+			int error = d.x * d.x + d.y * d.y + d.z * d.z;
+			if (error < bestError) {
+				bestError = error;
+				best = j;
+			}
+		}
+		indices |= best << (i * 2);
+	}
+	std::memcpy(block + 4, &indices, 4);
+}
+
+void re::encodeBC4(uint8_t const pixels[64], uint8_t block[8], int channel)
+{
+	int a0 = 0, a1 = 255;
+
+	for (int i = 0; i < 16; i++) {
+		a0 = std::max<int>(a0, pixels[i * 4 + channel]);
+		a1 = std::min<int>(a1, pixels[i * 4 + channel]);
+	}
+
+	std::memset(block, 0, 8);
+	block[0] = static_cast<uint8_t>(a0);
+	block[1] = static_cast<uint8_t>(a1);
+	if (a0 == a1)
+		return;
+
+	int palette[8];
+	buildBC4Palette(a0, a1, palette);
+	bitWriter_s writer{ block + 2 };
+	for (int i = 0; i < 16; i++) {
+		int value = pixels[i * 4 + channel], best = 0;
+		for (int j = 1; j < 8; j++)
+			if (std::abs(palette[j] - value) < std::abs(palette[best] - value))
+				best = j;
+		writer.write(best, 3);
+	}
+}
+
+void re::encodeBC3(uint8_t const pixels[64], uint8_t block[16])
+{
+	encodeBC4(pixels, block, 3);
+	encodeBC1(pixels, block + 8);
+}
+
+void re::encodeBC5(uint8_t const pixels[64], uint8_t block[16])
+{
+	encodeBC4(pixels, block, 0);
+	encodeBC4(pixels, block + 8, 1);
+}
+
+// endpoints from the principal axis, refined once by least squares on the chosen weights
+void re::encodeBC7(uint8_t const pixels[64], uint8_t block[16])
+{
+	glm::vec4 points[16];
+	glm::vec4 mean(0.0f);
+
+	for (int i = 0; i < 16; i++) {
+		points[i] = glm::vec4(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], pixels[i * 4 + 3]);
+		mean += points[i] / 16.0f;
+	}
+
+	glm::vec4 axis = principalAxis<4>(points, 16, mean);
+	float minT = INFINITY, maxT = -INFINITY;
+	for (int i = 0; i < 16; i++) {
+		float t = glm::dot(points[i] - mean, axis);
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	glm::vec4 endpoints[2] = { glm::clamp(mean + axis * minT, 0.0f, 255.0f), glm::clamp(mean + axis * maxT, 0.0f, 255.0f) };
+
+	glm::ivec4 q[2];
+	int p[2];
+	int indices[16];
+
+	for (int pass = 0; pass < 2; pass++) {
+		quantizeBC7Endpoint(endpoints[0], q[0], p[0]);
+		quantizeBC7Endpoint(endpoints[1], q[1], p[1]);
+		glm::ivec4 e0 = q[0] << 1 | p[0], e1 = q[1] << 1 | p[1];
+
+		for (int i = 0; i < 16; i++) {
+			int bestError = INT32_MAX;
+			for (int j = 0; j < 16; j++) {
+				glm::ivec4 d = glm::ivec4(points[i]) - ((64 - int(bc7Weights4[j])) * e0 + int(bc7Weights4[j]) * e1 + 32) / 64;
+				int error = d.x * d.x + d.y * d.y + d.z * d.z + d.w * d.w;
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = j;
+				}
+			}
+		}
+		if (pass)
+			break;
+
+		// minimise sum |(1 - w) e0 + w e1 - x|^2 over both endpoints
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		glm::vec4 x0(0.0f), x1(0.0f);
+		for (int i = 0; i < 16; i++) {
+			float w = bc7Weights4[indices[i]] / 64.0f;
+			a += (1.0f - w) * (1.0f - w);
+			b += (1.0f - w) * w;
+			c += w * w;
+			x0 += (1.0f - w) * points[i];
+			x1 += w * points[i];
+		}
+		float determinant = a * c - b * b;
+		if (std::abs(determinant) < 1e-6f)
+			continue;
+		endpoints[0] = glm::clamp((c * x0 - b * x1) / determinant, 0.0f, 255.0f);
+		endpoints[1] = glm::clamp((a * x1 - b * x0) / determinant, 0.0f, 255.0f);
+	}
+
+	// the anchor index is stored with 3 bits, its top bit must be 0
+	if (indices[0] >= 8) {
+		std::swap(q[0], q[1]);
+		std::swap(p[0], p[1]);
+		for (int i = 0; i < 16; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	std::memset(block, 0, 16);
+	bitWriter_s writer{ block };
+	writer.write(1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		writer.write(q[0][c], 7);
+		writer.write(q[1][c], 7);
+	}
+	writer.write(p[0], 1);
+	writer.write(p[1], 1);
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; i++)
+		writer.write(indices[i], 4);
+}
+
+void re::decodeBC1(uint8_t const block[8], uint8_t pixels[64])
+{
+	uint16_t c0 = block[0] | block[1] << 8;
+	uint16_t c1 = block[2] | block[3] << 8;
+	glm::ivec3 e0 = unpackRgb565(c0), e1 = unpackRgb565(c1);
+	glm::ivec4 palette[4] = { glm::ivec4(e0, 255), glm::ivec4(e1, 255) };
+	uint32_t indices;
+
+	if (c0 > c1) {
+		palette[2] = glm::ivec4((2 * e0 + e1) / 3, 255);
+		palette[3] = glm::ivec4((e0 + 2 * e1) / 3, 255);
+	}
+	else {
+		palette[2] = glm::ivec4((e0 + e1) / 2, 255);
+		palette[3] = glm::ivec4(0);
+	}
+
+	std::memcpy(&indices, block + 4, 4);
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			pixels[i * 4 + c] = static_cast<uint8_t>(palette[indices >> (i * 2) & 3][c]);
+}
+
+void re::decodeBC4(uint8_t const block[8], uint8_t pixels[64], int channel)
+{
+	int palette[8];
+	bitReader_s reader{ block + 2 };
+
+	buildBC4Palette(block[0], block[1], palette);
+	for (int i = 0; i < 16; i++)
+		pixels[i * 4 + channel] = static_cast<uint8_t>(palette[reader.read(3)]);
+}
+
+void re::decodeBC3(uint8_t const block[16], uint8_t pixels[64])
+{
+	uint16_t c0 = block[8] | block[9] << 8;
+	uint16_t c1 = block[10] | block[11] << 8;
+	glm::ivec3 e0 = unpackRgb565(c0), e1 = unpackRgb565(c1);
+	glm::ivec3 palette[4] = { e0, e1, (2 * e0 + e1) / 3, (e0 + 2 * e1) / 3 };
+	uint32_t indices;
+
+	std::memcpy(&indices, block + 12, 4);
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+			pixels[i * 4 + c] = static_cast<uint8_t>(palette[indices >> (i * 2) & 3][c]);
+	decodeBC4(block, pixels, 3);
+}
+
+void re::decodeBC5(uint8_t const block[16], uint8_t pixels[64])
+{
+	decodeBC4(block, pixels, 0);
+	decodeBC4(block + 8, pixels, 1);
+	for (int i = 0; i < 16; i++) {
+		pixels[i * 4 + 2] = 0;
+		pixels[i * 4 + 3] = 255;
+	}
+}
+
+void re::decodeBC7(uint8_t const block[16], uint8_t pixels[64])
+{
+	bitReader_s reader{ block };
+
+	if (reader.read(7) != 1 << 6) {
+		for (int i = 0; i < 16; i++) {
+			pixels[i * 4] = pixels[i * 4 + 2] = pixels[i * 4 + 3] = 255;
+			pixels[i * 4 + 1] = 0;
+		}
+		return;
+	}
+
+	glm::ivec4 e[2];
+	for (int c = 0; c < 4; c++) {
+		e[0][c] = reader.read(7);
+		e[1][c] = reader.read(7);
+	}
+	e[0] = e[0] << 1 | static_cast<int>(reader.read(1));
+	e[1] = e[1] << 1 | static_cast<int>(reader.read(1));
+
+	for (int i = 0; i < 16; i++) {
+		int w = bc7Weights4[reader.read(i ? 4 : 3)];
+		glm::ivec4 value = ((64 - w) * e[0] + w * e[1] + 32) >> 6;
+		for (int c = 0; c < 4; c++)
+			pixels[i * 4 + c] = static_cast<uint8_t>(value[c]);
+	}
+}
+
+bool re::isBlockCompressed(VkFormat format)
+{
+	return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+uint32_t re::getBlockBytes(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+		return 8;
+	case VK_FORMAT_BC2_UNORM_BLOCK:
+	case VK_FORMAT_BC2_SRGB_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC5_SNORM_BLOCK:
+	case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+	case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+re::textureClass_e re::classifyTexture(re::TextureData const& texture, bool normalMap)
+{
+	bool alpha = false, gray = true;
+	std::vector<uint8_t> const& pixels = texture.mips[0];
+
+	if (normalMap)
+		return TEXTURE_CLASS_NORMAL;
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		alpha |= pixels[i + 3] != 255;
+		gray &= pixels[i] == pixels[i + 1] && pixels[i] == pixels[i + 2];
+	}
+	if (alpha)
+		return TEXTURE_CLASS_COLOR_ALPHA;
+	return gray ? TEXTURE_CLASS_GRAYSCALE : TEXTURE_CLASS_COLOR;
+}
+
+VkFormat re::getCompressedFormat(textureClass_e textureClass, bool srgb, bool preferBC7)
+{
+	switch (textureClass) {
+	case TEXTURE_CLASS_COLOR:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case TEXTURE_CLASS_COLOR_ALPHA:
+		if (preferBC7)
+			return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+		return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	// bc4 samples as (r, 0, 0, 1) and has no srgb variant, grayscale colour stays bc1
+	case TEXTURE_CLASS_GRAYSCALE:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC4_UNORM_BLOCK;
+	case TEXTURE_CLASS_NORMAL:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+// edge blocks repeat the last row and column
+re::TextureData re::compressTexture(re::TextureData const& texture, VkFormat format)
+{
+	TextureData result;
+	void (*encode)(uint8_t const*, uint8_t*) = nullptr;
+
+	switch (format) {
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK: encode = encodeBC1; break;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK: encode = encodeBC3; break;
+	case VK_FORMAT_BC4_UNORM_BLOCK: encode = [](uint8_t const* p, uint8_t* b) { encodeBC4(p, b, 0); }; break;
+	case VK_FORMAT_BC5_UNORM_BLOCK: encode = encodeBC5; break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK: encode = encodeBC7; break;
+	default: throw std::runtime_error("unsupported texture compression format");
+	}
+	if (texture.format != VK_FORMAT_R8G8B8A8_UNORM && texture.format != VK_FORMAT_R8G8B8A8_SRGB)
+		throw std::runtime_error("texture compression needs an RGBA8 texture");
+
+	result.width = texture.width;
+	result.height = texture.height;
+	result.format = format;
+
+	for (uint32_t level = 0; level < texture.mips.size(); level++) {
+		uint32_t width = getMipSize(texture.width, level), height = getMipSize(texture.height, level);
+		uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		uint32_t blockBytes = getBlockBytes(format);
+		std::vector<uint8_t> const& src = texture.mips[level];
+		std::vector<uint8_t> mip(blocksX * blocksY * blockBytes);
+		uint8_t pixels[64];
+
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				for (uint32_t i = 0; i < 16; i++) {
+					uint32_t x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+					std::memcpy(pixels + i * 4, &src[(y * width + x) * 4], 4);
+				}
+				encode(pixels, &mip[(by * blocksX + bx) * blockBytes]);
+			}
+		}
+		result.mips.push_back(std::move(mip));
+	}
+	return result;
+}
+
+re::TextureData re::decompressTexture(re::TextureData const& texture)
+{
+	TextureData result;
+	void (*decode)(uint8_t const*, uint8_t*) = nullptr;
+	bool srgb = false;
+
+	switch (texture.format) {
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: decode = decodeBC1; break;
+	case VK_FORMAT_BC3_SRGB_BLOCK: srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC3_UNORM_BLOCK: decode = decodeBC3; break;
+	case VK_FORMAT_BC4_UNORM_BLOCK: decode = [](uint8_t const* b, uint8_t* p) {
+		decodeBC4(b, p, 0);
+		for (int i = 0; i < 16; i++) {
+			p[i * 4 + 1] = p[i * 4 + 2] = p[i * 4];
+			p[i * 4 + 3] = 255;
+		}
+	}; break;
+	case VK_FORMAT_BC5_UNORM_BLOCK: decode = decodeBC5; break;
+	case VK_FORMAT_BC7_SRGB_BLOCK: srgb = true; [[fallthrough]];
+	case VK_FORMAT_BC7_UNORM_BLOCK: decode = decodeBC7; break;
+	default: throw std::runtime_error("unsupported texture compression format");
+	}
+
+	result.width = texture.width;
+	result.height = texture.height;
+	result.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+	for (uint32_t level = 0; level < texture.mips.size(); level++) {
+		uint32_t width = getMipSize(texture.width, level), height = getMipSize(texture.height, level);
+		uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		uint32_t blockBytes = getBlockBytes(texture.format);
+		std::vector<uint8_t> mip(width * height * 4);
+		uint8_t pixels[64];
+
+		if (texture.mips[level].size() < blocksX * blocksY * blockBytes)
+			throw std::runtime_error("truncated compressed texture");
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				decode(&texture.mips[level][(by * blocksX + bx) * blockBytes], pixels);
+				for (uint32_t i = 0; i < 16; i++) {
+					uint32_t x = bx * 4 + i % 4, y = by * 4 + i / 4;
+					if (x < width && y < height)
+						std::memcpy(&mip[(y * width + x) * 4], pixels + i * 4, 4);
+				}
+			}
+		}
+		result.mips.push_back(std::move(mip));
+	}
+	return result;
+}
+
+VkFormat re::selectTextureFormat(re::PhysicalDevice& physicalDevice, VkFormat stored)
+{
+	VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	bool srgb = stored == VK_FORMAT_BC1_RGB_SRGB_BLOCK || stored == VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+		|| stored == VK_FORMAT_BC3_SRGB_BLOCK || stored == VK_FORMAT_BC7_SRGB_BLOCK || stored == VK_FORMAT_R8G8B8A8_SRGB;
+
+	if (physicalDevice.supportsImageFormat(stored, features))
+		return stored;
+	return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+void re::transcodeTexture(re::PhysicalDevice& physicalDevice, uint8_t const* blob, size_t size, std::vector<uint8_t>& output)
+{
+	textureView_s view = parseTexture(blob, size);
+
+	if (!isBlockCompressed(view.header->format) || selectTextureFormat(physicalDevice, view.header->format) == view.header->format)
+		return;
+	output = serializeTexture(decompressTexture(loadTexture(view)));
+}
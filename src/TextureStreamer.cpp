@@ -0,0 +1,298 @@
+#include "TextureStreamer.hpp"
+#include "TextureCompression.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+static constexpr size_t maxInflightLoads = 16;
+// levels up to this size are loaded together when a texture is added and never evicted
+static constexpr uint32_t tailSize = 64;
+static constexpr VkDeviceSize stagingAlignment = 16;
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+re::TextureStreamer::TextureStreamer(re::Device& device, re::Package& package, VkDeviceSize budget, uint32_t maxTextures)
+	: device(device), package(package), budget(budget), maxTextures(maxTextures)
+{
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+
+	for (uint64_t i = 0; i < FRAMES_IN_FLIGHT; i++) {
+		feedback.push_back(std::make_shared<re::Buffer>(device, maxTextures * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		std::memset(feedback[i]->mapped, 0xff, maxTextures * sizeof(uint32_t));
+	}
+	packageFile = reader.open(package.getPath());
+}
+
+re::TextureStreamer::~TextureStreamer(void)
+{
+	while (reader.getPendingCount())
+		reader.poll();
+	vkDestroySampler(device.ptr, sampler, nullptr);
+}
+
+re::textureHandle_t re::TextureStreamer::add(std::string_view name)
+{
+	packageEntry_s const* entry = package.find(name);
+
+	if (!entry)
+		throw std::runtime_error("unknown texture: " + std::string(name));
+
+	auto it = lookup.find(entry);
+	if (it != lookup.end())
+		return it->second;
+	if (textures.size() >= maxTextures)
+		throw std::runtime_error("too many streamed textures");
+
+	// everything that can throw runs before the texture is added
+	texture_s texture{};
+	texture.entry = entry;
+	texture.view = package.getTexture(*entry);
+	if (!texture.view.header->mipLevels)
+		throw std::runtime_error("texture without mips: " + std::string(name));
+	texture.format = selectTextureFormat(device.physicalDevice, texture.view.header->format);
+	texture.transcode = texture.format != texture.view.header->format;
+	texture.residentMip = texture.view.header->mipLevels;
+	texture.tailMip = 0;
+	while (texture.tailMip + 1 < texture.view.header->mipLevels
+		&& std::max(texture.view.mips[texture.tailMip].width, texture.view.mips[texture.tailMip].height) > tailSize)
+		texture.tailMip++;
+	texture.wantedMip = texture.tailMip;
+	texture.lastUsedFrame = frame;
+
+	textures.push_back(std::move(texture));
+	lookup.emplace(entry, static_cast<textureHandle_t>(textures.size() - 1));
+	return static_cast<textureHandle_t>(textures.size() - 1);
+}
+
+VkDescriptorImageInfo re::TextureStreamer::getDescriptorInfo(textureHandle_t handle) const
+{
+	texture_s const& texture = textures[handle];
+
+	return { sampler, texture.image ? texture.image->view : nullptr, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+}
+
+void re::TextureStreamer::update(VkCommandBuffer cmd)
+{
+	changed.clear();
+	while (!imageGraveyard.empty() && imageGraveyard.front().first + FRAMES_IN_FLIGHT <= frame)
+		imageGraveyard.pop_front();
+	while (!bufferGraveyard.empty() && bufferGraveyard.front().first + FRAMES_IN_FLIGHT <= frame)
+		bufferGraveyard.pop_front();
+
+	readFeedback();
+	reader.poll();
+	for (textureHandle_t i = 0; i < textures.size(); i++)
+		if (textures[i].loaded)
+			applyLoad(cmd, i);
+	issueLoads(cmd);
+}
+
+// the oldest buffer of the ring, written FRAMES_IN_FLIGHT frames ago, is read then cleared and written again by this frame
+void re::TextureStreamer::readFeedback(void)
+{
+	uint32_t* mips = static_cast<uint32_t*>(feedback[(frame + 1) % feedback.size()]->mapped);
+
+	for (textureHandle_t i = 0; i < textures.size(); i++) {
+		if (mips[i] == INVALID_UINT32)
+			continue;
+		textures[i].wantedMip = std::min(mips[i], textures[i].tailMip);
+		textures[i].lastUsedFrame = frame;
+	}
+	std::memset(mips, 0xff, textures.size() * sizeof(uint32_t));
+	frame++;
+}
+
+// the mip tail of new textures first, then the textures furthest from the level they are sampled at
+void re::TextureStreamer::issueLoads(VkCommandBuffer cmd)
+{
+	std::vector<textureHandle_t> candidates;
+
+	for (textureHandle_t i = 0; i < textures.size(); i++)
+		if (!textures[i].failed && textures[i].loadingMip == INVALID_UINT32 && textures[i].wantedMip < textures[i].residentMip
+			&& (!textures[i].image || isSampled(textures[i])))
+			candidates.push_back(i);
+	std::sort(candidates.begin(), candidates.end(), [this](textureHandle_t l, textureHandle_t r) {
+		bool tl = !textures[l].image, tr = !textures[r].image;
+		if (tl != tr)
+			return tl;
+		uint32_t dl = textures[l].residentMip - textures[l].wantedMip, dr = textures[r].residentMip - textures[r].wantedMip;
+		return dl != dr ? dl > dr : textures[l].lastUsedFrame > textures[r].lastUsedFrame;
+	});
+
+	for (int i = 0; i < candidates.size() && reader.getPendingCount() < maxInflightLoads; i++) {
+		texture_s& texture = textures[candidates[i]];
+		uint32_t first = texture.image ? texture.residentMip - 1 : texture.tailMip;
+		packageMip_s const& begin = texture.view.mips[first];
+		packageMip_s const& last = texture.view.mips[texture.residentMip - 1];
+		VkDeviceSize packedSize = last.offset + last.size - begin.offset;
+		VkDeviceSize size = 0;
+
+		for (uint32_t level = first; level < texture.residentMip; level++)
+			size = alignUp(size, stagingAlignment) + getLevelBytes(texture, level);
+		// the mip tail is loaded even over budget, a texture never stays without any mip
+		if (texture.image && residentBytes + loadingBytes + size > budget && !makeRoom(cmd, size, candidates[i]))
+			continue;
+
+		texture.loadingMip = first;
+		texture.staging = std::make_shared<re::Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		loadingBytes += size;
+
+		uint8_t* destination = static_cast<uint8_t*>(texture.staging->mapped);
+		if (texture.transcode) {
+			texture.compressed.resize(packedSize);
+			destination = texture.compressed.data();
+		}
+		reader.read(packageFile, texture.entry->offset + begin.offset, packedSize, destination, [this, handle = candidates[i]](bool ok) {
+			texture_s& texture = textures[handle];
+			texture.loaded = ok;
+			if (!ok) {
+				std::cerr << TERMINAL_COLOR_RED << "failed to stream " << package.getName(*texture.entry) << TERMINAL_COLOR_RESET << std::endl;
+				loadingBytes -= texture.staging->size;
+				texture.staging = nullptr;
+				texture.loadingMip = INVALID_UINT32;
+				texture.failed = true;
+			}
+		});
+	}
+}
+
+// levels that decode to RGBA8 are laid out like the package does, one after the other at stagingAlignment
+void re::TextureStreamer::applyLoad(VkCommandBuffer cmd, textureHandle_t handle)
+{
+	texture_s& texture = textures[handle];
+
+	if (texture.transcode) {
+		uint8_t* destination = static_cast<uint8_t*>(texture.staging->mapped);
+		VkDeviceSize base = texture.view.mips[texture.loadingMip].offset;
+		VkDeviceSize offset = 0;
+
+		for (uint32_t level = texture.loadingMip; level < texture.residentMip; level++) {
+			packageMip_s const& mip = texture.view.mips[level];
+			TextureData packed{ mip.width, mip.height, texture.view.header->format };
+			packed.mips.emplace_back(texture.compressed.begin() + (mip.offset - base), texture.compressed.begin() + (mip.offset - base + mip.size));
+			TextureData decoded = decompressTexture(packed);
+			offset = alignUp(offset, stagingAlignment);
+			std::memcpy(destination + offset, decoded.mips[0].data(), decoded.mips[0].size());
+			offset += decoded.mips[0].size();
+		}
+		texture.compressed = std::vector<uint8_t>();
+	}
+
+	loadingBytes -= texture.staging->size;
+	resize(cmd, texture, texture.loadingMip, texture.staging.get());
+	bufferGraveyard.push_back({ frame, std::move(texture.staging) });
+	texture.staging = nullptr;
+	texture.loadingMip = INVALID_UINT32;
+	texture.loaded = false;
+	changed.push_back(handle);
+}
+
+// a new image holding [residentMip, mipLevels), levels the old image has are copied, the finer ones come from staging
+void re::TextureStreamer::resize(VkCommandBuffer cmd, texture_s& texture, uint32_t residentMip, re::Buffer* staging)
+{
+	uint32_t mipLevels = texture.view.header->mipLevels;
+	uint32_t oldMip = texture.image ? texture.residentMip : mipLevels;
+	VkExtent2D extent = { texture.view.mips[residentMip].width, texture.view.mips[residentMip].height };
+	re::image_ptr image = std::make_shared<re::Image>(device, extent, texture.format,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, mipLevels - residentMip);
+
+	image->barrier(cmd, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	if (staging) {
+		std::vector<VkBufferImageCopy> regions;
+		VkDeviceSize offset = 0;
+		for (uint32_t level = residentMip; level < oldMip; level++) {
+			packageMip_s const& mip = texture.view.mips[level];
+			VkBufferImageCopy region{};
+			offset = alignUp(offset, stagingAlignment);
+			region.bufferOffset = offset;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - residentMip, 0, 1 };
+			region.imageExtent = { mip.width, mip.height, 1 };
+			regions.push_back(region);
+			offset += getLevelBytes(texture, level);
+		}
+		vkCmdCopyBufferToImage(cmd, staging->ptr, image->ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	}
+
+	if (texture.image) {
+		std::vector<VkImageCopy> regions;
+		for (uint32_t level = std::max(residentMip, oldMip); level < mipLevels; level++) {
+			VkImageCopy region{};
+			region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldMip, 0, 1 };
+			region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - residentMip, 0, 1 };
+			region.extent = { texture.view.mips[level].width, texture.view.mips[level].height, 1 };
+			regions.push_back(region);
+		}
+		texture.image->barrier(cmd, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		vkCmdCopyImage(cmd, texture.image->ptr, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+		// frames still in flight keep sampling the old image until their descriptors are rewritten
+		texture.image->barrier(cmd, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		imageGraveyard.push_back({ frame, std::move(texture.image) });
+	}
+
+	image->barrier(cmd, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	residentBytes -= texture.residentBytes;
+	texture.residentBytes = 0;
+	for (uint32_t level = residentMip; level < mipLevels; level++)
+		texture.residentBytes += getLevelBytes(texture, level);
+	residentBytes += texture.residentBytes;
+	texture.image = image;
+	texture.residentMip = residentMip;
+}
+
+// takes the finest mips from the least recently sampled textures first, unused textures fall back to their mip tail
+// and textures sampled last frame only give up the levels finer than the one they asked for
+bool re::TextureStreamer::makeRoom(VkCommandBuffer cmd, VkDeviceSize size, textureHandle_t requester)
+{
+	std::vector<textureHandle_t> candidates;
+
+	for (textureHandle_t i = 0; i < textures.size(); i++) {
+		texture_s const& texture = textures[i];
+		if (i == requester || !texture.image || texture.loadingMip != INVALID_UINT32)
+			continue;
+		if (texture.residentMip < (isSampled(texture) ? texture.wantedMip : texture.tailMip))
+			candidates.push_back(i);
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](textureHandle_t l, textureHandle_t r) { return textures[l].lastUsedFrame < textures[r].lastUsedFrame; });
+
+	for (int i = 0; i < candidates.size() && residentBytes + loadingBytes + size > budget; i++) {
+		texture_s& texture = textures[candidates[i]];
+		resize(cmd, texture, isSampled(texture) ? texture.wantedMip : texture.tailMip, nullptr);
+		changed.push_back(candidates[i]);
+	}
+	return residentBytes + loadingBytes + size <= budget;
+}
+
+// the feedback only covers a quarter of the pixels, a texture missing from a few frames is still treated as sampled
+bool re::TextureStreamer::isSampled(texture_s const& texture) const
+{
+	return texture.lastUsedFrame + FRAMES_IN_FLIGHT >= frame;
+}
+
+VkDeviceSize re::TextureStreamer::getLevelBytes(texture_s const& texture, uint32_t level) const
+{
+	packageMip_s const& mip = texture.view.mips[level];
+
+	return texture.transcode ? static_cast<VkDeviceSize>(mip.width) * mip.height * 4 : mip.size;
+}
@@ -0,0 +1,326 @@
+#include "Transform.hpp"
+#include <atomic>
+#include <stdexcept>
+
+// the project builds with /arch:AVX2, msvc defines __AVX__ only then
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define RE_TRANSFORM_AVX
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define RE_TRANSFORM_SSE
+#endif
+
+static constexpr size_t batchSize = 64;
+static glm::mat4 const identity(1.0f);
+
+void re::multiplyMatrices(glm::mat4* const* dst, glm::mat4 const* const* a, glm::mat4 const* b, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		float const* pa = &(*a[i])[0][0];
+		float const* pb = &b[i][0][0];
+		float* pd = &(*dst[i])[0][0];
+
+#if defined(RE_TRANSFORM_AVX)
+		__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pa + 0));
+		__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pa + 4));
+		__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pa + 8));
+		__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pa + 12));
+
+		for (int c = 0; c < 16; c += 8) {
+			__m256 col = _mm256_loadu_ps(pb + c);
+			__m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(col, col, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(col, col, _MM_SHUFFLE(1, 1, 1, 1))));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(col, col, _MM_SHUFFLE(2, 2, 2, 2))));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(col, col, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm256_storeu_ps(pd + c, r);
+		}
+#elif defined(RE_TRANSFORM_SSE)
+		__m128 a0 = _mm_loadu_ps(pa + 0);
+		__m128 a1 = _mm_loadu_ps(pa + 4);
+		__m128 a2 = _mm_loadu_ps(pa + 8);
+		__m128 a3 = _mm_loadu_ps(pa + 12);
+
+		for (int c = 0; c < 16; c += 4) {
+			__m128 col = _mm_loadu_ps(pb + c);
+			__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(col, col, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(col, col, _MM_SHUFFLE(1, 1, 1, 1))));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(col, col, _MM_SHUFFLE(2, 2, 2, 2))));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(col, col, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(pd + c, r);
+		}
+#else
+		*dst[i] = *a[i] * b[i];
+#endif
+	}
+}
+
+re::transform_t re::TransformSystem::create(transform_t parent)
+{
+	transform_t transform;
+
+	if (!freeHandles.empty()) {
+		transform = *freeHandles.rbegin();
+		freeHandles.pop_back();
+	}
+	else {
+		transform = static_cast<transform_t>(slots.size());
+		slots.push_back(INVALID_UINT32);
+		parents.push_back(INVALID_UINT32);
+		childCounts.push_back(0);
+	}
+
+	slots[transform] = static_cast<uint32_t>(handles.size());
+	parents[transform] = INVALID_UINT32;
+	childCounts[transform] = 0;
+
+	handles.push_back(transform);
+	parentSlots.push_back(INVALID_UINT32);
+	positions.push_back(glm::vec3(0.0f));
+	rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	scales.push_back(glm::vec3(1.0f));
+	flags.push_back(FLAG_DIRTY);
+	stamps.push_back(0);
+	worlds.push_back(identity);
+	dirtyCount++;
+	orderDirty = true;
+
+	if (parent != INVALID_UINT32)
+		setParent(transform, parent);
+	return transform;
+}
+
+void re::TransformSystem::destroy(transform_t transform)
+{
+	transform_t parent = parents[transform];
+
+	if (childCounts[transform]) {
+		for (transform_t i = 0; i < parents.size(); i++) {
+			if (parents[i] == transform) {
+				parents[i] = parent;
+				if (parent != INVALID_UINT32)
+					childCounts[parent]++;
+				markDirty(i);
+			}
+		}
+	}
+	if (parent != INVALID_UINT32)
+		childCounts[parent]--;
+
+	handles[slots[transform]] = INVALID_UINT32;
+	slots[transform] = INVALID_UINT32;
+	parents[transform] = INVALID_UINT32;
+	childCounts[transform] = 0;
+	freeHandles.push_back(transform);
+	orderDirty = true;
+}
+
+void re::TransformSystem::setParent(transform_t transform, transform_t parent)
+{
+	for (transform_t i = parent; i != INVALID_UINT32; i = parents[i])
+		if (i == transform)
+			throw std::runtime_error("transform hierarchy cycle");
+
+	if (parents[transform] != INVALID_UINT32)
+		childCounts[parents[transform]]--;
+	if (parent != INVALID_UINT32)
+		childCounts[parent]++;
+
+	parents[transform] = parent;
+	markDirty(transform);
+	orderDirty = true;
+}
+
+void re::TransformSystem::setPosition(transform_t transform, glm::vec3 const& position)
+{
+	positions[slots[transform]] = position;
+	markDirty(transform);
+}
+
+void re::TransformSystem::setRotation(transform_t transform, glm::quat const& rotation)
+{
+	rotations[slots[transform]] = rotation;
+	markDirty(transform);
+}
+
+void re::TransformSystem::setScale(transform_t transform, glm::vec3 const& scale)
+{
+	scales[slots[transform]] = scale;
+	markDirty(transform);
+}
+
+void re::TransformSystem::setStatic(transform_t transform, bool value)
+{
+	uint8_t& flag = flags[slots[transform]];
+
+	if (!!(flag & FLAG_STATIC) == value)
+		return;
+	if (value && (flag & FLAG_DIRTY))
+		staticDirtyCount++;
+	flag = value ? (flag | FLAG_STATIC) : (flag & ~FLAG_STATIC);
+	orderDirty = true;
+}
+
+void re::TransformSystem::markDirty(transform_t transform)
+{
+	uint8_t& flag = flags[slots[transform]];
+
+	if (flag & FLAG_DIRTY)
+		return;
+	flag |= FLAG_DIRTY;
+	dirtyCount++;
+	if (flag & FLAG_STATIC)
+		staticDirtyCount++;
+}
+
+// a node is only treated as static when its whole ancestor chain is, static nodes go last in each level
+void re::TransformSystem::sortByDepth(void)
+{
+	std::vector<uint32_t> depth(slots.size(), INVALID_UINT32);
+	std::vector<uint8_t> fixed(slots.size(), 0);
+	std::vector<transform_t> chain;
+	uint32_t maxDepth = 0;
+
+	for (transform_t h = 0; h < slots.size(); h++) {
+		if (slots[h] == INVALID_UINT32 || depth[h] != INVALID_UINT32)
+			continue;
+		for (transform_t i = h; i != INVALID_UINT32 && depth[i] == INVALID_UINT32; i = parents[i])
+			chain.push_back(i);
+		while (!chain.empty()) {
+			transform_t i = *chain.rbegin();
+			transform_t p = parents[i];
+			bool isStatic = flags[slots[i]] & FLAG_STATIC;
+			depth[i] = p == INVALID_UINT32 ? 0 : depth[p] + 1;
+			fixed[i] = isStatic && (p == INVALID_UINT32 || fixed[p]);
+			maxDepth = std::max(maxDepth, depth[i]);
+			chain.pop_back();
+		}
+	}
+
+	std::vector<uint32_t> counts((maxDepth + 1) * 2, 0);
+	for (transform_t h = 0; h < slots.size(); h++)
+		if (slots[h] != INVALID_UINT32)
+			counts[depth[h] * 2 + fixed[h]]++;
+
+	levels.resize(maxDepth + 1);
+	std::vector<uint32_t> cursor(counts.size());
+	uint32_t offset = 0;
+	for (uint32_t d = 0; d <= maxDepth; d++) {
+		levels[d].begin = offset;
+		cursor[d * 2] = offset;
+		offset += counts[d * 2];
+		levels[d].staticBegin = offset;
+		cursor[d * 2 + 1] = offset;
+		offset += counts[d * 2 + 1];
+		levels[d].end = offset;
+	}
+	if (slots.empty() || offset == 0)
+		levels.clear();
+
+	std::vector<transform_t> newHandles(offset);
+	std::vector<uint32_t> newSlots(slots.size(), INVALID_UINT32);
+	for (transform_t h = 0; h < slots.size(); h++) {
+		if (slots[h] == INVALID_UINT32)
+			continue;
+		uint32_t slot = cursor[depth[h] * 2 + fixed[h]]++;
+		newHandles[slot] = h;
+		newSlots[h] = slot;
+	}
+
+	std::vector<uint32_t> newParentSlots(offset);
+	std::vector<glm::vec3> newPositions(offset);
+	std::vector<glm::quat> newRotations(offset);
+	std::vector<glm::vec3> newScales(offset);
+	std::vector<uint8_t> newFlags(offset);
+	std::vector<uint32_t> newStamps(offset, 0);
+	std::vector<glm::mat4> newWorlds(offset);
+
+	for (uint32_t slot = 0; slot < offset; slot++) {
+		transform_t h = newHandles[slot];
+		uint32_t old = slots[h];
+		newParentSlots[slot] = parents[h] == INVALID_UINT32 ? INVALID_UINT32 : newSlots[parents[h]];
+		newPositions[slot] = positions[old];
+		newRotations[slot] = rotations[old];
+		newScales[slot] = scales[old];
+		newFlags[slot] = flags[old];
+		newWorlds[slot] = worlds[old];
+	}
+
+	handles.swap(newHandles);
+	slots.swap(newSlots);
+	parentSlots.swap(newParentSlots);
+	positions.swap(newPositions);
+	rotations.swap(newRotations);
+	scales.swap(newScales);
+	flags.swap(newFlags);
+	stamps.swap(newStamps);
+	worlds.swap(newWorlds);
+	frame = 0;
+	orderDirty = false;
+}
+
+void re::TransformSystem::update(re::JobSystem& jobs)
+{
+	updatedCount = 0;
+
+	if (orderDirty)
+		sortByDepth();
+	if (!dirtyCount)
+		return;
+
+	std::atomic<size_t> updated{ 0 };
+	bool includeStatic = staticDirtyCount > 0;
+	frame++;
+
+	for (int i = 0; i < levels.size(); i++) {
+		uint32_t begin = levels[i].begin;
+		uint32_t end = includeStatic ? levels[i].end : levels[i].staticBegin;
+
+		jobs.parallelFor(end - begin, 4096, [&](size_t first, size_t last) {
+			updated.fetch_add(updateRange(begin + first, begin + last), std::memory_order_relaxed);
+		});
+	}
+
+	updatedCount = updated;
+	dirtyCount = 0;
+	staticDirtyCount = 0;
+}
+
+size_t re::TransformSystem::updateRange(size_t begin, size_t end)
+{
+	glm::mat4 locals[batchSize];
+	glm::mat4 const* parentWorlds[batchSize];
+	glm::mat4* outputs[batchSize];
+	size_t count = 0;
+	size_t total = 0;
+
+	for (size_t i = begin; i < end; i++) {
+		uint32_t parent = parentSlots[i];
+		bool parentUpdated = parent != INVALID_UINT32 && stamps[parent] == frame;
+
+		if (!(flags[i] & FLAG_DIRTY) && !parentUpdated)
+			continue;
+
+		glm::mat3 r = glm::mat3_cast(rotations[i]);
+		glm::mat4& local = locals[count];
+		local[0] = glm::vec4(r[0] * scales[i].x, 0.0f);
+		local[1] = glm::vec4(r[1] * scales[i].y, 0.0f);
+		local[2] = glm::vec4(r[2] * scales[i].z, 0.0f);
+		local[3] = glm::vec4(positions[i], 1.0f);
+
+		parentWorlds[count] = parent == INVALID_UINT32 ? &identity : &worlds[parent];
+		outputs[count] = &worlds[i];
+		flags[i] &= ~FLAG_DIRTY;
+		stamps[i] = frame;
+		total++;
+
+		if (++count == batchSize) {
+			multiplyMatrices(outputs, parentWorlds, locals, count);
+			count = 0;
+		}
+	}
+
+	if (count)
+		multiplyMatrices(outputs, parentWorlds, locals, count);
+	return total;
+}
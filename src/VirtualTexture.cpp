@@ -0,0 +1,595 @@
+#include "VirtualTexture.hpp"
+#include "TextureCompression.hpp"
+#include "CommandPool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+static constexpr uint32_t maxInflightLoads = 16;
+
+static void imageBarrier(VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+
+	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+re::VirtualTexture::VirtualTexture(re::Device& device, re::Package& package, std::string_view name, VkDeviceSize budget, bool allowSparse)
+	: device(device), package(package)
+{
+	entry = package.find(name);
+	if (!entry)
+		throw std::runtime_error("unknown virtual texture: " + std::string(name));
+
+	source = package.getVirtualTexture(*entry);
+	if (!source.header->mipLevels || source.header->mipLevels > VIRTUAL_TEXTURE_MAX_MIPS)
+		throw std::runtime_error("unsupported virtual texture mip count: " + std::string(name));
+	format = selectTextureFormat(device.physicalDevice, source.header->format);
+	transcode = format != source.header->format;
+	content = source.header->tileSize - 2 * source.header->border;
+	pages.resize(source.header->tileCount);
+
+	if (!allowSparse || !createSparseImage(budget))
+		createCache(budget);
+
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = sparse ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = samplerInfo.addressModeU;
+	samplerInfo.addressModeW = samplerInfo.addressModeU;
+	samplerInfo.maxLod = sparse ? VK_LOD_CLAMP_NONE : 0.0f;
+
+	if (vkCreateSampler(device.ptr, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		throw std::runtime_error("failed to create sampler");
+
+	virtualTextureInfo_s info{};
+	info.size = glm::uvec2(source.header->width, source.header->height);
+	info.mipLevels = source.header->mipLevels;
+	info.tileSize = source.header->tileSize;
+	info.border = source.header->border;
+	info.cacheTiles = cacheTiles;
+	for (uint32_t i = 0; i < source.header->mipLevels; i++)
+		info.mips[i] = glm::uvec4(source.mips[i].firstTile, source.mips[i].pagesX, source.mips[i].pagesY, 0);
+	infoBuffer = std::make_shared<re::Buffer>(device, sizeof(info), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	infoBuffer->upload(&info, sizeof(info));
+
+	VkDeviceSize pageTableSize = (sparse ? source.mips[0].pagesX * source.mips[0].pagesY : pages.size()) * sizeof(uint32_t);
+	for (uint64_t i = 0; i < FRAMES_IN_FLIGHT; i++) {
+		pageTables.push_back(std::make_shared<re::Buffer>(device, pageTableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		feedback.push_back(std::make_shared<re::Buffer>(device, pages.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		std::memset(feedback[i]->mapped, 0, pages.size() * sizeof(uint32_t));
+	}
+	pageTableVersions.resize(FRAMES_IN_FLIGHT, 0);
+
+	staging = std::make_shared<re::Buffer>(device, maxInflightLoads * getTileBytes(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	loads.resize(maxInflightLoads);
+	for (uint32_t i = maxInflightLoads; i > 0; i--)
+		freeStagingSlots.push_back(i - 1);
+
+	// the coarsest mip, and with a sparse image the whole mip tail, is what every other page falls back to
+	for (uint32_t i = 0; i < pages.size(); i++) {
+		uint32_t mip, x, y;
+		getPageCoords(i, mip, x, y);
+		pages[i].pinned = mip + 1 == source.header->mipLevels || (sparse && mip >= mipTailFirstLod);
+	}
+	packageFile = reader.open(package.getPath());
+}
+
+re::VirtualTexture::~VirtualTexture(void)
+{
+	while (reader.getPendingCount())
+		reader.poll();
+	vkDestroySampler(device.ptr, sampler, nullptr);
+	if (sparse) {
+		vkDestroyImageView(device.ptr, view, nullptr);
+		vkDestroyImage(device.ptr, image, nullptr);
+		vkFreeMemory(device.ptr, memory, nullptr);
+		if (tailMemory)
+			vkFreeMemory(device.ptr, tailMemory, nullptr);
+	}
+}
+
+// a square of tiles as large as the budget allows, a slot index is y * cacheTiles + x
+void re::VirtualTexture::createCache(VkDeviceSize budget)
+{
+	uint32_t tileSize = source.header->tileSize;
+	uint32_t maxTiles = std::min(device.physicalDevice.properties.limits.maxImageDimension2D / tileSize, 256u);
+
+	cacheTiles = static_cast<uint32_t>(std::sqrt(static_cast<double>(budget / getTileBytes())));
+	cacheTiles = std::clamp(cacheTiles, 2u, maxTiles);
+	cache = std::make_shared<re::Image>(device, VkExtent2D{ cacheTiles * tileSize, cacheTiles * tileSize }, format,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	image = cache->ptr;
+	view = cache->view;
+
+	for (uint32_t i = cacheTiles * cacheTiles; i > 0; i--)
+		freeSlots.push_back(i - 1);
+}
+
+// the budget becomes a pool of sparse blocks, a slot is a block sized offset in that memory
+bool re::VirtualTexture::createSparseImage(VkDeviceSize budget)
+{
+	VkPhysicalDevice physicalDevice = device.physicalDevice.ptr;
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	uint32_t count = 0;
+
+	if (!device.enabledFeatures.features.sparseBinding || !device.enabledFeatures.features.sparseResidencyImage2D)
+		return false;
+	if (!(device.physicalDevice.queueFamilyProperties[device.physicalDevice.queueFamily.graphics].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT))
+		return false;
+	vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice, format, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT, usage, VK_IMAGE_TILING_OPTIMAL, &count, nullptr);
+	if (!count)
+		return false;
+
+	VkImageCreateInfo createInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	createInfo.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = format;
+	createInfo.extent = { source.header->width, source.header->height, 1 };
+	createInfo.mipLevels = source.header->mipLevels;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(device.ptr, &createInfo, nullptr, &image) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	std::vector<VkSparseImageMemoryRequirements> sparseRequirements;
+	vkGetImageMemoryRequirements(device.ptr, image, &requirements);
+	vkGetImageSparseMemoryRequirements(device.ptr, image, &count, nullptr);
+	sparseRequirements.resize(count);
+	vkGetImageSparseMemoryRequirements(device.ptr, image, &count, sparseRequirements.data());
+
+	auto color = std::find_if(sparseRequirements.begin(), sparseRequirements.end(), [](VkSparseImageMemoryRequirements const& r) {
+		return r.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT;
+	});
+	if (color == sparseRequirements.end() || !color->formatProperties.imageGranularity.width) {
+		vkDestroyImage(device.ptr, image, nullptr);
+		image = nullptr;
+		return false;
+	}
+	sparseGranularity = color->formatProperties.imageGranularity;
+	mipTailFirstLod = color->imageMipTailFirstLod;
+	blockSize = requirements.alignment;
+
+	uint32_t blocks = static_cast<uint32_t>(std::max<VkDeviceSize>(budget / blockSize, 1));
+	VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	allocInfo.allocationSize = blocks * blockSize;
+	allocInfo.memoryTypeIndex = device.physicalDevice.findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (vkAllocateMemory(device.ptr, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate virtual texture memory");
+
+	if (mipTailFirstLod < source.header->mipLevels && color->imageMipTailSize) {
+		allocInfo.allocationSize = color->imageMipTailSize;
+		if (vkAllocateMemory(device.ptr, &allocInfo, nullptr, &tailMemory) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate virtual texture memory");
+		pendingOpaqueBinds.push_back({ color->imageMipTailOffset, color->imageMipTailSize, tailMemory, 0, 0 });
+	}
+	for (uint32_t i = blocks; i > 0; i--)
+		freeSlots.push_back(i - 1);
+
+	VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, source.header->mipLevels, 0, 1 };
+	if (vkCreateImageView(device.ptr, &viewInfo, nullptr, &view) != VK_SUCCESS)
+		throw std::runtime_error("failed to create ImageView");
+
+	sparse = true;
+	flushBinds();
+	return true;
+}
+
+void re::VirtualTexture::update(VkCommandBuffer cmd)
+{
+	retire();
+	readFeedback();
+	reader.poll();
+	applyLoads(cmd);
+	issueLoads();
+	writePageTable();
+}
+
+// every slot, staging slot and sparse block released FRAMES_IN_FLIGHT frames ago is no longer read by the GPU
+void re::VirtualTexture::retire(void)
+{
+	while (!slotGraveyard.empty() && slotGraveyard.front().first + FRAMES_IN_FLIGHT <= frame) {
+		freeSlots.push_back(slotGraveyard.front().second);
+		slotGraveyard.pop_front();
+	}
+	while (!stagingGraveyard.empty() && stagingGraveyard.front().first + FRAMES_IN_FLIGHT <= frame) {
+		freeStagingSlots.push_back(stagingGraveyard.front().second);
+		stagingGraveyard.pop_front();
+	}
+	while (!unbindQueue.empty() && unbindQueue.front().first + FRAMES_IN_FLIGHT <= frame) {
+		VkSparseImageMemoryBind const& bind = unbindQueue.front().second;
+		// a block bound again in the meantime keeps its new memory
+		if (!sparseBlocks.count({ bind.subresource.mipLevel, bind.offset.x / sparseGranularity.width, bind.offset.y / sparseGranularity.height }))
+			pendingBinds.push_back(bind);
+		unbindQueue.pop_front();
+	}
+}
+
+// a sampled page keeps its ancestors alive, they are what it falls back to
+// the oldest buffer of the ring, written FRAMES_IN_FLIGHT frames ago, is read then cleared and written again by this frame
+void re::VirtualTexture::readFeedback(void)
+{
+	uint32_t* used = static_cast<uint32_t*>(feedback[(frame + 1) % feedback.size()]->mapped);
+
+	for (uint32_t i = 0; i < pages.size(); i++)
+		for (uint32_t page = used[i] ? i : INVALID_UINT32; page != INVALID_UINT32 && pages[page].lastUsedFrame != frame + 1; page = getParent(page))
+			pages[page].lastUsedFrame = frame + 1;
+	std::memset(used, 0, pages.size() * sizeof(uint32_t));
+	frame++;
+}
+
+// pinned pages first, then the coarsest mips so a page always has a resident parent to fall back to
+void re::VirtualTexture::issueLoads(void)
+{
+	std::vector<uint32_t> candidates;
+
+	for (uint32_t i = 0; i < pages.size(); i++) {
+		page_s const& page = pages[i];
+		bool wanted = page.pinned || (page.lastUsedFrame && page.lastUsedFrame + FRAMES_IN_FLIGHT >= frame);
+		if (wanted && !page.failed && !page.loading && page.slot == INVALID_UINT32)
+			candidates.push_back(i);
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](uint32_t l, uint32_t r) {
+		uint32_t ml, mr, x, y;
+		getPageCoords(l, ml, x, y);
+		getPageCoords(r, mr, x, y);
+		if (pages[l].pinned != pages[r].pinned)
+			return pages[l].pinned;
+		return ml != mr ? ml > mr : pages[l].lastUsedFrame > pages[r].lastUsedFrame;
+	});
+
+	// a full cache makes room for every load the staging slots allow at once, minus the slots already coming back
+	uint32_t needed = 0;
+	for (int i = 0, loadable = 0; i < candidates.size() && loadable < freeStagingSlots.size(); i++) {
+		uint32_t parent = getParent(candidates[i]);
+		if (parent != INVALID_UINT32 && !isResident(parent))
+			continue;
+		needed += getSlotsNeeded(candidates[i]);
+		loadable++;
+	}
+	size_t available = freeSlots.size() + slotGraveyard.size();
+	if (needed > available)
+		evict(static_cast<uint32_t>(needed - available));
+
+	for (int i = 0; i < candidates.size() && !freeStagingSlots.empty(); i++) {
+		uint32_t index = candidates[i];
+		uint32_t parent = getParent(index);
+
+		if (parent != INVALID_UINT32 && !isResident(parent))
+			continue;
+		if (!reserve(index))
+			break;
+
+		load_s& load = loads[freeStagingSlots.back()];
+		load.page = index;
+		load.stagingSlot = freeStagingSlots.back();
+		load.active = true;
+		load.done = false;
+		freeStagingSlots.pop_back();
+		pages[index].loading = true;
+
+		packageTile_s const& tile = source.tiles[index];
+		uint8_t* destination = static_cast<uint8_t*>(staging->mapped) + load.stagingSlot * getTileBytes();
+		if (transcode) {
+			load.compressed.resize(tile.size);
+			destination = load.compressed.data();
+		}
+		reader.read(packageFile, entry->offset + tile.offset, tile.size, destination, [this, slot = load.stagingSlot](bool ok) {
+			loads[slot].done = true;
+			loads[slot].ok = ok;
+		});
+	}
+}
+
+// a cache slot, or every sparse block the page touches that is not bound yet
+bool re::VirtualTexture::reserve(uint32_t page)
+{
+	if (!sparse) {
+		if (freeSlots.empty())
+			return false;
+		pages[page].slot = freeSlots.back();
+		freeSlots.pop_back();
+		return true;
+	}
+
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> blocks = getBlocks(page);
+	if (getSlotsNeeded(page) > freeSlots.size())
+		return false;
+
+	for (int i = 0; i < blocks.size(); i++) {
+		auto it = sparseBlocks.find(blocks[i]);
+		if (it != sparseBlocks.end()) {
+			it->second.references++;
+			continue;
+		}
+
+		auto [mip, bx, by] = blocks[i];
+		VkSparseImageMemoryBind bind{};
+		bind.subresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0 };
+		bind.offset = { static_cast<int32_t>(bx * sparseGranularity.width), static_cast<int32_t>(by * sparseGranularity.height), 0 };
+		bind.extent = { std::min(sparseGranularity.width, source.mips[mip].width - bx * sparseGranularity.width),
+			std::min(sparseGranularity.height, source.mips[mip].height - by * sparseGranularity.height), 1 };
+		bind.memory = memory;
+		bind.memoryOffset = freeSlots.back() * blockSize;
+		pendingBinds.push_back(bind);
+		sparseBlocks[blocks[i]] = { freeSlots.back(), 1 };
+		freeSlots.pop_back();
+	}
+	pages[page].slot = 0;
+	return true;
+}
+
+// the GPU may still sample what the page used, the memory comes back through the graveyards
+void re::VirtualTexture::release(uint32_t page)
+{
+	if (!sparse)
+		slotGraveyard.push_back({ frame, pages[page].slot });
+
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> blocks = sparse ? getBlocks(page) : std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>();
+	for (int i = 0; i < blocks.size(); i++) {
+		auto it = sparseBlocks.find(blocks[i]);
+		if (--it->second.references)
+			continue;
+
+		auto [mip, bx, by] = blocks[i];
+		VkSparseImageMemoryBind unbind{};
+		unbind.subresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0 };
+		unbind.offset = { static_cast<int32_t>(bx * sparseGranularity.width), static_cast<int32_t>(by * sparseGranularity.height), 0 };
+		unbind.extent = { std::min(sparseGranularity.width, source.mips[mip].width - bx * sparseGranularity.width),
+			std::min(sparseGranularity.height, source.mips[mip].height - by * sparseGranularity.height), 1 };
+		unbindQueue.push_back({ frame, unbind });
+		slotGraveyard.push_back({ frame, it->second.memorySlot });
+		sparseBlocks.erase(it);
+	}
+	pages[page].slot = INVALID_UINT32;
+}
+
+// one cache slot, or the sparse blocks of the page that are not bound yet
+uint32_t re::VirtualTexture::getSlotsNeeded(uint32_t page) const
+{
+	if (!sparse)
+		return 1;
+
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> blocks = getBlocks(page);
+	uint32_t missing = 0;
+	for (int i = 0; i < blocks.size(); i++)
+		missing += !sparseBlocks.count(blocks[i]);
+	return missing;
+}
+
+// the least recently sampled pages that were not sampled for FRAMES_IN_FLIGHT frames, finer mips first among equally old ones
+uint32_t re::VirtualTexture::evict(uint32_t count)
+{
+	std::vector<uint32_t> victims;
+
+	for (uint32_t i = 0; i < pages.size(); i++) {
+		page_s const& page = pages[i];
+		if (!page.pinned && isResident(i) && page.lastUsedFrame + FRAMES_IN_FLIGHT < frame)
+			victims.push_back(i);
+	}
+	count = std::min(count, static_cast<uint32_t>(victims.size()));
+	std::partial_sort(victims.begin(), victims.begin() + count, victims.end(), [this](uint32_t l, uint32_t r) {
+		if (pages[l].lastUsedFrame != pages[r].lastUsedFrame)
+			return pages[l].lastUsedFrame < pages[r].lastUsedFrame;
+		uint32_t ml, mr, x, y;
+		getPageCoords(l, ml, x, y);
+		getPageCoords(r, mr, x, y);
+		return ml < mr;
+	});
+
+	for (uint32_t i = 0; i < count; i++)
+		release(victims[i]);
+	if (count) {
+		residentPages -= count;
+		pageTableVersion++;
+	}
+	return count;
+}
+
+void re::VirtualTexture::applyLoads(VkCommandBuffer cmd)
+{
+	std::vector<VkBufferImageCopy> regions;
+	uint32_t tileSize = source.header->tileSize;
+	uint32_t border = source.header->border;
+	VkDeviceSize tileBytes = getTileBytes();
+
+	for (int i = 0; i < loads.size(); i++) {
+		load_s& load = loads[i];
+		page_s& page = pages[load.page];
+		if (!load.active || !load.done)
+			continue;
+
+		load.active = false;
+		page.loading = false;
+		stagingGraveyard.push_back({ frame, load.stagingSlot });
+		if (!load.ok) {
+			std::cerr << TERMINAL_COLOR_RED << "failed to stream a page of " << package.getName(*entry) << TERMINAL_COLOR_RESET << std::endl;
+			release(load.page);
+			page.failed = true;
+			continue;
+		}
+
+		uint8_t* destination = static_cast<uint8_t*>(staging->mapped) + load.stagingSlot * tileBytes;
+		if (transcode) {
+			TextureData tile{ tileSize, tileSize, source.header->format };
+			tile.mips.push_back(std::move(load.compressed));
+			std::vector<uint8_t> decoded = decompressTexture(tile).mips[0];
+			std::memcpy(destination, decoded.data(), decoded.size());
+			load.compressed = std::vector<uint8_t>();
+		}
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = load.stagingSlot * tileBytes;
+		region.bufferRowLength = tileSize;
+		region.bufferImageHeight = tileSize;
+		if (sparse) {
+			// only the inside of the tile, the image filters across pages by itself
+			uint32_t mip, x, y;
+			getPageCoords(load.page, mip, x, y);
+			uint32_t blockBytes = isBlockCompressed(format) ? getBlockBytes(format) : 4;
+			uint32_t blockTexels = isBlockCompressed(format) ? 4 : 1;
+			region.bufferOffset += (border / blockTexels * (tileSize / blockTexels) + border / blockTexels) * blockBytes;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1 };
+			region.imageOffset = { static_cast<int32_t>(x * content), static_cast<int32_t>(y * content), 0 };
+			region.imageExtent = { std::min(content, source.mips[mip].width - x * content), std::min(content, source.mips[mip].height - y * content), 1 };
+		}
+		else {
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageOffset = { static_cast<int32_t>(page.slot % cacheTiles * tileSize), static_cast<int32_t>(page.slot / cacheTiles * tileSize), 0 };
+			region.imageExtent = { tileSize, tileSize, 1 };
+		}
+		regions.push_back(region);
+		residentPages++;
+		pageTableVersion++;
+	}
+
+	// binds have to land before the copies, the fence wait keeps the ordering without a semaphore into the frame
+	flushBinds();
+	if (initialized && regions.empty())
+		return;
+
+	imageBarrier(cmd, image, initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	if (!regions.empty())
+		vkCmdCopyBufferToImage(cmd, staging->ptr, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	imageBarrier(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	initialized = true;
+}
+
+void re::VirtualTexture::flushBinds(void)
+{
+	if (pendingBinds.empty() && pendingOpaqueBinds.empty())
+		return;
+
+	VkSparseImageMemoryBindInfo imageBinds{ image, static_cast<uint32_t>(pendingBinds.size()), pendingBinds.data() };
+	VkSparseImageOpaqueMemoryBindInfo opaqueBinds{ image, static_cast<uint32_t>(pendingOpaqueBinds.size()), pendingOpaqueBinds.data() };
+	VkBindSparseInfo bindInfo{ VK_STRUCTURE_TYPE_BIND_SPARSE_INFO };
+	bindInfo.imageBindCount = pendingBinds.empty() ? 0 : 1;
+	bindInfo.pImageBinds = &imageBinds;
+	bindInfo.imageOpaqueBindCount = pendingOpaqueBinds.empty() ? 0 : 1;
+	bindInfo.pImageOpaqueBinds = &opaqueBinds;
+
+	re::Fence fence(device);
+	if (vkQueueBindSparse(device.queueHandles.graphics, 1, &bindInfo, fence.ptr) != VK_SUCCESS)
+		throw std::runtime_error("failed to bind virtual texture memory");
+	fence.wait();
+	pendingBinds.clear();
+	pendingOpaqueBinds.clear();
+}
+
+// software: slot x | slot y << 8 | mip << 16 of the finest resident page at or above every page, 0xffffffff when none is
+// sparse: the finest mip resident from the coarsest down to every mip 0 page, mipLevels when none is
+void re::VirtualTexture::writePageTable(void)
+{
+	uint32_t& version = pageTableVersions[frame % pageTableVersions.size()];
+	uint32_t* table = static_cast<uint32_t*>(getPageTable().mapped);
+	uint32_t mipLevels = source.header->mipLevels;
+
+	if (version == pageTableVersion)
+		return;
+	version = pageTableVersion;
+
+	if (!sparse) {
+		for (uint32_t i = 0; i < pages.size(); i++) {
+			uint32_t page = i;
+			while (page != INVALID_UINT32 && !isResident(page))
+				page = getParent(page);
+			if (page == INVALID_UINT32) {
+				table[i] = INVALID_UINT32;
+				continue;
+			}
+			uint32_t mip, x, y;
+			getPageCoords(page, mip, x, y);
+			table[i] = pages[page].slot % cacheTiles | pages[page].slot / cacheTiles << 8 | mip << 16;
+		}
+		return;
+	}
+
+	for (uint32_t y = 0; y < source.mips[0].pagesY; y++) {
+		for (uint32_t x = 0; x < source.mips[0].pagesX; x++) {
+			uint32_t resident = mipLevels;
+			for (uint32_t mip = mipLevels; mip > 0; mip--) {
+				packageVirtualMip_s const& level = source.mips[mip - 1];
+				uint32_t px = std::min(x >> (mip - 1), level.pagesX - 1), py = std::min(y >> (mip - 1), level.pagesY - 1);
+				if (!isResident(level.firstTile + py * level.pagesX + px))
+					break;
+				resident = mip - 1;
+			}
+			table[y * source.mips[0].pagesX + x] = resident;
+		}
+	}
+}
+
+void re::VirtualTexture::getPageCoords(uint32_t page, uint32_t& mip, uint32_t& x, uint32_t& y) const
+{
+	mip = 0;
+	while (mip + 1 < source.header->mipLevels && source.mips[mip + 1].firstTile <= page)
+		mip++;
+	x = (page - source.mips[mip].firstTile) % source.mips[mip].pagesX;
+	y = (page - source.mips[mip].firstTile) / source.mips[mip].pagesX;
+}
+
+// a page of the next mip covers exactly 2x2 pages of this one
+uint32_t re::VirtualTexture::getParent(uint32_t page) const
+{
+	uint32_t mip, x, y;
+
+	getPageCoords(page, mip, x, y);
+	if (mip + 1 >= source.header->mipLevels)
+		return INVALID_UINT32;
+	packageVirtualMip_s const& parent = source.mips[mip + 1];
+	return parent.firstTile + std::min(y / 2, parent.pagesY - 1) * parent.pagesX + std::min(x / 2, parent.pagesX - 1);
+}
+
+// sparse blocks under the texels of a page, none for pages in the mip tail which is bound once
+std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> re::VirtualTexture::getBlocks(uint32_t page) const
+{
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> blocks;
+	uint32_t mip, x, y;
+
+	getPageCoords(page, mip, x, y);
+	if (mip >= mipTailFirstLod)
+		return blocks;
+
+	uint32_t x0 = x * content, y0 = y * content;
+	uint32_t x1 = std::min(x0 + content, source.mips[mip].width), y1 = std::min(y0 + content, source.mips[mip].height);
+	for (uint32_t by = y0 / sparseGranularity.height; by <= (y1 - 1) / sparseGranularity.height; by++)
+		for (uint32_t bx = x0 / sparseGranularity.width; bx <= (x1 - 1) / sparseGranularity.width; bx++)
+			blocks.push_back({ mip, bx, by });
+	return blocks;
+}
+
+VkDeviceSize re::VirtualTexture::getTileBytes(void) const
+{
+	uint32_t tileSize = source.header->tileSize;
+
+	return transcode ? static_cast<VkDeviceSize>(tileSize) * tileSize * 4 : source.tiles[0].size;
+}
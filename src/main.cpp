@@ -1,12 +1,26 @@
 #include <iostream>
 #include "RathalosEngine.hpp"
+#include "Package.hpp"
+#include "Bench.hpp"
 
 int start(int ac, char** av)
 {
+    // RathalosEngine pack <output.rpak> <assets...>
+    if (ac >= 3 && std::string(av[1]) == "pack") {
+        re::packAssets(av[2], std::vector<std::string>(av + 3, av + ac));
+        return 0;
+    }
+    // RathalosEngine bench <name>
+    if (ac == 3 && std::string(av[1]) == "bench") {
+        re::runBenchmark(av[2]);
+        return 0;
+    }
+
     re::RathalosEngine engine;
 
     while (engine.window.open()) {
        engine.window.pollEvents();
+       engine.frameArena.reset();
     }
 
     return 0;